@@ -651,6 +651,23 @@ static int show_stmt_block_named(ivl_statement_t net, ivl_scope_t scope)
 }
 
 
+/*
+ * Can this case guard be compared with a %cmpi/u instruction?
+ */
+static int case_item_is_immediate(ivl_statement_t net, ivl_expr_t cex)
+{
+      return (ivl_statement_type(net) == IVL_ST_CASE)
+	    && (ivl_expr_type(cex) == IVL_EX_NUMBER)
+	    && (! number_is_unknown(cex))
+	    && number_is_immediate(cex, 16, 0);
+}
+
+/*
+ * Runs of at least this many immediate case guards are dispatched by
+ * a %case/u table instead of by the compares alone.
+ */
+# define CASE_TABLE_MIN 4
+
 static int show_stmt_case(ivl_statement_t net, ivl_scope_t sscope)
 {
       int rc = 0;
@@ -661,6 +678,7 @@ static int show_stmt_case(ivl_statement_t net, ivl_scope_t sscope)
       unsigned local_base = local_count;
 
       unsigned idx, default_case;
+      unsigned table_end = 0;
 
       show_stmt_file_line(net, "Case statement.");
 
@@ -683,13 +701,30 @@ static int show_stmt_case(ivl_statement_t net, ivl_scope_t sscope)
 	      /* Is the guard expression something I can pass to a
 		 %cmpi/u instruction? If so, use that instead. */
 
-	    if ((ivl_statement_type(net) == IVL_ST_CASE)
-		&& (ivl_expr_type(cex) == IVL_EX_NUMBER)
-		&& (! number_is_unknown(cex))
-		&& number_is_immediate(cex, 16, 0)) {
+	    if (case_item_is_immediate(net, cex)) {
 
 		  unsigned long imm = get_number_immediate(cex);
 
+		    /* If this starts a long enough run of immediate
+		       guards, put a %case/u table in front of their
+		       compares. The table preserves the first match
+		       order, since a miss continues after the run. */
+		  if (idx >= table_end && cond.wid <= IMM_WID) {
+			unsigned run = 0;
+			for (table_end = idx ; table_end < count
+				   ; table_end += 1) {
+			      ivl_expr_t tex = ivl_stmt_case_expr(net, table_end);
+			      if (tex == 0)
+				    continue;
+			      if (! case_item_is_immediate(net, tex))
+				    break;
+			      run += 1;
+			}
+			if (run >= CASE_TABLE_MIN)
+			      fprintf(vvp_out, "    %%case/u %u, %u, %u;\n",
+				      cond.base, run, cond.wid);
+		  }
+
 		  fprintf(vvp_out, "    %%cmpi/u %u, %lu, %u;\n",
 			  cond.base, imm, cond.wid);
 		  fprintf(vvp_out, "    %%jmp/1 T_%u.%u, 6;\n",
@@ -29,10 +29,21 @@
 #undef FST_WRITER_PARALLEL
 #endif
 
-#ifdef FST_WRITER_PARALLEL
+#ifdef HAVE_LIBPTHREAD
+#define FST_WRITER_THREADS
+#ifndef FST_WRITER_PARALLEL
+#define FST_WRITER_PARALLEL
+#endif
+#endif
+
+#if defined(FST_WRITER_PARALLEL) || defined(FST_WRITER_THREADS)
 #include <pthread.h>
 #endif
 
+#ifndef _MSC_VER
+#include <sys/time.h>
+#endif
+
 #if HAVE_ALLOCA_H
 #include <alloca.h>
 #elif defined(__GNUC__)
@@ -575,17 +586,13 @@ unsigned size_limit_locked : 1;
 unsigned section_header_only : 1;
 unsigned flush_context_pending : 1;
 unsigned parallel_enabled : 1;
-unsigned parallel_was_enabled : 1;
 
 /* should really be semaphores, but are bytes to cut down on read-modify-write window size */
 unsigned char already_in_flush; /* in case control-c handlers interrupt */
 unsigned char already_in_close; /* in case control-c handlers interrupt */
 
-#ifdef FST_WRITER_PARALLEL
-pthread_mutex_t mutex;
-pthread_t thread;
-pthread_attr_t thread_attr;
-struct fstWriterContext *xc_parent;
+#ifdef FST_WRITER_THREADS
+struct fstWriterPackPool *pool;	/* started on the first flush, shared with section copies */
 #endif
 
 size_t fst_orig_break_size;
@@ -602,6 +609,11 @@ Pvoid_t path_array;
 uint32_t path_array_count;
 
 unsigned fseek_failed : 1;
+
+int compress_threads;	/* value change chains are packed on this many threads */
+double flush_secs;	/* wall time spent flushing value change sections */
+double wait_secs;	/* ...of which was spent waiting on compression threads */
+double compress_secs;	/* time spent packing chains, summed over all threads */
 };
 
 
@@ -932,11 +944,6 @@ if((!nam)||(!(xc->handle=unlink_fopen(nam, "w+b"))))
 
 		fstWriterEmitHdrBytes(xc);
 		xc->nan = strtod("NaN", NULL);
-#ifdef FST_WRITER_PARALLEL
-		pthread_mutex_init(&xc->mutex, NULL);
-		pthread_attr_init(&xc->thread_attr);
-		pthread_attr_setdetachstate(&xc->thread_attr, PTHREAD_CREATE_DETACHED);
-#endif
 		}
 		else
 		{
@@ -974,9 +981,6 @@ if(xc)
 
 	fputc(FST_BL_SKIP, xc->handle);			/* temporarily tag the section, use FST_BL_VCDATA on finalize */
 	xc->section_start = ftello(xc->handle);
-#ifdef FST_WRITER_PARALLEL
-	if(xc->xc_parent) xc->xc_parent->section_start = xc->section_start;
-#endif
 	xc->section_header_only = 1;			/* indicates truncate might be needed */
 	fstWriterUint64(xc->handle, 0); 		/* placeholder = section length */
 	fstWriterUint64(xc->handle, xc->is_initial_time ? xc->firsttime : xc->curtime); 	/* begin time of section */
@@ -1008,6 +1012,322 @@ if(xc)
 }
 
 
+/*
+ * value change chains are packed (and compressed) one handle at a time
+ * into a job, either inline by the flushing thread or concurrently by a
+ * pool of compression threads.  either way, jobs are written out in
+ * handle order so the file is identical regardless of thread count.
+ */
+struct fstWriterPackBuf
+{
+unsigned char *scratchpad;	/* xc->vchg_siz bytes, built backwards */
+unsigned char *packmem;
+unsigned int packmemlen;
+double compress_secs;
+};
+
+struct fstWriterPackJob
+{
+uint32_t idx;			/* handle index into valpos_mem */
+uint32_t offs;			/* head of chain in vchg_mem */
+uint32_t wrlen;			/* uncompressed length of chain */
+uint32_t hdr;			/* wrlen if mem is compressed, else zero */
+uint32_t len;			/* length of mem */
+unsigned char *mem;
+int done;
+};
+
+
+static double fstWriterSeconds(void)
+{
+#ifndef _MSC_VER
+struct timeval tv;
+
+gettimeofday(&tv, NULL);
+return(tv.tv_sec + tv.tv_usec / 1000000.0);
+#else
+return((double)clock() / CLOCKS_PER_SEC);
+#endif
+}
+
+
+static void fstWriterPackChain(struct fstWriterContext *xc, struct fstWriterPackJob *job, struct fstWriterPackBuf *buf)
+{
+unsigned char *vchg_mem = xc->vchg_mem;
+unsigned char *scratchpad = buf->scratchpad;
+unsigned char *scratchpnt;
+uint32_t *vm4ip = &(xc->valpos_mem[4*job->idx]);
+uint32_t offs = job->offs;
+uint32_t next_offs;
+int wrlen;
+double start = fstWriterSeconds();
+
+scratchpnt = scratchpad + xc->vchg_siz;		/* build this buffer backwards */
+if(vm4ip[1] <= 1)
+	{
+	if(vm4ip[1] == 1)
+		{
+		wrlen = fstGetVarint32Length(vchg_mem + offs + 4); /* used to advance and determine wrlen */
+#ifndef FST_REMOVE_DUPLICATE_VC
+		xc->curval_mem[vm4ip[0]] = vchg_mem[offs + 4 + wrlen]; /* checkpoint variable */
+#endif
+                while(offs)
+                        {
+                        unsigned char val;
+                        uint32_t time_delta, rcv;
+                        next_offs = fstGetUint32(vchg_mem + offs);
+                        offs += 4;   
+                
+                        time_delta = fstGetVarint32(vchg_mem + offs, &wrlen);
+                        val = vchg_mem[offs+wrlen];
+			offs = next_offs;
+
+                        switch(val)
+                                {
+                                case '0':
+                                case '1':               rcv = ((val&1)<<1) | (time_delta<<2);
+                                                        break; /* pack more delta bits in for 0/1 vchs */
+
+                                case 'x': case 'X':     rcv = FST_RCV_X | (time_delta<<4); break;
+                                case 'z': case 'Z':     rcv = FST_RCV_Z | (time_delta<<4); break;
+                                case 'h': case 'H':     rcv = FST_RCV_H | (time_delta<<4); break;
+                                case 'u': case 'U':     rcv = FST_RCV_U | (time_delta<<4); break;
+                                case 'w': case 'W':     rcv = FST_RCV_W | (time_delta<<4); break;
+                                case 'l': case 'L':     rcv = FST_RCV_L | (time_delta<<4); break;
+                                default:                rcv = FST_RCV_D | (time_delta<<4); break;
+                                }
+        
+                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, rcv);
+			}
+		}
+		else
+		{
+		/* variable length */
+		/* fstGetUint32 (next_offs) + fstGetVarint32 (time_delta) + fstGetVarint32 (len) + payload */
+		unsigned char *pnt;
+		uint32_t record_len;
+		uint32_t time_delta;				
+
+		while(offs)
+			{
+			next_offs = fstGetUint32(vchg_mem + offs);
+			offs += 4;
+			pnt = vchg_mem + offs;
+			offs = next_offs;
+			time_delta = fstGetVarint32(pnt, &wrlen);
+			pnt += wrlen;
+			record_len = fstGetVarint32(pnt, &wrlen);
+			pnt += wrlen;
+
+			scratchpnt -= record_len;
+			memcpy(scratchpnt, pnt, record_len);
+
+			scratchpnt = fstCopyVarint32ToLeft(scratchpnt, record_len);
+			scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1)); /* reserve | 1 case for future expansion */
+			}
+		}
+	}
+	else
+	{
+	wrlen = fstGetVarint32Length(vchg_mem + offs + 4); /* used to advance and determine wrlen */
+#ifndef FST_REMOVE_DUPLICATE_VC
+	memcpy(xc->curval_mem + vm4ip[0], vchg_mem + offs + 4 + wrlen, vm4ip[1]); /* checkpoint variable */
+#endif
+	while(offs)
+		{
+		int idx;
+		char is_binary = 1;
+		unsigned char *pnt;
+		uint32_t time_delta;
+
+		next_offs = fstGetUint32(vchg_mem + offs);
+		offs += 4;
+
+		time_delta = fstGetVarint32(vchg_mem + offs, &wrlen);
+
+		pnt = vchg_mem+offs+wrlen;
+		offs = next_offs;
+
+		for(idx=0;idx<vm4ip[1];idx++)
+			{
+			if((pnt[idx] == '0') || (pnt[idx] == '1'))
+				{
+				continue;
+				}
+				else
+				{
+				is_binary = 0;
+				break;
+				}
+			}
+
+		if(is_binary)
+			{
+			unsigned char acc = 0;
+			int shift = 7 - ((vm4ip[1]-1) & 7);
+			for(idx=vm4ip[1]-1;idx>=0;idx--)
+				{
+				acc |= (pnt[idx] & 1) << shift;
+				shift++;
+				if(shift == 8)
+					{
+					*(--scratchpnt) = acc;
+					shift = 0;
+					acc = 0;
+					}						
+				}					
+
+                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1));
+			}
+			else
+			{
+			scratchpnt -= vm4ip[1];
+			memcpy(scratchpnt, pnt, vm4ip[1]);
+
+                        scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1) | 1);
+			}
+		}
+	}
+
+wrlen = scratchpad + xc->vchg_siz - scratchpnt;
+job->wrlen = wrlen;
+job->hdr = 0;
+job->mem = scratchpnt;
+job->len = wrlen;
+
+if(wrlen > 32)
+	{
+	unsigned long destlen = wrlen;
+	unsigned char *dmem;
+        int rc;
+
+	if(!xc->fastpack)
+		{
+		if(wrlen <= buf->packmemlen)
+			{
+			dmem = buf->packmem;
+			}
+			else
+			{
+			free(buf->packmem);
+			dmem = buf->packmem = malloc(buf->packmemlen = wrlen);
+			}
+
+	        rc = compress2(dmem, &destlen, scratchpnt, wrlen, 4);
+		if(rc == Z_OK)
+			{
+			job->hdr = wrlen;
+			job->mem = dmem;
+			job->len = destlen;
+			}
+		}
+		else
+		{
+		if(((wrlen * 2) + 2) <= buf->packmemlen)
+			{
+			dmem = buf->packmem;
+			}
+			else
+			{
+			free(buf->packmem);
+			dmem = buf->packmem = malloc(buf->packmemlen = (wrlen * 2) + 2);
+			}
+
+		rc = fastlz_compress(scratchpnt, wrlen, dmem);
+		if(rc < destlen)
+			{
+			job->hdr = wrlen;
+			job->mem = dmem;
+			job->len = rc;
+			}
+		}
+	}
+
+buf->compress_secs += fstWriterSeconds() - start;
+}
+
+
+#ifdef FST_WRITER_THREADS
+/*
+ * The threads live from the first flush until the writer is closed.
+ * numpackers of them pack value change chains, and in parallel mode
+ * one more writes out whole sections while the simulation goes on
+ * filling the next one.
+ */
+struct fstWriterPackPool
+{
+pthread_mutex_t mutex;
+pthread_cond_t work_cond;	/* jobs, a section or shutdown are waiting */
+pthread_cond_t done_cond;	/* a job or a section has been finished */
+pthread_t *threads;
+int numthreads;
+int numpackers;
+unsigned flusher : 1;		/* a thread is there to take sections */
+unsigned shutdown : 1;
+
+struct fstWriterContext *xc;	/* context the jobs are packed from */
+struct fstWriterPackJob *jobs;
+int numjobs;
+int nextjob;			/* next job to be claimed by a thread */
+double compress_secs;
+
+struct fstWriterContext *section;	/* copy waiting for the flush thread */
+struct fstWriterContext *finished;	/* copy written, results not yet taken back */
+unsigned section_busy : 1;
+};
+
+
+static void *fstWriterPackThread(void *arg)
+{
+struct fstWriterPackPool *pool = (struct fstWriterPackPool *)arg;
+struct fstWriterPackBuf buf;
+uint32_t scratchlen = 0;
+
+buf.scratchpad = NULL;
+buf.packmemlen = 1024;
+buf.packmem = malloc(buf.packmemlen);
+
+pthread_mutex_lock(&pool->mutex);
+for(;;)
+	{
+	struct fstWriterContext *xc;
+	struct fstWriterPackJob *job;
+	unsigned char *mem;
+
+	while(!pool->shutdown && (pool->nextjob >= pool->numjobs))
+		{
+		pthread_cond_wait(&pool->work_cond, &pool->mutex);
+		}
+	if(pool->shutdown) break;
+
+	xc = pool->xc;
+	job = &pool->jobs[pool->nextjob++];
+	pthread_mutex_unlock(&pool->mutex);
+
+	if(scratchlen < xc->vchg_siz)
+		{
+		free(buf.scratchpad);
+		buf.scratchpad = malloc(scratchlen = xc->vchg_siz);
+		}
+	buf.compress_secs = 0.0;
+	fstWriterPackChain(xc, job, &buf);
+	mem = malloc(job->len);		/* buf is reused by the next job */
+	memcpy(mem, job->mem, job->len);
+	job->mem = mem;
+
+	pthread_mutex_lock(&pool->mutex);
+	job->done = 1;
+	pool->compress_secs += buf.compress_secs;
+	pthread_cond_broadcast(&pool->done_cond);
+	}
+pthread_mutex_unlock(&pool->mutex);
+
+free(buf.packmem);
+free(buf.scratchpad);
+return(NULL);
+}
+#endif
+
 /*
  * only to be called directly by fst code...otherwise must
  * be synced up with time changes
@@ -1021,26 +1341,24 @@ static void fstWriterFlushContextPrivate(void *ctx)
 #ifdef FST_DEBUG
 int cnt = 0;
 #endif
-int i;
-unsigned char *vchg_mem;
+int i, j;
 FILE *f;
 off_t fpos, indxpos, endpos;
 uint32_t prevpos;
 int zerocnt;
-unsigned char *scratchpad;
-unsigned char *scratchpnt;
 unsigned char *tmem;
 off_t tlen;
 off_t unc_memreq = 0; /* for reader */
-unsigned char *packmem;
-unsigned int packmemlen;
+struct fstWriterPackJob *jobs;
+int numjobs = 0;
+int pooled = 0; /* jobs are packed by the pool threads */
+struct fstWriterPackBuf buf;
+#ifdef FST_WRITER_THREADS
+struct fstWriterPackPool *pool;
+#endif
+double flush_start;
 uint32_t *vm4ip;
 struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
-#ifdef FST_WRITER_PARALLEL
-struct fstWriterContext *xc2 = xc->xc_parent;
-#else
-struct fstWriterContext *xc2 = xc;
-#endif
 
 #ifndef FST_DYNAMIC_ALIAS_DISABLE
 Pvoid_t PJHSArray = (Pvoid_t) NULL;
@@ -1056,312 +1374,138 @@ hashmask |= hashmask >> 16;
 
 if((!xc)||(xc->vchg_siz <= 1)||(xc->already_in_flush)) return;
 xc->already_in_flush = 1; /* should really do this with a semaphore */
+flush_start = fstWriterSeconds();
 
 xc->section_header_only = 0;
-scratchpad = malloc(xc->vchg_siz);
-
-vchg_mem = xc->vchg_mem;
 
 f = xc->handle;
 fstWriterVarint(f, xc->maxhandle);	/* emit current number of handles */
 fputc(xc->fastpack ? 'F' : 'Z', f);
 fpos = 1;
 
-packmemlen = 1024;			/* maintain a running "longest" allocation to */
-packmem = malloc(packmemlen);		/* prevent continual malloc...free every loop iter */
-
+jobs = malloc((xc->maxhandle ? xc->maxhandle : 1) * sizeof(struct fstWriterPackJob));
 for(i=0;i<xc->maxhandle;i++)
 	{
 	vm4ip = &(xc->valpos_mem[4*i]);
 
-	if(vm4ip[2]) 
+	if(vm4ip[2])
 		{
-		uint32_t offs = vm4ip[2];
-		uint32_t next_offs;
-		int wrlen;
-
-		vm4ip[2] = fpos;
-
-		scratchpnt = scratchpad + xc->vchg_siz;		/* build this buffer backwards */
-		if(vm4ip[1] <= 1)
-			{
-			if(vm4ip[1] == 1)
-				{
-				wrlen = fstGetVarint32Length(vchg_mem + offs + 4); /* used to advance and determine wrlen */
-#ifndef FST_REMOVE_DUPLICATE_VC
-				xc->curval_mem[vm4ip[0]] = vchg_mem[offs + 4 + wrlen]; /* checkpoint variable */
-#endif
-	                        while(offs)
-	                                {
-	                                unsigned char val;
-	                                uint32_t time_delta, rcv;
-	                                next_offs = fstGetUint32(vchg_mem + offs);
-	                                offs += 4;   
-                        
-	                                time_delta = fstGetVarint32(vchg_mem + offs, &wrlen);
-	                                val = vchg_mem[offs+wrlen];
-					offs = next_offs;
-
-	                                switch(val)
-	                                        {
-	                                        case '0':
-	                                        case '1':               rcv = ((val&1)<<1) | (time_delta<<2);
-	                                                                break; /* pack more delta bits in for 0/1 vchs */
-	        
-	                                        case 'x': case 'X':     rcv = FST_RCV_X | (time_delta<<4); break;
-	                                        case 'z': case 'Z':     rcv = FST_RCV_Z | (time_delta<<4); break;
-	                                        case 'h': case 'H':     rcv = FST_RCV_H | (time_delta<<4); break;
-	                                        case 'u': case 'U':     rcv = FST_RCV_U | (time_delta<<4); break;
-	                                        case 'w': case 'W':     rcv = FST_RCV_W | (time_delta<<4); break;
-	                                        case 'l': case 'L':     rcv = FST_RCV_L | (time_delta<<4); break;
-	                                        default:                rcv = FST_RCV_D | (time_delta<<4); break;
-	                                        }
-	                
-	                                scratchpnt = fstCopyVarint32ToLeft(scratchpnt, rcv);
-					}
-				}
-				else
-				{
-				/* variable length */
-				/* fstGetUint32 (next_offs) + fstGetVarint32 (time_delta) + fstGetVarint32 (len) + payload */
-				unsigned char *pnt;
-				uint32_t record_len;
-				uint32_t time_delta;				
+		jobs[numjobs].idx = i;
+		jobs[numjobs].offs = vm4ip[2];
+		jobs[numjobs].done = 0;
+		numjobs++;
+		}
+	}
 
-				while(offs)
-					{
-					next_offs = fstGetUint32(vchg_mem + offs);
-					offs += 4;
-					pnt = vchg_mem + offs;
-					offs = next_offs;
-					time_delta = fstGetVarint32(pnt, &wrlen);
-					pnt += wrlen;
-					record_len = fstGetVarint32(pnt, &wrlen);
-					pnt += wrlen;
-
-					scratchpnt -= record_len;
-					memcpy(scratchpnt, pnt, record_len);
-
-					scratchpnt = fstCopyVarint32ToLeft(scratchpnt, record_len);
-					scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1)); /* reserve | 1 case for future expansion */
-					}
-				}
-			}
-			else
-			{
-			wrlen = fstGetVarint32Length(vchg_mem + offs + 4); /* used to advance and determine wrlen */
-#ifndef FST_REMOVE_DUPLICATE_VC
-			memcpy(xc->curval_mem + vm4ip[0], vchg_mem + offs + 4 + wrlen, vm4ip[1]); /* checkpoint variable */
+#ifdef FST_WRITER_THREADS
+pool = xc->pool;
+if(pool && pool->numpackers && (numjobs > 1))
+	{
+	pthread_mutex_lock(&pool->mutex);
+	pool->xc = xc;
+	pool->jobs = jobs;
+	pool->numjobs = numjobs;
+	pool->nextjob = 0;
+	pool->compress_secs = 0.0;
+	pthread_cond_broadcast(&pool->work_cond);
+	pthread_mutex_unlock(&pool->mutex);
+	pooled = 1;
+	}
 #endif
-			while(offs)
-				{
-				int idx;
-				char is_binary = 1;
-				unsigned char *pnt;
-				uint32_t time_delta;
-
-				next_offs = fstGetUint32(vchg_mem + offs);
-				offs += 4;
-
-				time_delta = fstGetVarint32(vchg_mem + offs, &wrlen);
-
-				pnt = vchg_mem+offs+wrlen;
-				offs = next_offs;
-
-				for(idx=0;idx<vm4ip[1];idx++)
-					{
-					if((pnt[idx] == '0') || (pnt[idx] == '1'))
-						{
-						continue;
-						}
-						else
-						{
-						is_binary = 0;
-						break;
-						}
-					}
 
-				if(is_binary)
-					{
-					unsigned char acc = 0;
-					int shift = 7 - ((vm4ip[1]-1) & 7);
-					for(idx=vm4ip[1]-1;idx>=0;idx--)
-						{
-						acc |= (pnt[idx] & 1) << shift;
-						shift++;
-						if(shift == 8)
-							{
-							*(--scratchpnt) = acc;
-							shift = 0;
-							acc = 0;
-							}						
-						}					
+if(!pooled)
+	{
+	buf.scratchpad = malloc(xc->vchg_siz);
+	buf.packmemlen = 1024;			/* maintain a running "longest" allocation to */
+	buf.packmem = malloc(buf.packmemlen);	/* prevent continual malloc...free every loop iter */
+	buf.compress_secs = 0.0;
+	}
 
-	                                scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1));
-					}
-					else
-					{
-					scratchpnt -= vm4ip[1];
-					memcpy(scratchpnt, pnt, vm4ip[1]);
+for(j=0;j<numjobs;j++)
+	{
+	struct fstWriterPackJob *job = &jobs[j];
 
-	                                scratchpnt = fstCopyVarint32ToLeft(scratchpnt, (time_delta << 1) | 1);
-					}
-				}
-			}
+#ifdef FST_WRITER_THREADS
+	if(pooled)
+		{
+		double wait_start = fstWriterSeconds();
 
-		wrlen = scratchpad + xc->vchg_siz - scratchpnt;
-		unc_memreq += wrlen;
-		if(wrlen > 32)
+		pthread_mutex_lock(&pool->mutex);
+		while(!job->done)
 			{
-			unsigned long destlen = wrlen;
-			unsigned char *dmem;
-		        int rc;
+			pthread_cond_wait(&pool->done_cond, &pool->mutex);
+			}
+		pthread_mutex_unlock(&pool->mutex);
+		xc->wait_secs += fstWriterSeconds() - wait_start;
+		}
+		else
+#endif
+		{
+		fstWriterPackChain(xc, job, &buf);
+		}
 
-			if(!xc->fastpack)
-				{
-				if(wrlen <= packmemlen)
-					{
-					dmem = packmem;
-					}
-					else
-					{
-					free(packmem);
-					dmem = packmem = malloc(packmemlen = wrlen);
-					}
+	i = job->idx;
+	vm4ip = &(xc->valpos_mem[4*i]);
+	vm4ip[2] = fpos;
+	unc_memreq += job->wrlen;
 
-		        	rc = compress2(dmem, &destlen, scratchpnt, wrlen, 4);
-				if(rc == Z_OK)
-					{
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-					PPvoid_t pv = JudyHSIns(&PJHSArray, dmem, destlen, NULL);
-					if(*pv)
-						{
-						uint32_t pvi = (long)(*pv);
-						vm4ip[2] = -pvi;
-						}
-						else
-						{
-						*pv = (void *)(long)(i+1);
-#endif
-						fpos += fstWriterVarint(f, wrlen);
-						fpos += destlen;
-						fstFwrite(dmem, destlen, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-						}
-#endif
-					}
-					else
-					{
+	{
 #ifndef FST_DYNAMIC_ALIAS_DISABLE
-					PPvoid_t pv = JudyHSIns(&PJHSArray, scratchpnt, wrlen, NULL);
-					if(*pv)
-						{
-						uint32_t pvi = (long)(*pv);
-						vm4ip[2] = -pvi;
-						}
-						else
-						{
-						*pv = (void *)(long)(i+1);
+	PPvoid_t pv = JudyHSIns(&PJHSArray, job->mem, job->len, NULL);
+	if(*pv)
+		{
+		uint32_t pvi = (long)(*pv);
+		vm4ip[2] = -pvi;
+		}
+		else
+		{
+		*pv = (void *)(long)(i+1);
 #endif
-						fpos += fstWriterVarint(f, 0);
-						fpos += wrlen;
-						fstFwrite(scratchpnt, wrlen, 1, f);
+		fpos += fstWriterVarint(f, job->hdr);
+		fpos += job->len;
+		fstFwrite(job->mem, job->len, 1, f);
 #ifndef FST_DYNAMIC_ALIAS_DISABLE
-						}
+		}
 #endif
-					}
-				}
-				else
-				{
-				if(((wrlen * 2) + 2) <= packmemlen)
-					{
-					dmem = packmem;
-					}
-					else
-					{
-					free(packmem);
-					dmem = packmem = malloc(packmemlen = (wrlen * 2) + 2);
-					}
+	}
 
-				rc = fastlz_compress(scratchpnt, wrlen, dmem);
-				if(rc < destlen)
-        				{
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-					PPvoid_t pv = JudyHSIns(&PJHSArray, dmem, rc, NULL);
-					if(*pv)
-						{
-						uint32_t pvi = (long)(*pv);
-						vm4ip[2] = -pvi;
-						}
-						else
-						{
-						*pv = (void *)(long)(i+1);
-#endif
-						fpos += fstWriterVarint(f, wrlen);
-						fpos += rc;
-						fstFwrite(dmem, rc, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-						}
-#endif
-        				}
-        				else
-        				{
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-					PPvoid_t pv = JudyHSIns(&PJHSArray, scratchpnt, wrlen, NULL);
-					if(*pv)
-						{
-						uint32_t pvi = (long)(*pv);
-						vm4ip[2] = -pvi;
-						}
-						else
-						{
-						*pv = (void *)(long)(i+1);
-#endif
-						fpos += fstWriterVarint(f, 0);
-						fpos += wrlen;
-						fstFwrite(scratchpnt, wrlen, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-						}
-#endif
-        				}
-				}
-			}
-			else
-			{
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-			PPvoid_t pv = JudyHSIns(&PJHSArray, scratchpnt, wrlen, NULL);
-			if(*pv)
-				{
-				uint32_t pvi = (long)(*pv);
-				vm4ip[2] = -pvi;
-				}
-				else
-				{
-				*pv = (void *)(long)(i+1);
-#endif
-				fpos += fstWriterVarint(f, 0);
-				fpos += wrlen;
-				fstFwrite(scratchpnt, wrlen, 1, f);
-#ifndef FST_DYNAMIC_ALIAS_DISABLE
-				}
+#ifdef FST_WRITER_THREADS
+	if(pooled)
+		{
+		free(job->mem);
+		}
 #endif
-			}
 
-		/* vm4ip[3] = 0; ...redundant with clearing below */
+	/* vm4ip[3] = 0; ...redundant with clearing below */
 #ifdef FST_DEBUG
-		cnt++;
+	cnt++;
 #endif
-		}
 	}
 
+#ifdef FST_WRITER_THREADS
+if(pooled)
+	{
+	pthread_mutex_lock(&pool->mutex);	/* every job is done, so the threads are idle */
+	pool->jobs = NULL;
+	pool->numjobs = pool->nextjob = 0;
+	xc->compress_secs += pool->compress_secs;
+	pthread_mutex_unlock(&pool->mutex);
+	}
+	else
+#endif
+	{
+	free(buf.packmem); buf.packmem = NULL; /* packmemlen = 0; */ /* scan-build */
+	free(buf.scratchpad); buf.scratchpad = NULL;
+	xc->compress_secs += buf.compress_secs;
+	}
+
+free(jobs);
+
 #ifndef FST_DYNAMIC_ALIAS_DISABLE
 JudyHSFreeArray(&PJHSArray, NULL);
 #endif
 
-free(packmem); packmem = NULL; /* packmemlen = 0; */ /* scan-build */
-
 prevpos = 0; zerocnt = 0;
-free(scratchpad); scratchpad = NULL;
 
 indxpos = ftello(f);
 xc->secnum++;
@@ -1463,64 +1607,207 @@ fflush(xc->handle);
 
 fstWriterFseeko(xc, xc->handle, endpos, SEEK_SET);				/* seek to end of file */
 
-xc2->section_header_truncpos = endpos;				/* cache in case of need to truncate */
+xc->section_header_truncpos = endpos;				/* cache in case of need to truncate */
 if(xc->dump_size_limit)
 	{
 	if(endpos >= xc->dump_size_limit)
 		{
-		xc2->skip_writing_section_hdr = 1;
-		xc2->size_limit_locked = 1;
-		xc2->is_initial_time = 1; /* to trick emit value and emit time change */
+		xc->skip_writing_section_hdr = 1;
+		xc->size_limit_locked = 1;
+		xc->is_initial_time = 1; /* to trick emit value and emit time change */
 #ifdef FST_DEBUG
 		printf("<< dump file size limit reached, stopping dumping >>\n");
 #endif
 		}
 	}
 
-if(!xc2->skip_writing_section_hdr)
+if(!xc->skip_writing_section_hdr)
 	{
 	fstWriterEmitSectionHeader(xc);				/* emit next section header */
 	}
 fflush(xc->handle);
 
+xc->flush_secs += fstWriterSeconds() - flush_start;
 xc->already_in_flush = 0;
 }
 
 
 #ifdef FST_WRITER_PARALLEL
-static void *fstWriterFlushContextPrivate1(void *ctx)
+/*
+ * the flush thread never writes into the parent context, which the
+ * simulation is still using; what the section copy learned about the
+ * file is taken back here, on the simulation side, once it is written
+ */
+static void fstWriterFlushContextPrivate1(struct fstWriterContext *xc, struct fstWriterContext *xc2)
 {
-struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
-
-fstWriterFlushContextPrivate2(xc);
-
-pthread_mutex_unlock(&(xc->xc_parent->mutex));
+xc->section_start = xc2->section_start;
+xc->section_header_only = xc2->section_header_only;
+xc->section_header_truncpos = xc2->section_header_truncpos;
+xc->skip_writing_section_hdr = xc2->skip_writing_section_hdr;
+if(xc2->size_limit_locked)
+	{
+	xc->size_limit_locked = 1;
+	xc->is_initial_time = 1; /* to trick emit value and emit time change */
+	}
+xc->compress_secs = xc2->compress_secs;
 
 #ifdef FST_REMOVE_DUPLICATE_VC
-free(xc->curval_mem);
+free(xc2->curval_mem);
 #endif
-free(xc->valpos_mem);
-free(xc->vchg_mem);
-fclose(xc->tchn_handle);
-free(xc);
+free(xc2->valpos_mem);
+free(xc2->vchg_mem);
+fclose(xc2->tchn_handle);
+free(xc2);
+}
+
+
+static void *fstWriterFlushThread(void *arg)
+{
+struct fstWriterPackPool *pool = (struct fstWriterPackPool *)arg;
+
+pthread_mutex_lock(&pool->mutex);
+for(;;)
+	{
+	struct fstWriterContext *xc;
+
+	while(!pool->shutdown && !pool->section)
+		{
+		pthread_cond_wait(&pool->work_cond, &pool->mutex);
+		}
+	if(!pool->section) break;	/* shutdown with nothing left to write */
+
+	xc = pool->section;
+	pool->section = NULL;
+	pool->section_busy = 1;
+	pthread_mutex_unlock(&pool->mutex);
+
+	fstWriterFlushContextPrivate2(xc);
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->finished = xc;
+	pool->section_busy = 0;
+	pthread_cond_broadcast(&pool->done_cond);
+	}
+pthread_mutex_unlock(&pool->mutex);
 
 return(NULL);
 }
 
 
+static struct fstWriterPackPool *fstWriterPoolStart(struct fstWriterContext *xc)
+{
+struct fstWriterPackPool *pool = calloc(1, sizeof(struct fstWriterPackPool));
+int threads = (xc->compress_threads > 1) ? xc->compress_threads : 0;
+
+pthread_mutex_init(&pool->mutex, NULL);
+pthread_cond_init(&pool->work_cond, NULL);
+pthread_cond_init(&pool->done_cond, NULL);
+pool->threads = malloc((threads + 1) * sizeof(pthread_t));
+
+while(pool->numthreads < threads)
+	{
+	if(pthread_create(&pool->threads[pool->numthreads], NULL, fstWriterPackThread, pool)) break;
+	pool->numthreads++;
+	}
+pool->numpackers = pool->numthreads;
+
+if(xc->parallel_enabled)
+	{
+	if(!pthread_create(&pool->threads[pool->numthreads], NULL, fstWriterFlushThread, pool))
+		{
+		pool->numthreads++;
+		pool->flusher = 1;
+		}
+	}
+
+return(pool);
+}
+
+
+static void fstWriterPoolStop(struct fstWriterPackPool *pool)
+{
+int i;
+
+pthread_mutex_lock(&pool->mutex);
+pool->shutdown = 1;
+pthread_cond_broadcast(&pool->work_cond);
+pthread_mutex_unlock(&pool->mutex);
+
+for(i=0;i<pool->numthreads;i++)
+	{
+	pthread_join(pool->threads[i], NULL);
+	}
+
+free(pool->threads);
+pthread_cond_destroy(&pool->done_cond);
+pthread_cond_destroy(&pool->work_cond);
+pthread_mutex_destroy(&pool->mutex);
+free(pool);
+}
+
+
+/*
+ * blocks until the section handed to the flush thread, if any, is in the file
+ */
+static void fstWriterFlushWait(struct fstWriterContext *xc)
+{
+struct fstWriterPackPool *pool = xc->pool;
+
+if(pool)
+	{
+	struct fstWriterContext *xc2;
+
+	pthread_mutex_lock(&pool->mutex);
+	while(pool->section || pool->section_busy)
+		{
+		pthread_cond_wait(&pool->done_cond, &pool->mutex);
+		}
+	xc2 = pool->finished;
+	pool->finished = NULL;
+	pthread_mutex_unlock(&pool->mutex);
+
+	if(xc2)
+		{
+		fstWriterFlushContextPrivate1(xc, xc2);
+		}
+	}
+}
+
+
 static void fstWriterFlushContextPrivate(void *ctx)
 {
 struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
 
-if(xc->parallel_enabled)
+if(!xc->pool)
+	{
+	xc->pool = fstWriterPoolStart(xc);
+	}
+
+if(xc->parallel_enabled && xc->pool->flusher)
 	{
-	struct fstWriterContext *xc2 = malloc(sizeof(struct fstWriterContext));
+	struct fstWriterContext *xc2;
+	double flush_start = fstWriterSeconds();
 	int i;
 
-	pthread_mutex_lock(&xc->mutex);
-	pthread_mutex_unlock(&xc->mutex);
+	fstWriterFlushWait(xc);		/* the previous section still owns the file */
+	xc->wait_secs += fstWriterSeconds() - flush_start;
+
+	if(xc->size_limit_locked)	/* ...and it went past the limit, drop this one */
+		{
+		xc->vchg_mem[0] = '!';
+		xc->vchg_siz = 1;
+		for(i=0;i<xc->maxhandle;i++)
+			{
+		        xc->valpos_mem[4*i+2] = 0;
+		        xc->valpos_mem[4*i+3] = 0;
+		        }
+		xc->tchn_cnt = xc->tchn_idx = 0;
+		fstWriterFseeko(xc, xc->tchn_handle, 0, SEEK_SET);
+		fstFtruncate(fileno(xc->tchn_handle), 0);
+		return;
+		}
 
-	xc->xc_parent = xc;
+	xc2 = malloc(sizeof(struct fstWriterContext));
 	memcpy(xc2, xc, sizeof(struct fstWriterContext));
 
 	xc2->valpos_mem = malloc(xc->maxhandle * 4 * sizeof(uint32_t));
@@ -1551,19 +1838,16 @@ if(xc->parallel_enabled)
 	xc->section_header_only = 0;
 	xc->secnum++;
 
-	pthread_mutex_lock(&xc->mutex);
+	pthread_mutex_lock(&xc->pool->mutex);
+	xc->pool->section = xc2;
+	pthread_cond_broadcast(&xc->pool->work_cond);
+	pthread_mutex_unlock(&xc->pool->mutex);
 
-	pthread_create(&xc->thread, &xc->thread_attr, fstWriterFlushContextPrivate1, xc2);
+	xc->flush_secs += fstWriterSeconds() - flush_start;
 	}
 	else
 	{
-	if(xc->parallel_was_enabled) /* conservatively block */
-		{
-		pthread_mutex_lock(&xc->mutex);
-		pthread_mutex_unlock(&xc->mutex);
-		}
-
-	xc->xc_parent = xc;
+	fstWriterFlushWait(xc);		/* parallel mode may have been switched off */
 	fstWriterFlushContextPrivate2(xc);
 	}
 }
@@ -1596,8 +1880,7 @@ struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
 #ifdef FST_WRITER_PARALLEL
 if(xc)
 	{
-	pthread_mutex_lock(&xc->mutex);
-	pthread_mutex_unlock(&xc->mutex);
+	fstWriterFlushWait(xc);
 	}
 #endif
 
@@ -1631,8 +1914,7 @@ if(xc && !xc->already_in_close && !xc->already_in_flush)
 				}
 			fstWriterFlushContextPrivate(xc);
 #ifdef FST_WRITER_PARALLEL
-			pthread_mutex_lock(&xc->mutex);
-			pthread_mutex_unlock(&xc->mutex);
+			fstWriterFlushWait(xc);
 #endif
 			}
 		}
@@ -1863,8 +2145,11 @@ if(xc && !xc->already_in_close && !xc->already_in_flush)
 #endif
 
 #ifdef FST_WRITER_PARALLEL
-	pthread_mutex_destroy(&xc->mutex);
-	pthread_attr_destroy(&xc->thread_attr);
+	if(xc->pool)
+		{
+		fstWriterPoolStop(xc->pool);
+		xc->pool = NULL;
+		}
 #endif
 
 	if(xc->path_array)
@@ -2154,7 +2439,6 @@ void fstWriterSetParallelMode(void *ctx, int enable)
 struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
 if(xc)
 	{
-	xc->parallel_was_enabled |= xc->parallel_enabled; /* make sticky */
 	xc->parallel_enabled = (enable != 0);
 #ifndef FST_WRITER_PARALLEL
 	if(xc->parallel_enabled)
@@ -2167,6 +2451,38 @@ if(xc)
 }
 
 
+void fstWriterSetCompressThreads(void *ctx, int threads)
+{
+struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
+if(xc)
+	{
+	xc->compress_threads = (threads > 1) ? threads : 1;
+#ifndef FST_WRITER_THREADS
+	if(xc->compress_threads > 1)
+		{
+		fprintf(stderr, "WARNING: fstWriterSetCompressThreads(), pthreads not enabled during compile, using one thread.\n");
+		xc->compress_threads = 1;
+		}
+#endif
+	}
+}
+
+
+void fstWriterGetFlushStats(void *ctx, double *flush_secs, double *wait_secs, double *compress_secs)
+{
+struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
+if(xc)
+	{
+#ifdef FST_WRITER_PARALLEL
+	fstWriterFlushWait(xc);		/* a section may still be compressing */
+#endif
+	if(flush_secs) *flush_secs = xc->flush_secs;
+	if(wait_secs) *wait_secs = xc->wait_secs;
+	if(compress_secs) *compress_secs = xc->compress_secs;
+	}
+}
+
+
 void fstWriterSetDumpSizeLimit(void *ctx, uint64_t numbytes)
 {
 struct fstWriterContext *xc = (struct fstWriterContext *)ctx;
@@ -329,11 +329,13 @@ void 		fstWriterEmitDumpActive(void *ctx, int enable);
 void 		fstWriterEmitTimeChange(void *ctx, uint64_t tim);
 void 		fstWriterFlushContext(void *ctx);
 int 		fstWriterGetDumpSizeLimitReached(void *ctx);
+void 		fstWriterGetFlushStats(void *ctx, double *flush_secs, double *wait_secs, double *compress_secs);
 int 		fstWriterGetFseekFailed(void *ctx);
 void 		fstWriterSetAttrBegin(void *ctx, enum fstAttrType attrtype, int subtype,
                 	const char *attrname, uint64_t arg);
 void 		fstWriterSetAttrEnd(void *ctx);
 void 		fstWriterSetComment(void *ctx, const char *comm);
+void 		fstWriterSetCompressThreads(void *ctx, int threads);
 void 		fstWriterSetDate(void *ctx, const char *dat);
 void 		fstWriterSetDumpSizeLimit(void *ctx, uint64_t numbytes);
 void 		fstWriterSetEnvVar(void *ctx, const char *envvar);
@@ -53,6 +53,7 @@ static int dump_is_off = 0;
 static long dump_limit = 0;
 static int dump_is_full = 0;
 static int finish_status = 0;
+static int dump_is_forked = 0;
 
 
 static enum lxm_optimum_mode_e {
@@ -62,6 +63,10 @@ static enum lxm_optimum_mode_e {
       LXM_BOTH = 3
 } lxm_optimum_mode = LXM_NONE;
 
+  /* The value changes are compressed on this many threads. */
+static int fst_threads = 1;
+static int fst_stats = 0;
+
 static const char*units_names[] = {
       "s",
       "ms",
@@ -163,22 +168,77 @@ static PLI_INT32 variable_cb_2(p_cb_data cause)
       return 0;
 }
 
+static int dump_limit_exceeded(void)
+{
+      if ((dump_limit > 0) && fstWriterGetDumpSizeLimitReached(dump_file)) {
+            dump_is_full = 1;
+            vpi_printf("WARNING: Dump file limit (%ld bytes) "
+                               "exceeded.\n", dump_limit);
+            return 1;
+      }
+      return 0;
+}
+
+/*
+ * Most signals are followed by the value-change recorder of the run
+ * time instead of a callback. The id of a recorded signal is its FST
+ * handle, and the value is emitted as the same bit string that
+ * show_this_item() gets from vpi_get_value().
+ */
+static char *fst_bits_buf = 0;
+static unsigned fst_bits_size = 0;
+
+static void fst_record_cb(PLI_INT32 id, PLI_UINT64 now, PLI_UINT32 wid,
+			  const s_vpi_vecval*val, void*user)
+{
+      unsigned idx;
+      char*cp;
+      (void) user;  /* Unused argument. */
+
+      if (dump_is_forked) return;
+      if (dump_is_full) return;
+      if (dump_is_off) return;
+      if (dump_header_pending()) return;
+	/* The $dumpvars values are taken after the changes of the
+	   time step of the header, so those are already dumped. */
+      if (now == dumpvars_time) return;
+      if (dump_limit_exceeded()) return;
+
+      if (now != vcd_cur_time) {
+	    fstWriterEmitTimeChange(dump_file, now);
+	    vcd_cur_time = now;
+      }
+
+      if (wid+1 > fst_bits_size) {
+	    fst_bits_size = wid+1;
+	    fst_bits_buf = realloc(fst_bits_buf, fst_bits_size);
+      }
+
+	/* The aval/bval pairs 00, 10, 01 and 11 are 0, 1, z and x. */
+      cp = fst_bits_buf;
+      for (idx = wid ; idx > 0 ; idx -= 1) {
+	    unsigned word = (idx-1) / 32;
+	    unsigned bit = (idx-1) % 32;
+	    unsigned code = ((val[word].aval >> bit) & 1)
+	                  | (((val[word].bval >> bit) & 1) << 1);
+	    *cp++ = "01zx"[code];
+      }
+      *cp = 0;
+
+      fstWriterEmitValueChange(dump_file, (fstHandle)id, fst_bits_buf);
+}
+
 static PLI_INT32 variable_cb_1(p_cb_data cause)
 {
       struct t_cb_data cb;
       struct vcd_info*info = (struct vcd_info*)cause->user_data;
 
+      if (dump_is_forked) return 0;
       if (dump_is_full) return 0;
       if (dump_is_off) return 0;
       if (dump_header_pending()) return 0;
       if (info->scheduled) return 0;
-
-      if ((dump_limit > 0) && fstWriterGetDumpSizeLimitReached(dump_file)) {
-            dump_is_full = 1;
-            vpi_printf("WARNING: Dump file limit (%ld bytes) "
-                               "exceeded.\n", dump_limit);
-            return 0;
-      }
+      if (dump_limit_exceeded()) return 0;
 
       if (!vcd_dmp_list) {
           cb = *cause;
@@ -229,7 +289,24 @@ static PLI_INT32 finish_cb(p_cb_data cause)
 	    fstWriterEmitTimeChange(dump_file, dumpvars_time);
       }
 
+      vpip_record_stop(fst_record_cb, 0);
+
+	/* The final section is flushed by the close, after the
+	   simulation, so only the flushes that stalled it are counted. */
+      if (fst_stats) {
+	    double flush_secs, wait_secs, compress_secs;
+	    fstWriterGetFlushStats(dump_file, &flush_secs, &wait_secs,
+	                           &compress_secs);
+	    vpi_printf("FST info: the simulation stalled %.3fs flushing "
+	               "value changes, %.3fs of it waiting on %d "
+	               "compression thread(s) that spent %.3fs "
+	               "compressing.\n", flush_secs, wait_secs,
+	               fst_threads, compress_secs);
+      }
       fstWriterClose(dump_file);
+      free(fst_bits_buf);
+      fst_bits_buf = 0;
+      fst_bits_size = 0;
 
       for (cur = vcd_list ;  cur ;  cur = next) {
 	    next = cur->next;
@@ -245,6 +322,41 @@ static PLI_INT32 finish_cb(p_cb_data cause)
       return 0;
 }
 
+/*
+ * The run time forks a copy of the simulation for each test of a
+ * checkpoint, and the original simulation stops at the checkpoint
+ * without calling the end of simulation callbacks. The forks do not
+ * dump, so the dump ends at the checkpoint. Finish the file before
+ * the fork.
+ */
+static PLI_INT32 save_cb(p_cb_data cause)
+{
+      struct t_cb_data cb;
+      struct t_vpi_time now;
+
+      (void) cause;  /* Unused argument. */
+      if (dump_file == 0) return 0;
+
+      now.type = vpiSimTime;
+      vpi_get_time(0, &now);
+      cb.time = &now;
+      finish_cb(&cb);
+      dump_file = 0;
+      return 0;
+}
+
+/*
+ * The dump file was finished before the fork, so a fork of a
+ * checkpoint stops dumping for good, and a later $dumpvars does not
+ * open a new file.
+ */
+static PLI_INT32 restart_cb(p_cb_data cause)
+{
+      (void) cause;  /* Unused argument. */
+      dump_is_forked = 1;
+      return 0;
+}
+
 __inline__ static int install_dumpvars_callback(void)
 {
       struct t_cb_data cb;
@@ -357,6 +469,13 @@ static PLI_INT32 sys_dumpall_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
 static void open_dumpfile(vpiHandle callh)
 {
+      if (dump_is_forked) {
+	    vpi_printf("FST warning: %s:%d: ", vpi_get_str(vpiFile, callh),
+	               (int)vpi_get(vpiLineNo, callh));
+	    vpi_printf("Dumping is disabled in the tests of a checkpoint.\n");
+	    return;
+      }
+
       if (dump_path == 0) dump_path = strdup("dump.fst");
 
       dump_file = fstWriterCreate(dump_path, 1);
@@ -403,6 +522,10 @@ static void open_dumpfile(vpiHandle callh)
 	        (lxm_optimum_mode == LXM_BOTH)) {
 		  fstWriterSetRepackOnClose(dump_file, 1);
 	    }
+	    fstWriterSetCompressThreads(dump_file, fst_threads);
+	      /* With more threads the blocks are also written out in the
+	         background while the simulation fills the next one. */
+	    if (fst_threads > 1) fstWriterSetParallelMode(dump_file, 1);
       }
 }
 
@@ -644,7 +767,9 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 		  info->next  = vcd_list;
 		  vcd_list    = info;
 
-		  info->cb    = vpi_register_cb(&cb);
+		  if (vpip_record_signal(item, new_ident,
+		                         fst_record_cb, 0)) info->cb = 0;
+		  else info->cb = vpi_register_cb(&cb);
 	    }
 
 	    break;
@@ -884,6 +1009,7 @@ void sys_fst_register()
       int idx;
       struct t_vpi_vlog_info vlog_info;
       s_vpi_systf_data tf_data;
+      struct t_cb_data cb;
       vpiHandle res;
 
 	/* Scan the extended arguments, looking for fst optimization flags. */
@@ -901,6 +1027,18 @@ void sys_fst_register()
 		  lxm_optimum_mode = LXM_BOTH;
 	    } else if (strcmp(vlog_info.argv[idx],"-fst-speed-space") == 0) {
 		  lxm_optimum_mode = LXM_BOTH;
+
+	    } else if (strncmp(vlog_info.argv[idx],"-fst-threads=",13) == 0) {
+		  fst_threads = atoi(vlog_info.argv[idx]+13);
+		  if (fst_threads < 1) {
+			vpi_printf("FST warning: %s: thread count must be "
+			           "positive, using one thread.\n",
+			           vlog_info.argv[idx]);
+			fst_threads = 1;
+		  }
+
+	    } else if (strcmp(vlog_info.argv[idx],"-fst-stats") == 0) {
+		  fst_stats = 1;
 	    }
       }
 
@@ -968,4 +1106,15 @@ void sys_fst_register()
       tf_data.user_data = "$dumpvars";
       res = vpi_register_systf(&tf_data);
       vpip_make_systf_system_defined(res);
+
+      cb.reason = cbStartOfSave;
+      cb.time = 0;
+      cb.cb_rtn = save_cb;
+      cb.user_data = 0;
+      cb.obj = 0;
+      vpi_register_cb(&cb);
+
+      cb.reason = cbEndOfRestart;
+      cb.cb_rtn = restart_cb;
+      vpi_register_cb(&cb);
 }
@@ -56,6 +56,7 @@ static int dump_is_off = 0;
 static long dump_limit = 0;
 static int dump_is_full = 0;
 static int finish_status = 0;
+static int dump_is_forked = 0;
 
 
 static enum lxm_optimum_mode_e {
@@ -247,6 +248,7 @@ static PLI_INT32 variable_cb_1(p_cb_data cause)
       struct t_cb_data cb;
       struct vcd_info*info = (struct vcd_info*)cause->user_data;
 
+      if (dump_is_forked) return 0;
       if (dump_is_full) return 0;
       if (dump_is_off) return 0;
       if (dump_header_pending()) return 0;
@@ -317,6 +319,42 @@ static PLI_INT32 finish_cb(p_cb_data cause)
       return 0;
 }
 
+/*
+ * The run time forks a copy of the simulation for each test of a
+ * checkpoint, and the original simulation stops at the checkpoint
+ * without calling the end of simulation callbacks. The forks do not
+ * dump, so the dump ends at the checkpoint. Finish the file before
+ * the fork.
+ */
+static PLI_INT32 save_cb(p_cb_data cause)
+{
+      struct t_cb_data cb;
+      struct t_vpi_time now;
+
+      (void) cause;  /* Unused argument. */
+      if (dump_file == 0) return 0;
+
+      now.type = vpiSimTime;
+      vpi_get_time(0, &now);
+      cb.time = &now;
+      finish_cb(&cb);
+      lt_close(dump_file);
+      dump_file = NULL;
+      return 0;
+}
+
+/*
+ * The dump file was finished before the fork, so a fork of a
+ * checkpoint stops dumping for good, and a later $dumpvars does not
+ * open a new file.
+ */
+static PLI_INT32 restart_cb(p_cb_data cause)
+{
+      (void) cause;  /* Unused argument. */
+      dump_is_forked = 1;
+      return 0;
+}
+
 __inline__ static int install_dumpvars_callback(void)
 {
       struct t_cb_data cb;
@@ -435,6 +473,13 @@ static void *close_dumpfile(void)
 
 static void open_dumpfile(vpiHandle callh)
 {
+      if (dump_is_forked) {
+	    vpi_printf("LXT warning: %s:%d: ", vpi_get_str(vpiFile, callh),
+	               (int)vpi_get(vpiLineNo, callh));
+	    vpi_printf("Dumping is disabled in the tests of a checkpoint.\n");
+	    return;
+      }
+
       if (dump_path == 0) dump_path = strdup("dump.lxt");
 
       dump_file = lt_init(dump_path);
@@ -779,6 +824,7 @@ void sys_lxt_register()
       int idx;
       struct t_vpi_vlog_info vlog_info;
       s_vpi_systf_data tf_data;
+      struct t_cb_data cb;
       vpiHandle res;
 
 
@@ -860,4 +906,15 @@ void sys_lxt_register()
       tf_data.user_data = "$dumpvars";
       res = vpi_register_systf(&tf_data);
       vpip_make_systf_system_defined(res);
+
+      cb.reason = cbStartOfSave;
+      cb.time = 0;
+      cb.cb_rtn = save_cb;
+      cb.user_data = 0;
+      cb.obj = 0;
+      vpi_register_cb(&cb);
+
+      cb.reason = cbEndOfRestart;
+      cb.cb_rtn = restart_cb;
+      vpi_register_cb(&cb);
 }
@@ -112,6 +112,7 @@ static int dump_is_off = 0;
 static long dump_limit = 0;
 static int dump_is_full = 0;
 static int finish_status = 0;
+static int dump_is_forked = 0;
 
 
 static enum lxm_optimum_mode_e {
@@ -289,6 +290,7 @@ static PLI_INT32 variable_cb_1(p_cb_data cause)
       struct t_cb_data cb;
       struct vcd_info*info = (struct vcd_info*)cause->user_data;
 
+      if (dump_is_forked) return 0;
       if (dump_is_full) return 0;
       if (dump_is_off) return 0;
       if (dump_header_pending()) return 0;
@@ -355,6 +357,42 @@ static PLI_INT32 finish_cb(p_cb_data cause)
       return 0;
 }
 
+/*
+ * The run time forks a copy of the simulation for each test of a
+ * checkpoint, and the original simulation stops at the checkpoint
+ * without calling the end of simulation callbacks. The forks do not
+ * dump, so the dump ends at the checkpoint. Finish the file before
+ * the fork.
+ */
+static PLI_INT32 save_cb(p_cb_data cause)
+{
+      struct t_cb_data cb;
+      struct t_vpi_time now;
+
+      (void) cause;  /* Unused argument. */
+      if (dump_file == 0) return 0;
+
+      now.type = vpiSimTime;
+      vpi_get_time(0, &now);
+      cb.time = &now;
+      finish_cb(&cb);
+      lxt2_wr_close(dump_file);
+      dump_file = NULL;
+      return 0;
+}
+
+/*
+ * The dump file was finished before the fork, so a fork of a
+ * checkpoint stops dumping for good, and a later $dumpvars does not
+ * open a new file.
+ */
+static PLI_INT32 restart_cb(p_cb_data cause)
+{
+      (void) cause;  /* Unused argument. */
+      dump_is_forked = 1;
+      return 0;
+}
+
 __inline__ static int install_dumpvars_callback(void)
 {
       struct t_cb_data cb;
@@ -475,6 +513,14 @@ static void *close_dumpfile(void)
 static void open_dumpfile(vpiHandle callh)
 {
       off_t use_file_size_limit = lxt2_file_size_limit;
+
+      if (dump_is_forked) {
+	    vpi_printf("LXT2 warning: %s:%d: ", vpi_get_str(vpiFile, callh),
+	               (int)vpi_get(vpiLineNo, callh));
+	    vpi_printf("Dumping is disabled in the tests of a checkpoint.\n");
+	    return;
+      }
+
       if (dump_path == 0) dump_path = strdup("dump.lx2");
 
       dump_file = lxt2_wr_init(dump_path);
@@ -844,6 +890,8 @@ static void* lxt2_thread(void*arg)
 
 	    switch (cell->type) {
 		case WT_NONE:
+		case WT_EMIT_VECTOR:
+		case WT_EMIT_TIME:
 		  break;
 		case WT_FLUSH:
 		  lxt2_wr_flush(dump_file);
@@ -878,6 +926,7 @@ void sys_lxt2_register()
       int idx;
       struct t_vpi_vlog_info vlog_info;
       s_vpi_systf_data tf_data;
+      struct t_cb_data cb;
       vpiHandle res;
 
 	/* Scan the extended arguments, looking for lxt2 optimization flags. */
@@ -964,4 +1013,15 @@ void sys_lxt2_register()
       tf_data.user_data = "$dumpvars";
       res = vpi_register_systf(&tf_data);
       vpip_make_systf_system_defined(res);
+
+      cb.reason = cbStartOfSave;
+      cb.time = 0;
+      cb.cb_rtn = save_cb;
+      cb.user_data = 0;
+      cb.obj = 0;
+      vpi_register_cb(&cb);
+
+      cb.reason = cbEndOfRestart;
+      cb.cb_rtn = restart_cb;
+      vpi_register_cb(&cb);
 }
@@ -256,6 +256,39 @@ static PLI_INT32 sys_mem_compiletf(ICARUS_VPI_CONST PLI_BYTE8*name)
       return 0;
 }
 
+/*
+ * When the memory allows it, the words are put into (or taken out of)
+ * the memory a run at a time with vpip_put_words and vpip_get_words
+ * instead of through a handle for each word. A run holds about this
+ * many s_vpi_vecval, so that a run of narrow words is long and wide
+ * words do not take too much memory.
+ */
+#define RUN_VECVALS 16384
+
+static unsigned run_words(unsigned vcnt)
+{
+      unsigned res = RUN_VECVALS / vcnt;
+      return res > 0 ? res : 1;
+}
+
+/*
+ * Put the run of count words, that started at address addr in the
+ * file. If the addresses go down, the run was filled from the end of
+ * the buffer so that it is always in increasing address order.
+ */
+static void put_run(vpiHandle mitem, const s_vpi_vecval*run, unsigned vcnt,
+		    unsigned run_max, int addr, unsigned count, int addr_incr)
+{
+      if (count == 0)
+	    return;
+
+      if (addr_incr > 0)
+	    vpip_put_words(mitem, addr, count, run);
+      else
+	    vpip_put_words(mitem, addr-count+1, count,
+	                   run + (run_max-count)*vcnt);
+}
+
 static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
       int code, wwid, addr;
@@ -281,6 +314,11 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       /* This is the number of words that we need from the memory. */
       unsigned word_count;
 
+      /* The run of words that is waiting to be put into the memory. */
+      s_vpi_vecval*run = 0;
+      unsigned vcnt, run_max = 0, run_count = 0;
+      int run_addr = 0;
+
       /*======================================== Get parameters */
 
       get_mem_params(argv, callh, name,
@@ -326,7 +364,13 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       /* variable that will be used by the lexer to pass values
 	 back to this code */
       value.format = vpiVectorVal;
-      value.value.vector = calloc((wwid+31)/32, sizeof(s_vpi_vecval));
+      vcnt = (wwid+31)/32;
+      value.value.vector = calloc(vcnt, sizeof(s_vpi_vecval));
+
+      if (vpip_put_words(mitem, min_addr, 0, 0) == 0) {
+	    run_max = run_words(vcnt);
+	    run = malloc(run_max*vcnt*sizeof(s_vpi_vecval));
+      }
 
       /* Configure the readmem lexer */
       if (strcmp(name,"$readmemb") == 0)
@@ -341,6 +385,9 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       while ((code = readmemlex()) != 0) {
 	  switch (code) {
 	  case MEM_ADDRESS:
+	      put_run(mitem, run, vcnt, run_max, run_addr, run_count,
+	              addr_incr);
+	      run_count = 0;
 	      addr = value.value.vector->aval;
 	      if (addr < min_addr || addr > max_addr) {
 		  vpi_printf("ERROR: %s:%d: ", vpi_get_str(vpiFile, callh),
@@ -358,7 +405,22 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 	      break;
 
 	  case MEM_WORD:
-	      if (addr >= min_addr && addr <= max_addr) {
+	      if (addr >= min_addr && addr <= max_addr && run) {
+		  unsigned slot;
+		  if (run_count == run_max) {
+			put_run(mitem, run, vcnt, run_max, run_addr,
+			        run_count, addr_incr);
+			run_count = 0;
+		  }
+		  if (run_count == 0) run_addr = addr;
+		  if (addr_incr > 0) slot = run_count;
+		  else slot = run_max - 1 - run_count;
+		  memcpy(run + slot*vcnt, value.value.vector,
+		         vcnt*sizeof(s_vpi_vecval));
+		  run_count += 1;
+
+		  if (word_count > 0) word_count -= 1;
+	      } else if (addr >= min_addr && addr <= max_addr) {
 		  vpiHandle word_index;
 		  word_index = vpi_handle_by_index(mitem, addr);
 		  assert(word_index);
@@ -401,6 +463,8 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       }
 
  bailout:
+      put_run(mitem, run, vcnt, run_max, run_addr, run_count, addr_incr);
+      free(run);
       free(value.value.vector);
       free(fname);
       fclose(file);
@@ -505,6 +569,48 @@ static PLI_INT32 sys_readmempath_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       return 0;
 }
 
+/*
+ * Write a word that vpip_get_words returned in the same form that
+ * vpi_get_value gives as a vpiBinStrVal or vpiHexStrVal. A hex digit
+ * is x or z if all its bits are, else X if any bit is x or Z if any
+ * bit is z.
+ */
+static void write_word(FILE*file, const s_vpi_vecval*word, unsigned wid,
+		       int bin_flag)
+{
+      char buf[1024];
+      char*str = buf;
+      unsigned len, idx;
+
+      len = bin_flag ? wid : (wid+3)/4;
+      if (len+2 > sizeof buf)
+	    str = malloc(len+2);
+
+      for (idx = 0 ; idx < len ; idx += 1) {
+	    unsigned bit = bin_flag ? idx : 4*idx;
+	    unsigned aval = word[bit/32].aval >> bit%32;
+	    unsigned bval = word[bit/32].bval >> bit%32;
+	    if (bin_flag) {
+		  str[len-1-idx] = "01zx"[((bval&1) << 1) | (aval&1)];
+	    } else {
+		  unsigned mask = wid - bit < 4 ? (1U << (wid-bit)) - 1 : 0xf;
+		  unsigned xbits = aval & bval & mask;
+		  unsigned zbits = ~aval & bval & mask;
+		  if (xbits == mask) str[len-1-idx] = 'x';
+		  else if (zbits == mask) str[len-1-idx] = 'z';
+		  else if (xbits) str[len-1-idx] = 'X';
+		  else if (zbits) str[len-1-idx] = 'Z';
+		  else str[len-1-idx] = "0123456789abcdef"[aval & mask];
+	    }
+      }
+      str[len] = '\n';
+      str[len+1] = 0;
+      fputs(str, file);
+
+      if (str != buf)
+	    free(str);
+}
+
 static PLI_INT32 sys_writemem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
       int addr;
@@ -519,7 +625,10 @@ static PLI_INT32 sys_writemem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       vpiHandle stop_item = 0;
 
       int start_addr, stop_addr, addr_incr;
-      int min_addr, max_addr; // Not used in this routine.
+      int min_addr, max_addr;
+
+      s_vpi_vecval*run = 0;
+      unsigned wwid, vcnt, run_max = 0;
 
       /*======================================== Get parameters */
 
@@ -550,9 +659,42 @@ static PLI_INT32 sys_writemem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       if (strcmp(name,"$writememb")==0) value.format = vpiBinStrVal;
       else value.format = vpiHexStrVal;
 
+      wwid = vpi_get(vpiSize, vpi_handle_by_index(mitem, min_addr));
+      vcnt = (wwid+31)/32;
+      if (vpip_get_words(mitem, min_addr, 0, 0) == 0) {
+	    run_max = run_words(vcnt);
+	    run = malloc(run_max*vcnt*sizeof(s_vpi_vecval));
+      }
+
       /*======================================== Write memory file */
 
       cnt = 0;
+      if (run) {
+	      /* Get the words a run at a time, in address order, and
+	         write them in the order the addresses are given. */
+	    unsigned total = max_addr - min_addr + 1;
+	    while (cnt < total) {
+		  unsigned count = total - cnt;
+		  unsigned idx;
+		  int first;
+		  if (count > run_max) count = run_max;
+		  if (addr_incr > 0) first = start_addr + cnt;
+		  else first = start_addr - cnt - count + 1;
+		  vpip_get_words(mitem, first, count, run);
+
+		  for (idx = 0 ; idx < count ; idx += 1, ++cnt) {
+			unsigned word = addr_incr > 0 ? idx : count-1-idx;
+			if (cnt%16 == 0) fprintf(file, "// 0x%08x\n", cnt);
+			write_word(file, run + word*vcnt, wwid,
+			           value.format == vpiBinStrVal);
+		  }
+	    }
+	    free(run);
+	    fclose(file);
+	    free(fname);
+	    return 0;
+      }
+
       for(addr=start_addr; addr!=stop_addr+addr_incr; addr+=addr_incr, ++cnt) {
 	  vpiHandle word_index;
 
@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 1999-2013 Stephen Williams (steve@icarus.com)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * This is the scanner for the $readmemh and $readmemb data files. The
+ * files are simple enough that a hand written scanner does the job,
+ * and these files can be very large, so the scanner reads the file in
+ * large blocks and decodes the digits of the words through a table.
+ *
+ * The tokens are:
+ *
+ *    @<hex digits>         an address, returned in vecval[0].aval
+ *    <digits, x, z or _>   a word, returned in vecval
+ *
+ * White space, // comments and C style comments are skipped. Any
+ * other character is an error.
+ */
+
+# include  "sys_readmem_lex.h"
+# include  <string.h>
+# include  <stdlib.h>
+# include  "ivl_alloc.h"
+
+char *readmem_error_token = 0;
+
+static FILE*scan_fd = 0;
+static char scan_buf[64*1024];
+static size_t scan_pos = 0;
+static size_t scan_end = 0;
+
+  /* The text of the current token. */
+static char*token = 0;
+static size_t token_len = 0;
+static size_t token_size = 0;
+
+static char error_buf[2];
+
+static unsigned word_width = 0;
+static struct t_vpi_vecval*vecval = 0;
+
+/*
+ * The digit table holds the value of each digit of the current
+ * radix, or one of these codes.
+ */
+enum {
+      CODE_X    = 0x10,
+      CODE_Z    = 0x20,
+      CODE_SKIP = 0x40,
+      CODE_NONE = 0xff
+};
+static unsigned char digit_code[256];
+static unsigned digit_bits = 4;
+  /* Addresses are always hex, and have no x, z or _ characters. */
+static unsigned char addr_code[256];
+
+static int scan_fill(void)
+{
+      scan_pos = 0;
+      scan_end = fread(scan_buf, 1, sizeof scan_buf, scan_fd);
+      return scan_end > 0;
+}
+
+static int scan_peek(void)
+{
+      if (scan_pos == scan_end && ! scan_fill())
+	    return EOF;
+      return (unsigned char)scan_buf[scan_pos];
+}
+
+static void token_add(const char*text, size_t len)
+{
+      if (token_len + len + 1 > token_size) {
+	    token_size = 2*(token_len + len + 1);
+	    token = realloc(token, token_size);
+      }
+      memcpy(token + token_len, text, len);
+      token_len += len;
+      token[token_len] = 0;
+}
+
+/*
+ * Collect the characters that are in the table, as many as there
+ * are, into the token.
+ */
+static void scan_token(const unsigned char*table)
+{
+      token_len = 0;
+      token_add("", 0);
+      for (;;) {
+	    size_t start;
+	    if (scan_pos == scan_end && ! scan_fill())
+		  return;
+
+	    start = scan_pos;
+	    while (scan_pos < scan_end) {
+		  if (table[(unsigned char)scan_buf[scan_pos]] == CODE_NONE)
+			break;
+		  scan_pos += 1;
+	    }
+	    token_add(scan_buf + start, scan_pos - start);
+	    if (scan_pos < scan_end)
+		  return;
+      }
+}
+
+static void skip_line_comment(void)
+{
+      for (;;) {
+	    char*nl;
+	    if (scan_pos == scan_end && ! scan_fill())
+		  return;
+	    nl = memchr(scan_buf + scan_pos, '\n', scan_end - scan_pos);
+	    if (nl) {
+		  scan_pos = nl - scan_buf;
+		  return;
+	    }
+	    scan_pos = scan_end;
+      }
+}
+
+static void skip_block_comment(void)
+{
+      int star = 0;
+      int ch;
+      while ( (ch = scan_peek()) != EOF ) {
+	    scan_pos += 1;
+	    if (star && ch == '/')
+		  return;
+	    star = ch == '*';
+      }
+}
+
+static void make_addr(void)
+{
+      sscanf(token, "%x", (unsigned int*)&vecval->aval);
+}
+
+/*
+ * Fill the vecval from the least significant (last) digit of the
+ * token up, and stop when the word is full.
+ */
+static void make_value(void)
+{
+      const char*beg = token;
+      const char*end = token + token_len;
+      struct t_vpi_vecval*cur;
+      unsigned mask = (1U << digit_bits) - 1;
+      int idx;
+      int width = 0, word_max = word_width;
+
+      for (idx = 0, cur = vecval ;  idx < word_max ;  idx += 32, cur += 1) {
+	    cur->aval = 0;
+	    cur->bval = 0;
+      }
+
+      cur = vecval;
+      while ((width < word_max) && (end > beg)) {
+	    unsigned aval, bval;
+	    unsigned code;
+
+	    end -= 1;
+	    code = digit_code[(unsigned char)*end];
+	    switch (code) {
+		case CODE_SKIP:
+		  continue;
+		case CODE_X:
+		  aval = mask;
+		  bval = mask;
+		  break;
+		case CODE_Z:
+		  aval = 0;
+		  bval = mask;
+		  break;
+		default:
+		  aval = code;
+		  bval = 0;
+		  break;
+	    }
+
+	    cur->aval |= aval << width;
+	    cur->bval |= bval << width;
+	    width += digit_bits;
+	    if (width == 32) {
+		  cur += 1;
+		  width = 0;
+		  word_max -= 32;
+	    }
+      }
+}
+
+int readmemlex()
+{
+      int ch;
+
+      while ( (ch = scan_peek()) != EOF ) {
+	    switch (ch) {
+		case ' ':
+		case '\t':
+		case '\f':
+		case '\n':
+		case '\r':
+		  scan_pos += 1;
+		  continue;
+
+		case '/':
+		  scan_pos += 1;
+		  ch = scan_peek();
+		  if (ch == '/') {
+			skip_line_comment();
+			continue;
+		  }
+		  if (ch == '*') {
+			scan_pos += 1;
+			skip_block_comment();
+			continue;
+		  }
+		  error_buf[0] = '/';
+		  readmem_error_token = error_buf;
+		  return MEM_ERROR;
+
+		case '@':
+		  scan_pos += 1;
+		  scan_token(addr_code);
+		  if (token_len == 0) {
+			error_buf[0] = '@';
+			readmem_error_token = error_buf;
+			return MEM_ERROR;
+		  }
+		  make_addr();
+		  return MEM_ADDRESS;
+	    }
+
+	    if (digit_code[ch] == CODE_NONE) {
+		  scan_pos += 1;
+		  error_buf[0] = ch;
+		  readmem_error_token = error_buf;
+		  return MEM_ERROR;
+	    }
+
+	    scan_token(digit_code);
+	    make_value();
+	    return MEM_WORD;
+      }
+
+      return 0;
+}
+
+void sys_readmem_start_file(FILE*in, int bin_flag,
+			    unsigned width, struct t_vpi_vecval *vv)
+{
+      int idx;
+
+      scan_fd = in;
+      scan_pos = 0;
+      scan_end = 0;
+      word_width = width;
+      vecval = vv;
+
+      memset(addr_code, CODE_NONE, sizeof addr_code);
+      for (idx = 0 ; idx < 10 ; idx += 1)
+	    addr_code['0'+idx] = idx;
+      for (idx = 0 ; idx < 6 ; idx += 1) {
+	    addr_code['a'+idx] = 10 + idx;
+	    addr_code['A'+idx] = 10 + idx;
+      }
+
+      memset(digit_code, CODE_NONE, sizeof digit_code);
+      if (bin_flag) {
+	    digit_bits = 1;
+	    digit_code['0'] = 0;
+	    digit_code['1'] = 1;
+      } else {
+	    digit_bits = 4;
+	    for (idx = 0 ; idx < 10 ; idx += 1)
+		  digit_code['0'+idx] = idx;
+	    for (idx = 0 ; idx < 6 ; idx += 1) {
+		  digit_code['a'+idx] = 10 + idx;
+		  digit_code['A'+idx] = 10 + idx;
+	    }
+      }
+      digit_code['x'] = CODE_X;
+      digit_code['X'] = CODE_X;
+      digit_code['z'] = CODE_Z;
+      digit_code['Z'] = CODE_Z;
+      digit_code['_'] = CODE_SKIP;
+}
+
+void destroy_readmem_lexor()
+{
+      free(token);
+      token = 0;
+      token_len = 0;
+      token_size = 0;
+      scan_fd = 0;
+}
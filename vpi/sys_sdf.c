@@ -22,6 +22,8 @@
 # include  <stdlib.h>
 # include  <string.h>
 # include  <assert.h>
+# include  <sys/stat.h>
+# include  "ivl_alloc.h"
 
 /*
  * These are static context
@@ -61,48 +63,74 @@ static vpiHandle find_scope(vpiHandle scope, const char*name)
  * handling items discovered in the parse.
  */
 
-void sdf_select_instance(const char*celltype, const char*cellinst)
+/*
+ * Look up the cell by its full name. The run time keeps an index of
+ * the full names, so this does not search the hierarchy.
+ */
+static vpiHandle find_cell(const char*cellinst)
 {
-      char buffer[128];
-
-	/* First follow the hierarchical parts of the cellinst name to
-	   get to the cell that I'm looking for. */
-      vpiHandle scope = sdf_scope;
-      const char*src = cellinst;
-      const char*dp;
-      while ( (dp=strchr(src, '.')) ) {
-	    unsigned len = dp - src;
-	    assert(dp >= src);
-	    assert(len < sizeof buffer);
-	    strncpy(buffer, src, len);
-	    buffer[len] = 0;
-
-	    vpiHandle tmp_scope = find_scope(scope, buffer);
-	    if (tmp_scope == 0) {
-		  vpi_printf("SDF WARNING: %s:%d: ",
-		             vpi_get_str(vpiFile, sdf_callh),
-		             (int)vpi_get(vpiLineNo, sdf_callh));
-		  vpi_printf("Cannot find %s in scope %s.\n",
-			     buffer, vpi_get_str(vpiFullName, scope));
-		  break;
-	    }
-	    assert(tmp_scope);
-	    scope = tmp_scope;
+      const char*scope_name = vpi_get_str(vpiFullName, sdf_scope);
+      char*full = malloc(strlen(scope_name) + strlen(cellinst) + 2);
+      sprintf(full, "%s.%s", scope_name, cellinst);
 
-	    src = dp + 1;
-      }
+      vpiHandle cell = vpi_handle_by_name(full, 0);
+      free(full);
 
-	/* Now find the cell. */
-      if (src[0] == 0)
+      if (cell && vpi_get(vpiType, cell) != vpiModule)
+	    return 0;
+      return cell;
+}
+
+void sdf_select_instance(const char*celltype, const char*cellinst)
+{
+      if (cellinst[0] == 0)
 	    sdf_cur_cell = sdf_scope;
       else
-	    sdf_cur_cell = find_scope(scope, src);
+	    sdf_cur_cell = find_cell(cellinst);
+
+	/* If the index does not have it, follow the hierarchical parts
+	   of the cellinst name to get to the cell that I'm looking
+	   for, so that the warning says where the path went wrong. */
       if (sdf_cur_cell == 0) {
-	    vpi_printf("SDF WARNING: %s:%d: ", vpi_get_str(vpiFile, sdf_callh),
-	               (int)vpi_get(vpiLineNo, sdf_callh));
-	    vpi_printf("Unable to find %s in scope %s.\n",
-		       cellinst, vpi_get_str(vpiFullName, scope));
-	    return;
+	    char buffer[128];
+	    vpiHandle scope = sdf_scope;
+	    const char*src = cellinst;
+	    const char*dp;
+	    while ( (dp=strchr(src, '.')) ) {
+		  unsigned len = dp - src;
+		  assert(dp >= src);
+		  assert(len < sizeof buffer);
+		  strncpy(buffer, src, len);
+		  buffer[len] = 0;
+
+		  vpiHandle tmp_scope = find_scope(scope, buffer);
+		  if (tmp_scope == 0) {
+			vpi_printf("SDF WARNING: %s:%d: ",
+			           vpi_get_str(vpiFile, sdf_callh),
+			           (int)vpi_get(vpiLineNo, sdf_callh));
+			vpi_printf("Cannot find %s in scope %s.\n",
+			           buffer, vpi_get_str(vpiFullName, scope));
+			break;
+		  }
+		  assert(tmp_scope);
+		  scope = tmp_scope;
+
+		  src = dp + 1;
+	    }
+
+	      /* Now find the cell. */
+	    if (src[0] == 0)
+		  sdf_cur_cell = sdf_scope;
+	    else
+		  sdf_cur_cell = find_scope(scope, src);
+	    if (sdf_cur_cell == 0) {
+		  vpi_printf("SDF WARNING: %s:%d: ",
+		             vpi_get_str(vpiFile, sdf_callh),
+		             (int)vpi_get(vpiLineNo, sdf_callh));
+		  vpi_printf("Unable to find %s in scope %s.\n",
+		             cellinst, vpi_get_str(vpiFullName, scope));
+		  return;
+	    }
       }
 
 	/* The scope that matches should be a module. */
@@ -135,24 +163,45 @@ static const char*edge_str(int vpi_edge)
       return "edge.. ";
 }
 
-void sdf_iopath_delays(int vpi_edge, const char*src, const char*dst,
-		       const struct sdf_delval_list_s*delval_list)
+/*
+ * The modpaths of the current cell are collected once, when the first
+ * IOPATH of the cell is matched, so that each IOPATH only compares
+ * names and does not go back to the run time for each path.
+ */
+struct sdf_path_s {
+      vpiHandle path;
+      char*src;
+      char*dst;
+      int edge;
+};
+
+static vpiHandle sdf_paths_cell = 0;
+static struct sdf_path_s*sdf_paths = 0;
+static unsigned sdf_npaths = 0;
+
+static void clear_cell_paths(void)
 {
-      vpiHandle iter, path;
-      int match_count = 0;
+      unsigned idx;
+      for (idx = 0 ; idx < sdf_npaths ; idx += 1) {
+	    free(sdf_paths[idx].src);
+	    free(sdf_paths[idx].dst);
+      }
+      free(sdf_paths);
+      sdf_paths = 0;
+      sdf_npaths = 0;
+      sdf_paths_cell = 0;
+}
 
-      if (sdf_cur_cell == 0)
-	    return;
+static void load_cell_paths(vpiHandle cell)
+{
+      vpiHandle iter, path;
 
-      iter = vpi_iterate(vpiModPath, sdf_cur_cell);
+      clear_cell_paths();
+      sdf_paths_cell = cell;
 
-	/* Search for the modpath that matches the IOPATH by looking
-	   for the modpath that uses the same ports as the ports that
-	   the parser has found. */
+      iter = vpi_iterate(vpiModPath, cell);
       if (iter) while ( (path = vpi_scan(iter)) ) {
-	    s_vpi_delay delays;
-	    struct t_vpi_time delay_vals[12];
-	    int idx;
+	    struct sdf_path_s*cur;
 
 	    vpiHandle path_t_in = vpi_handle(vpiModPathIn,path);
 	    vpiHandle path_t_out = vpi_handle(vpiModPathOut,path);
@@ -166,18 +215,203 @@ void sdf_iopath_delays(int vpi_edge, const char*src, const char*dst,
 	    assert(vpi_get(vpiType,path_out) == vpiNet
 		   || vpi_get(vpiType,path_out) == vpiReg);
 
+	    sdf_paths = realloc(sdf_paths, (sdf_npaths+1) * sizeof *sdf_paths);
+	    cur = sdf_paths + sdf_npaths;
+	    sdf_npaths += 1;
+
+	    cur->path = path;
+	    cur->src = strdup(vpi_get_str(vpiName,path_in));
+	    cur->dst = strdup(vpi_get_str(vpiName,path_out));
+	    cur->edge = vpi_get(vpiEdge,path_t_in);
+      }
+}
+
+/*
+ * The delay cache is a record of the delays that an annotation put
+ * to each modpath, in order. When the same SDF file is annotated on
+ * the same design again, the record is played back instead of parsing
+ * the file and matching the paths. Each cell is named by its full
+ * name and each modpath by its position in the cell, since handles
+ * are not the same from one run to the next.
+ *
+ * The file starts with a magic string and a key that is a hash of the
+ * SDF file, the delay selection, the annotated scope and the size and
+ * time of the design file. After that it is a list of records:
+ *
+ *    'C' <length> <name>             select the cell
+ *    'P' <index> <count> <delays>    put delays to a modpath
+ */
+static const char sdf_cache_magic[8] = "IVLSDF1";
+static int sdf_flag_cache = 0;
+static FILE*sdf_cache_fd = 0;
+static vpiHandle sdf_cache_cell = 0;
+
+static uint64_t sdf_hash_bytes(uint64_t hash, const void*data, size_t len)
+{
+      const unsigned char*cp = (const unsigned char*)data;
+      size_t idx;
+      for (idx = 0 ; idx < len ; idx += 1) {
+	    hash ^= cp[idx];
+	    hash *= 0x100000001b3ULL;
+      }
+      return hash;
+}
+
+static uint64_t sdf_cache_key(FILE*sdf_fd)
+{
+      struct t_vpi_vlog_info vlog_info;
+      struct stat sb;
+      unsigned char buf[64*1024];
+      uint64_t hash = 0xcbf29ce484222325ULL;
+      size_t cnt;
+      const char*scope_name;
+
+      while ( (cnt = fread(buf, 1, sizeof buf, sdf_fd)) > 0)
+	    hash = sdf_hash_bytes(hash, buf, cnt);
+      rewind(sdf_fd);
+
+      hash = sdf_hash_bytes(hash, &sdf_min_typ_max, sizeof sdf_min_typ_max);
+      scope_name = vpi_get_str(vpiFullName, sdf_scope);
+      hash = sdf_hash_bytes(hash, scope_name, strlen(scope_name));
+
+      vpi_get_vlog_info(&vlog_info);
+      if (vlog_info.argc > 0 && stat(vlog_info.argv[0], &sb) == 0) {
+	    uint64_t size = sb.st_size;
+	    uint64_t mtime = sb.st_mtime;
+	    hash = sdf_hash_bytes(hash, &size, sizeof size);
+	    hash = sdf_hash_bytes(hash, &mtime, sizeof mtime);
+      }
+
+      return hash;
+}
+
+static void sdf_cache_put(unsigned index, const struct t_vpi_delay*delays)
+{
+      uint32_t idx32 = index;
+      int32_t cnt32 = delays->no_of_delays;
+      int idx;
+
+      if (sdf_cache_fd == 0)
+	    return;
+
+      if (sdf_cache_cell != sdf_paths_cell) {
+	    const char*name = vpi_get_str(vpiFullName, sdf_paths_cell);
+	    uint32_t len = strlen(name);
+	    fputc('C', sdf_cache_fd);
+	    fwrite(&len, sizeof len, 1, sdf_cache_fd);
+	    fwrite(name, 1, len, sdf_cache_fd);
+	    sdf_cache_cell = sdf_paths_cell;
+      }
+
+      fputc('P', sdf_cache_fd);
+      fwrite(&idx32, sizeof idx32, 1, sdf_cache_fd);
+      fwrite(&cnt32, sizeof cnt32, 1, sdf_cache_fd);
+      for (idx = 0 ; idx < delays->no_of_delays ; idx += 1)
+	    fwrite(&delays->da[idx].real, sizeof(double), 1, sdf_cache_fd);
+}
+
+/*
+ * Play back a delay cache. Return 0 if the cache is for some other
+ * file or design, or does not match this design after all, so that
+ * the SDF file must be annotated the slow way.
+ */
+static int sdf_cache_replay(FILE*fd, uint64_t key)
+{
+      char magic[sizeof sdf_cache_magic];
+      uint64_t file_key;
+      int code;
+
+      if (fread(magic, sizeof magic, 1, fd) != 1
+	  || memcmp(magic, sdf_cache_magic, sizeof magic) != 0)
+	    return 0;
+      if (fread(&file_key, sizeof file_key, 1, fd) != 1 || file_key != key)
+	    return 0;
+
+      while ( (code = fgetc(fd)) != EOF ) {
+	    if (code == 'C') {
+		  uint32_t len;
+		  char*name;
+		  vpiHandle cell;
+		  if (fread(&len, sizeof len, 1, fd) != 1)
+			return 0;
+		  name = malloc(len + 1);
+		  if (fread(name, 1, len, fd) != len) {
+			free(name);
+			return 0;
+		  }
+		  name[len] = 0;
+		  cell = vpi_handle_by_name(name, 0);
+		  free(name);
+		  if (cell == 0)
+			return 0;
+		  load_cell_paths(cell);
+
+	    } else if (code == 'P') {
+		  uint32_t index;
+		  int32_t count;
+		  s_vpi_delay delays;
+		  struct t_vpi_time delay_vals[12];
+		  int idx;
+		  if (fread(&index, sizeof index, 1, fd) != 1
+		      || fread(&count, sizeof count, 1, fd) != 1)
+			return 0;
+		  if (index >= sdf_npaths || count < 0 || count > 12)
+			return 0;
+
+		  delays.da = delay_vals;
+		  delays.no_of_delays = count;
+		  delays.time_type = vpiScaledRealTime;
+		  delays.mtm_flag = 0;
+		  delays.append_flag = 0;
+		  delays.plusere_flag = 0;
+		  for (idx = 0 ; idx < count ; idx += 1) {
+			delay_vals[idx].type = vpiScaledRealTime;
+			if (fread(&delay_vals[idx].real, sizeof(double), 1, fd) != 1)
+			      return 0;
+		  }
+		  vpi_put_delays(sdf_paths[index].path, &delays);
+
+	    } else {
+		  return 0;
+	    }
+      }
+
+      return 1;
+}
+
+void sdf_iopath_delays(int vpi_edge, const char*src, const char*dst,
+		       const struct sdf_delval_list_s*delval_list)
+{
+      unsigned pdx;
+      int match_count = 0;
+
+      if (sdf_cur_cell == 0)
+	    return;
+
+      if (sdf_paths_cell != sdf_cur_cell)
+	    load_cell_paths(sdf_cur_cell);
+
+	/* Search for the modpath that matches the IOPATH by looking
+	   for the modpath that uses the same ports as the ports that
+	   the parser has found. */
+      for (pdx = 0 ; pdx < sdf_npaths ; pdx += 1) {
+	    struct sdf_path_s*cur = sdf_paths + pdx;
+	    s_vpi_delay delays;
+	    struct t_vpi_time delay_vals[12];
+	    int idx;
+
 	      /* If the src name doesn't match, go on. */
-	    if (strcmp(src,vpi_get_str(vpiName,path_in)) != 0)
+	    if (strcmp(src,cur->src) != 0)
 		  continue;
 	      /* The edge type must match too. But note that if this
 	         IOPATH has no edge, then it matches with all edges of
 	         the modpath object. */
 /* --> Is this correct in the context of the 10, 01, etc. edges? */
-	    if (vpi_edge != vpiNoEdge && vpi_get(vpiEdge,path_t_in) != vpi_edge)
+	    if (vpi_edge != vpiNoEdge && cur->edge != vpi_edge)
 		  continue;
 
 	      /* If the dst name doesn't match, go on. */
-	    if (strcmp(dst,vpi_get_str(vpiName,path_out)) != 0)
+	    if (strcmp(dst,cur->dst) != 0)
 		  continue;
 
 	      /* Ah, this must be a match! */
@@ -187,7 +421,7 @@ void sdf_iopath_delays(int vpi_edge, const char*src, const char*dst,
 	    delays.mtm_flag = 0;
 	    delays.append_flag = 0;
 	    delays.plusere_flag = 0;
-	    vpi_get_delays(path, &delays);
+	    vpi_get_delays(cur->path, &delays);
 
 	    for (idx = 0 ; idx < delval_list->count ; idx += 1) {
 		  delay_vals[idx].type = vpiScaledRealTime;
@@ -196,7 +430,8 @@ void sdf_iopath_delays(int vpi_edge, const char*src, const char*dst,
 		  }
 	    }
 
-	    vpi_put_delays(path, &delays);
+	    vpi_put_delays(cur->path, &delays);
+	    sdf_cache_put(pdx, &delays);
 	    match_count += 1;
       }
 
@@ -230,6 +465,9 @@ static void check_command_line_args(void)
 	    } else if (strcmp(vlog_info.argv[idx],"-sdf-verbose") == 0) {
 		  sdf_flag_warning = 1;
 		  sdf_flag_inform = 1;
+
+	    } else if (strcmp(vlog_info.argv[idx],"-sdf-cache") == 0) {
+		  sdf_flag_cache = 1;
 	    }
       }
 
@@ -310,9 +548,54 @@ static PLI_INT32 sys_sdf_annotate_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
       sdf_cur_cell = 0;
       sdf_callh = callh;
+
+      if (sdf_flag_cache) {
+	    uint64_t key = sdf_cache_key(sdf_fd);
+	    size_t len = strlen(fname);
+	    char*cache_name = malloc(len + sizeof ".cache");
+	    FILE*cache_fd;
+	    strcpy(cache_name, fname);
+	    strcpy(cache_name + len, ".cache");
+
+	    cache_fd = fopen(cache_name, "rb");
+	    if (cache_fd) {
+		  int rc = sdf_cache_replay(cache_fd, key);
+		  fclose(cache_fd);
+		  clear_cell_paths();
+		  if (rc) {
+			if (sdf_flag_inform) {
+			      vpi_printf("SDF INFO: %s:%d: ",
+			                 vpi_get_str(vpiFile, callh),
+			                 (int)vpi_get(vpiLineNo, callh));
+			      vpi_printf("Annotated \"%s\" from the delay "
+			                 "cache \"%s\".\n", fname, cache_name);
+			}
+			free(cache_name);
+			sdf_callh = 0;
+			fclose(sdf_fd);
+			free(fname);
+			return 0;
+		  }
+	    }
+
+	    sdf_cache_fd = fopen(cache_name, "wb");
+	    if (sdf_cache_fd) {
+		  fwrite(sdf_cache_magic, sizeof sdf_cache_magic, 1, sdf_cache_fd);
+		  fwrite(&key, sizeof key, 1, sdf_cache_fd);
+	    }
+	    sdf_cache_cell = 0;
+	    free(cache_name);
+      }
+
       sdf_process_file(sdf_fd, fname);
       sdf_callh = 0;
 
+      if (sdf_cache_fd) {
+	    fclose(sdf_cache_fd);
+	    sdf_cache_fd = 0;
+      }
+      clear_cell_paths();
+
       fclose(sdf_fd);
       free(fname);
       return 0;
@@ -39,6 +39,8 @@ struct vcd_info {
       vpiHandle cb;
       struct t_vpi_time time;
       const char *ident;
+      PLI_INT32 type;
+      unsigned size;
       struct vcd_info *next;
       struct vcd_info *dmp_next;
       int scheduled;
@@ -52,6 +54,7 @@ static int dump_is_off = 0;
 static long dump_limit = 0;
 static int dump_is_full = 0;
 static int finish_status = 0;
+static int dump_is_forked = 0;
 
 
 static const char*units_names[] = {
@@ -122,6 +125,97 @@ static void show_this_item(struct vcd_info*info)
       }
 }
 
+/*
+ * Value changes are not formatted here. The raw value is sent to the
+ * work thread, which formats it the same way show_this_item() does.
+ */
+static void queue_this_item(struct vcd_info*info)
+{
+      s_vpi_value value;
+
+      if (info->type == vpiRealVar) {
+	    value.format = vpiRealVal;
+	    vpi_get_value(info->item, &value);
+	    vcd_work_emit_real(info->ident, value.value.real);
+      } else if (info->type == vpiNamedEvent) {
+	    static const s_vpi_vecval event_val = { 1, 0 };
+	    vcd_work_emit_vector(info->ident, 1, &event_val);
+      } else {
+	    value.format = vpiVectorVal;
+	    vpi_get_value(info->item, &value);
+	    vcd_work_emit_vector(info->ident, info->size, value.value.vector);
+      }
+}
+
+static char *vcd_bits_buf = 0;
+static unsigned vcd_bits_size = 0;
+
+static void emit_vector(const struct vcd_work_item_s*cell)
+{
+      const s_vpi_vecval*val = cell->wid > 32? cell->op_.val_vector
+                                             : &cell->op_.val_word;
+      unsigned idx;
+      char*cp;
+
+      if (cell->wid+1 > vcd_bits_size) {
+	    vcd_bits_size = cell->wid+1;
+	    vcd_bits_buf = realloc(vcd_bits_buf, vcd_bits_size);
+      }
+
+	/* The aval/bval pairs 00, 10, 01 and 11 are 0, 1, z and x. */
+      cp = vcd_bits_buf;
+      for (idx = cell->wid ; idx > 0 ; idx -= 1) {
+	    unsigned word = (idx-1) / 32;
+	    unsigned bit = (idx-1) % 32;
+	    unsigned code = ((val[word].aval >> bit) & 1)
+	                  | (((val[word].bval >> bit) & 1) << 1);
+	    *cp++ = "01zx"[code];
+      }
+      *cp = 0;
+
+      if (cell->wid == 1)
+	    fprintf(dump_file, "%s%s\n", vcd_bits_buf, cell->sym_.ident);
+      else
+	    fprintf(dump_file, "b%s %s\n", truncate_bitvec(vcd_bits_buf),
+		    cell->sym_.ident);
+}
+
+static void* vcd_thread(void*arg)
+{
+      int run_flag = 1;
+      while (run_flag) {
+	    struct vcd_work_item_s*cell = vcd_work_thread_peek();
+
+	    switch (cell->type) {
+		case WT_EMIT_TIME:
+		  fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", cell->time);
+		  break;
+		case WT_EMIT_DOUBLE:
+		  fprintf(dump_file, "r%.16g %s\n", cell->op_.val_double,
+			  cell->sym_.ident);
+		  break;
+		case WT_EMIT_VECTOR:
+		  emit_vector(cell);
+		  break;
+		case WT_FLUSH:
+		  fflush(dump_file);
+		  break;
+		case WT_TERMINATE:
+		  run_flag = 0;
+		  break;
+		default:
+		  break;
+	    }
+
+	    vcd_work_thread_pop();
+      }
+
+      free(vcd_bits_buf);
+      vcd_bits_buf = 0;
+      vcd_bits_size = 0;
+      return 0;
+}
+
 /* Dump values for a $dumpoff. */
 static void show_this_item_x(struct vcd_info*info)
 {
@@ -181,12 +275,13 @@ static PLI_INT32 variable_cb_2(p_cb_data cause)
       PLI_UINT64 now = timerec_to_time64(cause->time);
 
       if (now != vcd_cur_time) {
-	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now);
+	    vcd_work_set_time(now);
+	    vcd_work_emit_time();
 	    vcd_cur_time = now;
       }
 
       do {
-           show_this_item(info);
+           queue_this_item(info);
            info->scheduled = 0;
       } while ((info = info->dmp_next) != 0);
 
@@ -195,24 +290,82 @@ static PLI_INT32 variable_cb_2(p_cb_data cause)
       return 0;
 }
 
+/*
+ * Check the $dumplimit before a value is dumped. The size of the file
+ * is only known once the work thread has written out what it has.
+ */
+static int dump_limit_exceeded(void)
+{
+      if (dump_limit <= 0) return 0;
+
+      vcd_work_sync();
+      if (ftell(dump_file) > dump_limit) {
+            dump_is_full = 1;
+            vpi_printf("WARNING: Dump file limit (%ld bytes) "
+                               "exceeded.\n", dump_limit);
+            fprintf(dump_file, "$comment Dump file limit (%ld bytes) "
+                               "exceeded. $end\n", dump_limit);
+            return 1;
+      }
+      return 0;
+}
+
+/*
+ * Most signals are followed by the value-change recorder of the run
+ * time instead of a callback. It hands over the final values of the
+ * signals that changed at the end of each time step, like
+ * variable_cb_2 does for the others.
+ */
+static struct vcd_info **vcd_record_tab = 0;
+static unsigned vcd_record_cnt = 0;
+
+static void vcd_record_cb(PLI_INT32 id, PLI_UINT64 now, PLI_UINT32 wid,
+			  const s_vpi_vecval*val, void*user)
+{
+      struct vcd_info*info = vcd_record_tab[id];
+      (void) user;  /* Unused argument. */
+
+      if (dump_is_forked) return;
+      if (dump_is_full) return;
+      if (dump_is_off) return;
+      if (dump_header_pending()) return;
+	/* The $dumpvars values are taken after the changes of the
+	   time step of the header, so those are already dumped. */
+      if (now == dumpvars_time) return;
+      if (dump_limit_exceeded()) return;
+
+      if (now != vcd_cur_time) {
+	    vcd_work_set_time(now);
+	    vcd_work_emit_time();
+	    vcd_cur_time = now;
+      }
+
+      vcd_work_emit_vector(info->ident, wid, val);
+}
+
+static int vcd_record_add(struct vcd_info*info)
+{
+      if (! vpip_record_signal(info->item, vcd_record_cnt,
+                               vcd_record_cb, 0)) return 0;
+
+      vcd_record_tab = realloc(vcd_record_tab,
+                               (vcd_record_cnt+1)*sizeof(struct vcd_info*));
+      vcd_record_tab[vcd_record_cnt] = info;
+      vcd_record_cnt += 1;
+      return 1;
+}
+
 static PLI_INT32 variable_cb_1(p_cb_data cause)
 {
       struct t_cb_data cb;
       struct vcd_info*info = (struct vcd_info*)cause->user_data;
 
+      if (dump_is_forked) return 0;
       if (dump_is_full) return 0;
       if (dump_is_off) return 0;
       if (dump_header_pending()) return 0;
       if (info->scheduled) return 0;
-
-      if ((dump_limit > 0) && (ftell(dump_file) > dump_limit)) {
-            dump_is_full = 1;
-            vpi_printf("WARNING: Dump file limit (%ld bytes) "
-                               "exceeded.\n", dump_limit);
-            fprintf(dump_file, "$comment Dump file limit (%ld bytes) "
-                               "exceeded. $end\n", dump_limit);
-            return 0;
-      }
+      if (dump_limit_exceeded()) return 0;
 
       if (!vcd_dmp_list) {
           cb = *cause;
@@ -259,6 +412,9 @@ static PLI_INT32 finish_cb(p_cb_data cause)
 
       dumpvars_time = timerec_to_time64(cause->time);
 
+      vpip_record_stop(vcd_record_cb, 0);
+      vcd_work_terminate();
+
       if (!dump_is_off && !dump_is_full && dumpvars_time != vcd_cur_time) {
 	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", dumpvars_time);
       }
@@ -271,6 +427,9 @@ static PLI_INT32 finish_cb(p_cb_data cause)
 	    free(cur);
       }
       vcd_list = 0;
+      free(vcd_record_tab);
+      vcd_record_tab = 0;
+      vcd_record_cnt = 0;
       vcd_names_delete(&vcd_tab);
       vcd_names_delete(&vcd_var);
       nexus_ident_delete();
@@ -280,6 +439,41 @@ static PLI_INT32 finish_cb(p_cb_data cause)
       return 0;
 }
 
+/*
+ * The run time forks a copy of the simulation for each test of a
+ * checkpoint, and the original simulation stops at the checkpoint
+ * without calling the end of simulation callbacks. The forks do not
+ * dump, so the dump ends at the checkpoint. Finish the file before
+ * the fork.
+ */
+static PLI_INT32 save_cb(p_cb_data cause)
+{
+      struct t_cb_data cb;
+      struct t_vpi_time now;
+
+      (void) cause;  /* Unused argument. */
+      if (dump_file == 0) return 0;
+
+      now.type = vpiSimTime;
+      vpi_get_time(0, &now);
+      cb.time = &now;
+      finish_cb(&cb);
+      dump_file = 0;
+      return 0;
+}
+
+/*
+ * The dump file was finished before the fork, so a fork of a
+ * checkpoint stops dumping for good, and a later $dumpvars does not
+ * open a new file.
+ */
+static PLI_INT32 restart_cb(p_cb_data cause)
+{
+      (void) cause;  /* Unused argument. */
+      dump_is_forked = 1;
+      return 0;
+}
+
 __inline__ static int install_dumpvars_callback(void)
 {
       struct t_cb_data cb;
@@ -324,6 +518,8 @@ static PLI_INT32 sys_dumpoff_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       if (dump_file == 0) return 0;
       if (dump_header_pending()) return 0;
 
+      vcd_work_sync();
+
       now.type = vpiSimTime;
       vpi_get_time(0, &now);
       now64 = timerec_to_time64(&now);
@@ -352,6 +548,8 @@ static PLI_INT32 sys_dumpon_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       if (dump_file == 0) return 0;
       if (dump_header_pending()) return 0;
 
+      vcd_work_sync();
+
       now.type = vpiSimTime;
       vpi_get_time(0, &now);
       now64 = timerec_to_time64(&now);
@@ -377,6 +575,8 @@ static PLI_INT32 sys_dumpall_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       if (dump_file == 0) return 0;
       if (dump_header_pending()) return 0;
 
+      vcd_work_sync();
+
       now.type = vpiSimTime;
       vpi_get_time(0, &now);
       now64 = timerec_to_time64(&now);
@@ -395,6 +595,13 @@ static PLI_INT32 sys_dumpall_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
 static void open_dumpfile(vpiHandle callh)
 {
+      if (dump_is_forked) {
+	    vpi_printf("VCD warning: %s:%d: ", vpi_get_str(vpiFile, callh),
+	               (int)vpi_get(vpiLineNo, callh));
+	    vpi_printf("Dumping is disabled in the tests of a checkpoint.\n");
+	    return;
+      }
+
       if (dump_path == 0) dump_path = strdup("dump.vcd");
 
       dump_file = fopen(dump_path, "w");
@@ -435,6 +642,8 @@ static void open_dumpfile(vpiHandle callh)
 	    fprintf(dump_file, "$timescale\n");
 	    fprintf(dump_file, "\t%u%s\n", scale, units_names[udx]);
 	    fprintf(dump_file, "$end\n");
+
+	    vcd_work_start(vcd_thread, 0);
       }
 }
 
@@ -475,7 +684,10 @@ static PLI_INT32 sys_dumpfile_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
 static PLI_INT32 sys_dumpflush_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
-      if (dump_file) fflush(dump_file);
+      if (dump_file) {
+	    vcd_work_sync();
+	    fflush(dump_file);
+      }
 
       return 0;
 }
@@ -617,6 +829,12 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 	      /* Some signals can have an alias so handle that. */
 	    nexus_id = vpi_get(_vpiNexusId, item);
 
+	      /* Named events do not have a size, but other tools use
+	       * a size of 1 and some viewers do not accept a width of
+	       * zero so we will also use a width of one for events. */
+	    if (item_type == vpiNamedEvent) size = 1;
+	    else size = vpi_get(vpiSize, item);
+
 	    ident = 0;
 	    if (nexus_id) ident = find_nexus_ident(nexus_id);
 
@@ -632,6 +850,8 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 		  info->time.type = vpiSimTime;
 		  info->item  = item;
 		  info->ident = ident;
+		  info->type  = vpi_get(vpiType, item);
+		  info->size  = size;
 		  info->scheduled = 0;
 
 		  cb.time      = &info->time;
@@ -645,15 +865,10 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 		  info->next  = vcd_list;
 		  vcd_list    = info;
 
-		  info->cb    = vpi_register_cb(&cb);
+		  if (vcd_record_add(info)) info->cb = 0;
+		  else info->cb = vpi_register_cb(&cb);
 	    }
 
-	      /* Named events do not have a size, but other tools use
-	       * a size of 1 and some viewers do not accept a width of
-	       * zero so we will also use a width of one for events. */
-	    if (item_type == vpiNamedEvent) size = 1;
-	    else size = vpi_get(vpiSize, item);
-
 	    fprintf(dump_file, "$var %s %u %s %s%s",
 		    type, size, ident, prefix, name);
 
@@ -858,6 +1073,7 @@ static PLI_INT32 sys_dumpvars_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 void sys_vcd_register()
 {
       s_vpi_systf_data tf_data;
+      struct t_cb_data cb;
       vpiHandle res;
 
       /* All the compiletf routines are located in vcd_priv.c. */
@@ -924,4 +1140,15 @@ void sys_vcd_register()
       tf_data.user_data = "$dumpvars";
       res = vpi_register_systf(&tf_data);
       vpip_make_systf_system_defined(res);
+
+      cb.reason = cbStartOfSave;
+      cb.time = 0;
+      cb.cb_rtn = save_cb;
+      cb.user_data = 0;
+      cb.obj = 0;
+      vpi_register_cb(&cb);
+
+      cb.reason = cbEndOfRestart;
+      cb.cb_rtn = restart_cb;
+      vpi_register_cb(&cb);
 }
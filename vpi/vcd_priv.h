@@ -71,6 +71,8 @@ typedef enum vcd_work_item_type_e {
       WT_NONE,
       WT_EMIT_BITS,
       WT_EMIT_DOUBLE,
+      WT_EMIT_VECTOR,
+      WT_EMIT_TIME,
       WT_DUMPON,
       WT_DUMPOFF,
       WT_FLUSH,
@@ -84,11 +86,17 @@ struct vcd_work_item_s {
       uint64_t time;
       union {
 	    struct lxt2_wr_symbol*lxt2;
+	    const char*ident;
       } sym_;
 
+	/* The width of a WT_EMIT_VECTOR value. Values up to 32 bits
+	   wide are kept in val_word, wider values in val_vector. */
+      unsigned wid;
       union {
 	    double val_double;
 	    char*val_char;
+	    s_vpi_vecval val_word;
+	    s_vpi_vecval*val_vector;
       } op_;
 };
 
@@ -126,6 +134,17 @@ EXTERN void vcd_work_dumpoff(void);
 EXTERN void vcd_work_emit_double(struct lxt2_wr_symbol*sym, double val);
 EXTERN void vcd_work_emit_bits(struct lxt2_wr_symbol*sym, const char*bits);
 
+/*
+ * The VCD dumper sends the raw values of the signals, and the work
+ * thread formats them. WT_EMIT_DOUBLE items from the VCD dumper use
+ * the ident instead of the lxt2 symbol. vcd_work_emit_time emits the
+ * time set by vcd_work_set_time.
+ */
+EXTERN void vcd_work_emit_time(void);
+EXTERN void vcd_work_emit_real(const char*ident, double val);
+EXTERN void vcd_work_emit_vector(const char*ident, unsigned wid,
+				 const s_vpi_vecval*val);
+
 /* The compiletf routines are common for the VCD, LXT and LXT2 dumpers. */
 EXTERN PLI_INT32 sys_dumpvars_compiletf(ICARUS_VPI_CONST PLI_BYTE8 *name);
 
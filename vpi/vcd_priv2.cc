@@ -128,6 +128,8 @@ extern "C" void vcd_work_thread_pop(void)
       struct vcd_work_item_s*cell = work_queue + use_next;
       if (cell->type == WT_EMIT_BITS) {
 	    free(cell->op_.val_char);
+      } else if (cell->type == WT_EMIT_VECTOR && cell->wid > 32) {
+	    free(cell->op_.val_vector);
       }
 
       use_next += 1;
@@ -155,8 +157,56 @@ static unsigned current_batch_cnt = 0;
 static unsigned current_batch_alloc = 0;
 static unsigned current_batch_base = 0;
 
+static void* (*work_fun) (void*) = 0;
+static void* work_arg = 0;
+
+#if !defined(__MINGW32__)
+/*
+ * The work thread does not survive a fork, so drain the queue before
+ * the fork. The writer and the file it writes belong to the parent,
+ * so the child does not start a new work thread: it drops the writer
+ * and starts over with an empty queue, as if vcd_work_start() had
+ * never been called. The dumper must not queue more work in the
+ * child, and the run time tells it to stop dumping there (see the
+ * cbEndOfRestart callbacks of the dumpers). The waits of the old
+ * thread are still recorded in the mutex and conditions, so the
+ * child also needs fresh ones.
+ */
+static void work_atfork_prepare(void)
+{
+      if (work_fun) vcd_work_sync();
+}
+
+static void work_atfork_child(void)
+{
+      if (work_fun == 0) return;
+
+      pthread_mutex_init(&work_queue_mutex, 0);
+      pthread_cond_init(&work_queue_is_empty_sig, 0);
+      pthread_cond_init(&work_queue_notempty_sig, 0);
+      pthread_cond_init(&work_queue_minfree_sig, 0);
+
+      work_queue_next = 0;
+      work_queue_fill = 0;
+      current_batch_cnt = 0;
+      current_batch_alloc = 0;
+      current_batch_base = 0;
+      work_fun = 0;
+      work_arg = 0;
+}
+#endif
+
 extern "C" void vcd_work_start( void* (*fun) (void*), void*arg )
 {
+#if !defined(__MINGW32__)
+      static bool atfork_flag = false;
+      if (! atfork_flag) {
+	    pthread_atfork(work_atfork_prepare, 0, work_atfork_child);
+	    atfork_flag = true;
+      }
+#endif
+      work_fun = fun;
+      work_arg = arg;
       pthread_create(&work_thread, 0, fun, arg);
 }
 
@@ -219,6 +269,8 @@ static inline void unlock_item(bool flush_batch =false)
 
 extern "C" void vcd_work_sync(void)
 {
+      if (work_fun == 0) return;
+
       if (current_batch_alloc > 0)
 	    end_batch();
 
@@ -276,10 +328,48 @@ extern "C" void vcd_work_emit_bits(struct lxt2_wr_symbol*sym, const char* val)
       unlock_item();
 }
 
+extern "C" void vcd_work_emit_time(void)
+{
+      struct vcd_work_item_s*cell = grab_item();
+      cell->type = WT_EMIT_TIME;
+      unlock_item();
+}
+
+extern "C" void vcd_work_emit_real(const char*ident, double val)
+{
+      struct vcd_work_item_s*cell = grab_item();
+      cell->type = WT_EMIT_DOUBLE;
+      cell->sym_.ident = ident;
+      cell->op_.val_double = val;
+      unlock_item();
+}
+
+extern "C" void vcd_work_emit_vector(const char*ident, unsigned wid,
+				     const s_vpi_vecval*val)
+{
+      struct vcd_work_item_s*cell = grab_item();
+      cell->type = WT_EMIT_VECTOR;
+      cell->sym_.ident = ident;
+      cell->wid = wid;
+      if (wid <= 32) {
+	    cell->op_.val_word = val[0];
+      } else {
+	    size_t size = (wid+31)/32 * sizeof(s_vpi_vecval);
+	    cell->op_.val_vector = (s_vpi_vecval*)malloc(size);
+	    memcpy(cell->op_.val_vector, val, size);
+      }
+      unlock_item();
+}
+
 extern "C" void vcd_work_terminate(void)
 {
+	// There is no work thread before vcd_work_start(), or in the
+	// child of a fork.
+      if (work_fun == 0) return;
+
       struct vcd_work_item_s*cell = grab_item();
       cell->type = WT_TERMINATE;
       unlock_item(true);
       pthread_join(work_thread, 0);
+      work_fun = 0;
 }
@@ -636,6 +636,39 @@ extern void vpip_make_systf_system_defined(vpiHandle ref);
 extern void vpip_count_drivers(vpiHandle ref, unsigned idx,
                                unsigned counts[4]);
 
+  /* Record the value changes of vector signals without a value change
+     callback for each signal. vpip_record_signal adds a signal with
+     an id chosen by the caller, and the function and user pointer
+     that receive its changes. It returns 0 if the signal can not be
+     recorded, for example a real, an array word, an automatic
+     variable or a signal that another caller already records, and
+     the caller must use a cbValueChange callback for it instead. At
+     the end of each time step, in the read-only synch region, the
+     function is called once for each recorded signal that changed,
+     with the simulation time and the final value in vpiVectorVal
+     form. The signal that changed last in the time step comes first.
+     vpip_record_stop stops all the signals recorded with the given
+     function and user pointer. */
+typedef void (*vpip_record_fun)(PLI_INT32 id, PLI_UINT64 time,
+                                PLI_UINT32 wid, const s_vpi_vecval*val,
+                                void*user);
+extern PLI_INT32 vpip_record_signal(vpiHandle ref, PLI_INT32 id,
+                                    vpip_record_fun fun, void*user);
+extern void vpip_record_stop(vpip_record_fun fun, void*user);
+
+  /* Put or get the count words of the memory ref from the word at
+     index first on, all at once. The words are in vpiVectorVal form,
+     each in (width+31)/32 s_vpi_vecval, one word after the other.
+     The value change callbacks of the words that are put run as
+     usual. These return the count, or -1 if the memory can not be
+     accessed this way (a net, real or automatic array) or the range
+     is not in the memory, and then the caller must put or get each
+     word through its handle instead. */
+extern PLI_INT32 vpip_put_words(vpiHandle ref, PLI_INT32 first,
+                                PLI_UINT32 count, const s_vpi_vecval*words);
+extern PLI_INT32 vpip_get_words(vpiHandle ref, PLI_INT32 first,
+                                PLI_UINT32 count, s_vpi_vecval*words);
+
 /*
  * Stopgap fix for br916. We need to reject any attempt to pass a thread
  * variable to $strobe or $monitor. To do this, we use some private VPI
@@ -1055,6 +1055,115 @@ void array_set_word(vvp_array_t arr, unsigned address, const string&val)
       array_word_change(arr, address);
 }
 
+/*
+ * The vpip_put_words and vpip_get_words functions copy a range of
+ * words of a statically allocated vector array in vpiVectorVal form,
+ * one (wid+31)/32 group of s_vpi_vecval per word. They go straight
+ * to the word storage, without a handle and a vvp_vector4_t for each
+ * word, which is what makes $readmem and $writemem of big memories
+ * fast. Net, real and automatic arrays return -1 so that the caller
+ * can fall back to a vpi_put_value or vpi_get_value per word.
+ */
+static vvp_vector4array_sa* array_bulk_words(struct __vpiArray*arr,
+					     PLI_INT32 first, PLI_UINT32 count,
+					     unsigned&base)
+{
+      if (arr == 0 || arr->vals4 == 0)
+	    return 0;
+
+      vvp_vector4array_sa*vals4 = dynamic_cast<vvp_vector4array_sa*>(arr->vals4);
+      if (vals4 == 0)
+	    return 0;
+
+      long tmp = (long)first - arr->first_addr.value;
+      if (tmp < 0 || (unsigned long)tmp + count > arr->array_count)
+	    return 0;
+
+      base = tmp;
+      return vals4;
+}
+
+extern "C" PLI_INT32 vpip_put_words(vpiHandle ref, PLI_INT32 first,
+				    PLI_UINT32 count, const s_vpi_vecval*words)
+{
+      struct __vpiArray*arr = dynamic_cast<__vpiArray*>(ref);
+      unsigned base;
+      vvp_vector4array_sa*vals4 = array_bulk_words(arr, first, count, base);
+      if (vals4 == 0)
+	    return -1;
+
+      const unsigned BPW = 8*sizeof(unsigned long);
+      unsigned wid = vals4->width();
+      unsigned vcnt = (wid + 31) / 32;
+      unsigned lcnt = (wid + BPW - 1) / BPW;
+      unsigned long*abits = new unsigned long[2*lcnt];
+      unsigned long*bbits = abits + lcnt;
+
+	// The bits past the width of the word are kept X, the same as
+	// in a new vvp_vector4_t.
+      unsigned long tail = 0;
+      if (wid % BPW)
+	    tail = ~0UL << (wid % BPW);
+
+      for (unsigned idx = 0 ; idx < count ; idx += 1) {
+	    const s_vpi_vecval*src = words + idx*vcnt;
+	    for (unsigned wdx = 0 ; wdx < lcnt ; wdx += 1) {
+		  abits[wdx] = 0;
+		  bbits[wdx] = 0;
+	    }
+	    for (unsigned vdx = 0 ; vdx < vcnt ; vdx += 1) {
+		  unsigned off = vdx*32;
+		  abits[off/BPW] |= (unsigned long)(PLI_UINT32)src[vdx].aval << off%BPW;
+		  bbits[off/BPW] |= (unsigned long)(PLI_UINT32)src[vdx].bval << off%BPW;
+	    }
+	    abits[lcnt-1] |= tail;
+	    bbits[lcnt-1] |= tail;
+
+	    vals4->set_word_bits(base+idx, abits, bbits);
+	    array_word_change(arr, base+idx);
+      }
+
+      delete[]abits;
+      return count;
+}
+
+extern "C" PLI_INT32 vpip_get_words(vpiHandle ref, PLI_INT32 first,
+				    PLI_UINT32 count, s_vpi_vecval*words)
+{
+      struct __vpiArray*arr = dynamic_cast<__vpiArray*>(ref);
+      unsigned base;
+      vvp_vector4array_sa*vals4 = array_bulk_words(arr, first, count, base);
+      if (vals4 == 0)
+	    return -1;
+
+      const unsigned BPW = 8*sizeof(unsigned long);
+      unsigned wid = vals4->width();
+      unsigned vcnt = (wid + 31) / 32;
+      unsigned lcnt = (wid + BPW - 1) / BPW;
+      unsigned long*abits = new unsigned long[2*lcnt];
+      unsigned long*bbits = abits + lcnt;
+
+	// Mask of the bits of the last s_vpi_vecval that are in the word.
+      PLI_UINT32 mask = 0xffffffff;
+      if (wid % 32)
+	    mask = (1U << (wid % 32)) - 1;
+
+      for (unsigned idx = 0 ; idx < count ; idx += 1) {
+	    s_vpi_vecval*dst = words + idx*vcnt;
+	    vals4->get_word_bits(base+idx, abits, bbits);
+	    for (unsigned vdx = 0 ; vdx < vcnt ; vdx += 1) {
+		  unsigned off = vdx*32;
+		  dst[vdx].aval = (PLI_UINT32)(abits[off/BPW] >> off%BPW);
+		  dst[vdx].bval = (PLI_UINT32)(bbits[off/BPW] >> off%BPW);
+	    }
+	    dst[vcnt-1].aval &= mask;
+	    dst[vcnt-1].bval &= mask;
+      }
+
+      delete[]abits;
+      return count;
+}
+
 vvp_vector4_t array_get_word(vvp_array_t arr, unsigned address)
 {
       if (arr->vals4) {
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2026 The Icarus Verilog contributors
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "checkpoint.h"
+# include  "vpi_priv.h"
+# include  <cstdio>
+# include  <cstdlib>
+# include  <cstring>
+# include  <string>
+# include  <vector>
+# include  <map>
+#if !defined(__MINGW32__)
+# include  <unistd.h>
+# include  <sys/types.h>
+# include  <sys/wait.h>
+#endif
+
+extern void vpiStartOfSave(void);
+extern void vpiEndOfRestart(void);
+
+bool vvp_checkpoint_flag = false;
+vvp_time64_t vvp_checkpoint_time = 0;
+
+struct checkpoint_test_s {
+      std::string name;
+      std::vector<std::string> args;
+};
+
+static std::vector<checkpoint_test_s> checkpoint_tests;
+
+bool vvp_checkpoint_set(const char*arg)
+{
+#if defined(__MINGW32__)
+      fprintf(stderr, "Checkpoints are not supported on this system.\n");
+      return false;
+#else
+      const char*path = strchr(arg, ':');
+      if (path == 0 || path == arg)
+	    return false;
+
+      char*ep;
+      vvp_time64_t time = strtoull(arg, &ep, 10);
+      if (ep != path)
+	    return false;
+      path += 1;
+
+      FILE*fd = fopen(path, "r");
+      if (fd == 0) {
+	    perror(path);
+	    return false;
+      }
+
+	/* Each line is a test name and its plusargs. Blank lines and
+	   lines that start with a '#' are skipped. */
+      char line[4096];
+      while (fgets(line, sizeof line, fd)) {
+	    checkpoint_test_s test;
+	    for (char*cp = strtok(line, " \t\r\n") ; cp
+		       ; cp = strtok(0, " \t\r\n")) {
+		  if (! test.name.empty())
+			test.args.push_back(cp);
+		  else if (cp[0] == '#')
+			break;
+		  else
+			test.name = cp;
+	    }
+	    if (! test.name.empty())
+		  checkpoint_tests.push_back(test);
+      }
+      fclose(fd);
+
+      if (checkpoint_tests.empty()) {
+	    fprintf(stderr, "%s: No tests to run from the checkpoint.\n", path);
+	    return false;
+      }
+
+      vvp_checkpoint_time = time;
+      vvp_checkpoint_flag = true;
+      return true;
+#endif
+}
+
+#if !defined(__MINGW32__)
+/*
+ * This is the fork side of the checkpoint. Add the plusargs of the
+ * test to the arguments, and send the output to the log of the test.
+ */
+static void checkpoint_start_test(const checkpoint_test_s&test)
+{
+      static std::vector<char*> argv;
+
+      s_vpi_vlog_info info;
+      vpi_get_vlog_info(&info);
+      for (int idx = 0 ; idx < info.argc ; idx += 1)
+	    argv.push_back(info.argv[idx]);
+      for (size_t idx = 0 ; idx < test.args.size() ; idx += 1)
+	    argv.push_back(strdup(test.args[idx].c_str()));
+      argv.push_back(0);
+      vpip_set_vlog_args(argv.size()-1, &argv[0]);
+
+      std::string log = test.name + ".log";
+      if (freopen(log.c_str(), "w", stdout) == 0) {
+	    perror(log.c_str());
+	    exit(1);
+      }
+      dup2(fileno(stdout), fileno(stderr));
+}
+
+bool vvp_checkpoint_fork(void)
+{
+      vvp_checkpoint_flag = false;
+
+      if (const char*name = vpip_mcd_open_file()) {
+	    fprintf(stderr, "vvp error: The checkpoint cannot be taken while "
+		    "%s is open. The simulation runs on without it.\n", name);
+	    vpip_set_return_value(1);
+	    return true;
+      }
+
+      long max_running = sysconf(_SC_NPROCESSORS_ONLN);
+      if (max_running < 1)
+	    max_running = 1;
+
+	/* Anything still buffered would be written again by each of
+	   the forks. The save callbacks let the dumpers finish their
+	   files first, since the dumps end here. */
+      vpiStartOfSave();
+      fflush(0);
+
+      std::map<pid_t,size_t> running;
+      unsigned failed = 0;
+      size_t next = 0;
+      while (next < checkpoint_tests.size() || ! running.empty()) {
+
+	    if (next < checkpoint_tests.size()
+		&& (long)running.size() < max_running) {
+		  pid_t pid = fork();
+		  if (pid == 0) {
+			checkpoint_start_test(checkpoint_tests[next]);
+			checkpoint_tests.clear();
+			vpip_mcd_fork_child();
+			vpiEndOfRestart();
+			return true;
+		  }
+		  if (pid < 0) {
+			perror("fork");
+			failed += 1;
+		  } else {
+			running[pid] = next;
+		  }
+		  next += 1;
+		  continue;
+	    }
+
+	    int status;
+	    pid_t pid = wait(&status);
+	    if (pid < 0) {
+		  perror("wait");
+		  break;
+	    }
+
+	    std::map<pid_t,size_t>::iterator cur = running.find(pid);
+	    if (cur == running.end())
+		  continue;
+
+	    const checkpoint_test_s&test = checkpoint_tests[cur->second];
+	    if (! WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		  fprintf(stderr, "vvp: Test %s from the checkpoint failed.\n",
+			  test.name.c_str());
+		  failed += 1;
+	    }
+	    running.erase(cur);
+      }
+
+      fprintf(stderr, "vvp: Ran %u test(s) from the checkpoint at time "
+	      "%llu, %u failed.\n", (unsigned)checkpoint_tests.size(),
+	      (unsigned long long)vvp_checkpoint_time, failed);
+      if (failed)
+	    vpip_set_return_value(1);
+      return false;
+}
+#else
+bool vvp_checkpoint_fork(void)
+{
+      vvp_checkpoint_flag = false;
+      return true;
+}
+#endif
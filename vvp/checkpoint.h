@@ -0,0 +1,75 @@
+#ifndef __checkpoint_H
+#define __checkpoint_H
+/*
+ * Copyright (c) 2026 The Icarus Verilog contributors
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+
+/*
+ * A checkpoint runs the simulation up to a time, then forks a copy
+ * of the whole process for each test in a list. The copies start
+ * from the same simulation state, each with its own plusargs and its
+ * own log of the standard output, and the original waits for them
+ * all to finish. The state is never written out: the forked process
+ * image is the checkpoint, so every net, thread, event and VPI
+ * callback is restored exactly.
+ *
+ * This is not a $save and $restart. The checkpoint only lives as
+ * long as the process that reached it, so it cannot be restarted
+ * later or by another run, and there are a few limits:
+ *
+ *   - The checkpoint is not taken while a file that $fopen opened is
+ *     still open, since the forks would share it.
+ *
+ *   - The dumpers finish their files at the checkpoint, from the
+ *     cbStartOfSave callbacks, and the forks do not dump at all.
+ *
+ *   - The original simulation stops at the checkpoint once the forks
+ *     are done. It does not run its final blocks or the end of
+ *     simulation callbacks, since its state is that of the
+ *     checkpoint and not the end of a simulation.
+ *
+ * The argument is "time:file", where the time is in units of the
+ * simulation precision and each line of the file is a test name
+ * followed by its plusargs. Return false if the argument or the
+ * file is not valid.
+ */
+extern bool vvp_checkpoint_set(const char*arg);
+
+  /* True until the checkpoint is taken. */
+extern bool vvp_checkpoint_flag;
+extern vvp_time64_t vvp_checkpoint_time;
+
+/*
+ * The scheduler calls this when the simulation is about to advance
+ * to or past the checkpoint time. It returns true in each of the
+ * forks, with vvp_checkpoint_flag clear, after the fork has run the
+ * cbEndOfRestart callbacks. The original process runs the
+ * cbStartOfSave callbacks, waits for the forks and returns false,
+ * and the scheduler then stops at once, without the final blocks
+ * and the cbEndOfSimulation callbacks. The return value of vvp is 1
+ * if any of the forks failed.
+ *
+ * If a file that $fopen opened is still open, the checkpoint is
+ * refused with an error. This returns true, and the simulation runs
+ * on as if there were no checkpoint, but vvp still returns 1.
+ */
+extern bool vvp_checkpoint_fork(void);
+
+#endif // __checkpoint_H
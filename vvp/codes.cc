@@ -96,6 +96,31 @@ vvp_code_t codespace_null(void)
       return first_chunk + 0;
 }
 
+void codespace_fuse(void)
+{
+      for (vvp_code_t cur = first_chunk ; cur ; ) {
+	    vvp_code_t next = cur[code_chunk_size-1].cptr;
+	      /* The last chunk is only filled up to the next free
+		 instruction. */
+	    unsigned end = next? code_chunk_size : current_within_chunk;
+
+	    for (unsigned idx = 0 ; idx+1 < end ; idx += 1) {
+		  vvp_code_fun fused = vthread_fused_opcode(cur[idx].opcode,
+							    cur[idx+1].opcode);
+		  if (fused == 0)
+			continue;
+
+		    /* Leave the second opcode alone, so that it is
+		       still there for the fused opcode to call. */
+		  cur[idx].opcode = fused;
+		  count_opcodes_fused += 1;
+		  idx += 1;
+	    }
+
+	    cur = next;
+      }
+}
+
 #ifdef CHECK_WITH_VALGRIND
 void codespace_delete(void)
 {
@@ -115,6 +140,8 @@ void codespace_delete(void)
 			vpi_call_delete((cur+idx)->handle);
 		  } else if ((cur+idx)->opcode == &of_EXEC_UFUNC) {
 			exec_ufunc_delete((cur+idx));
+		  } else if ((cur+idx)->opcode == &of_CASE_TABLE) {
+			case_table_delete((cur+idx));
 		  } else if ((cur+idx)->opcode == &of_FILE_LINE) {
 			delete((cur+idx)->handle);
 		  } else if (((cur+idx)->opcode == &of_CONCATI_STR) ||
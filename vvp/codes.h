@@ -60,6 +60,7 @@ extern bool of_ASSIGN_X0(vthread_t thr, vvp_code_t code);
 extern bool of_BLEND(vthread_t thr, vvp_code_t code);
 extern bool of_BLEND_WR(vthread_t thr, vvp_code_t code);
 extern bool of_BREAKPOINT(vthread_t thr, vvp_code_t code);
+extern bool of_CASE_U(vthread_t thr, vvp_code_t code);
 extern bool of_CASSIGN_LINK(vthread_t thr, vvp_code_t code);
 extern bool of_CASSIGN_V(vthread_t thr, vvp_code_t code);
 extern bool of_CASSIGN_WR(vthread_t thr, vvp_code_t code);
@@ -217,6 +218,8 @@ extern bool of_XORR(vthread_t thr, vvp_code_t code);
 
 extern bool of_ZOMBIE(vthread_t thr, vvp_code_t code);
 
+extern bool of_CASE_TABLE(vthread_t thr, vvp_code_t code);
+
 extern bool of_EXEC_UFUNC(vthread_t thr, vvp_code_t code);
 extern bool of_REAP_UFUNC(vthread_t thr, vvp_code_t code);
 
@@ -236,6 +239,7 @@ struct vvp_code_s {
 	    class __vpiHandle*handle;
 	    struct __vpiScope*scope;
 	    const char*text;
+	    struct vvp_case_table_s*case_table;
       };
 
       union {
@@ -264,4 +268,15 @@ extern vvp_code_t codespace_allocate(void);
 extern vvp_code_t codespace_next(void);
 extern vvp_code_t codespace_null(void);
 
+/*
+ * Replace the opcode of the first instruction of pairs that are
+ * commonly emitted together with a fused opcode that runs both. This
+ * is done once, after the compile is complete. The vthread.cc file
+ * knows which pairs can be fused, and vthread_fused_opcode returns
+ * the fused opcode for a pair, or nil if the pair is not fused.
+ */
+extern void codespace_fuse(void);
+extern vvp_code_fun vthread_fused_opcode(vvp_code_fun first,
+					 vvp_code_fun second);
+
 #endif
@@ -111,6 +111,7 @@ static const struct opcode_table_s opcode_table[] = {
       { "%blend",    of_BLEND,   3,  {OA_BIT1,  OA_BIT2,     OA_NUMBER} },
       { "%blend/wr", of_BLEND_WR,0,  {OA_NONE,  OA_NONE,     OA_NONE} },
       { "%breakpoint", of_BREAKPOINT, 0,  {OA_NONE, OA_NONE, OA_NONE} },
+      { "%case/u", of_CASE_U, 3,  {OA_BIT1,     OA_BIT2,     OA_NUMBER} },
       { "%cassign/link",of_CASSIGN_LINK,2,{OA_FUNC_PTR,OA_FUNC_PTR2,OA_NONE} },
       { "%cassign/v",of_CASSIGN_V,3,{OA_FUNC_PTR,OA_BIT1,    OA_BIT2} },
       { "%cassign/wr",of_CASSIGN_WR,1,{OA_FUNC_PTR,OA_NONE,  OA_NONE} },
@@ -422,9 +423,9 @@ void resolv_submit(resolv_list_s*cur)
 
 /*
  * Look up vvp_nets in the symbol table. The "source" is the label for
- * the net that I want to feed, and net->port[port] is the vvp_net
- * input that I want that node to feed into. When the name is found,
- * put net->port[port] into the fan-out list for that node.
+ * the net that I want to feed, and port is the vvp_net input that I
+ * want that node to feed into. When the name is found, put port into
+ * the fan-out list for that node.
  */
 struct vvp_net_resolv_list_s: public resolv_list_s {
 
@@ -21,12 +21,13 @@
 #include "schedule.h"
 #include "vpi_priv.h"
 #include "config.h"
+#include "slab.h"
 #ifdef CHECK_WITH_VALGRIND
 #include "vvp_cleanup.h"
 #endif
 #include <iostream>
 #include <cstdlib>
-#include <list>
+#include <vector>
 #include <cassert>
 #include <cmath>
 #include "ivl_alloc.h"
@@ -148,6 +149,48 @@ void vvp_delay_t::set_decay(vvp_time64_t val)
 	    calculate_min_delay_();
 }
 
+static const size_t DELAY4_CHUNK_COUNT = 65536 / sizeof(vvp_fun_delay::event_vec4_);
+static slab_t<sizeof(vvp_fun_delay::event_vec4_),DELAY4_CHUNK_COUNT> delay4_heap;
+
+void* vvp_fun_delay::event_vec4_::operator new(size_t size)
+{
+      assert(size == sizeof(event_vec4_));
+      return delay4_heap.alloc_slab();
+}
+
+void vvp_fun_delay::event_vec4_::operator delete(void*ptr)
+{
+      delay4_heap.free_slab(ptr);
+}
+
+static const size_t DELAY8_CHUNK_COUNT = 65536 / sizeof(vvp_fun_delay::event_vec8_);
+static slab_t<sizeof(vvp_fun_delay::event_vec8_),DELAY8_CHUNK_COUNT> delay8_heap;
+
+void* vvp_fun_delay::event_vec8_::operator new(size_t size)
+{
+      assert(size == sizeof(event_vec8_));
+      return delay8_heap.alloc_slab();
+}
+
+void vvp_fun_delay::event_vec8_::operator delete(void*ptr)
+{
+      delay8_heap.free_slab(ptr);
+}
+
+static const size_t DELAYR_CHUNK_COUNT = 65536 / sizeof(vvp_fun_delay::event_real_);
+static slab_t<sizeof(vvp_fun_delay::event_real_),DELAYR_CHUNK_COUNT> delayr_heap;
+
+void* vvp_fun_delay::event_real_::operator new(size_t size)
+{
+      assert(size == sizeof(event_real_));
+      return delayr_heap.alloc_slab();
+}
+
+void vvp_fun_delay::event_real_::operator delete(void*ptr)
+{
+      delayr_heap.free_slab(ptr);
+}
+
 vvp_fun_delay::vvp_fun_delay(vvp_net_t*n, unsigned width, const vvp_delay_t&d)
 : net_(n), delay_(d)
 {
@@ -178,7 +221,25 @@ vvp_fun_delay::vvp_fun_delay(vvp_net_t*n, unsigned width, const vvp_delay_t&d)
 vvp_fun_delay::~vvp_fun_delay()
 {
       while (struct event_*cur = dequeue_())
-	    delete cur;
+	    delete_event_(cur);
+}
+
+void vvp_fun_delay::delete_event_(struct event_*cur)
+{
+      switch (cur->type) {
+	  case VEC4_DELAY:
+	    delete static_cast<event_vec4_*>(cur);
+	    break;
+	  case VEC8_DELAY:
+	    delete static_cast<event_vec8_*>(cur);
+	    break;
+	  case REAL_DELAY:
+	    delete static_cast<event_real_*>(cur);
+	    break;
+	  default:
+	    assert(0);
+	    break;
+      }
 }
 
 bool vvp_fun_delay::clean_pulse_events_(vvp_time64_t use_delay,
@@ -188,7 +249,8 @@ bool vvp_fun_delay::clean_pulse_events_(vvp_time64_t use_delay,
 
 	/* If the most recent event and the new event have the same
 	 * value then we need to skip the new event. */
-      if (list_->next->ptr_vec4.eeq(bit)) return true;
+      if (list_->next->type == VEC4_DELAY
+	  && static_cast<event_vec4_*>(list_->next)->val.eeq(bit)) return true;
 
       clean_pulse_events_(use_delay);
       return false;
@@ -201,7 +263,8 @@ bool vvp_fun_delay::clean_pulse_events_(vvp_time64_t use_delay,
 
 	/* If the most recent event and the new event have the same
 	 * value then we need to skip the new event. */
-      if (list_->next->ptr_vec8.eeq(bit)) return true;
+      if (list_->next->type == VEC8_DELAY
+	  && static_cast<event_vec8_*>(list_->next)->val.eeq(bit)) return true;
 
       clean_pulse_events_(use_delay);
       return false;
@@ -214,7 +277,8 @@ bool vvp_fun_delay::clean_pulse_events_(vvp_time64_t use_delay,
 
 	/* If the most recent event and the new event have the same
 	 * value then we need to skip the new event. */
-      if (list_->next->ptr_real == bit) return true;
+      if (list_->next->type == REAL_DELAY
+	  && static_cast<event_real_*>(list_->next)->val == bit) return true;
 
       clean_pulse_events_(use_delay);
       return false;
@@ -236,7 +300,7 @@ void vvp_fun_delay::clean_pulse_events_(vvp_time64_t use_delay)
 		  list_ = 0;
 	    else
 		  list_->next = cur->next;
-	    delete cur;
+	    delete_event_(cur);
       } while (list_);
 }
 
@@ -294,7 +358,7 @@ void vvp_fun_delay::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 	      // current value of the output. Detect and handle the
 	      // special case that the event list contains the current
 	      // value as a zero-delay-remaining event.
-	    const vvp_vector4_t&use_vec4 = (list_ && list_->next->sim_time == schedule_simtime())? list_->next->ptr_vec4 : cur_vec4_;
+	    const vvp_vector4_t&use_vec4 = (list_ && list_->next->sim_time == schedule_simtime() && list_->next->type == VEC4_DELAY)? static_cast<event_vec4_*>(list_->next)->val : cur_vec4_;
 
 	      /* How many bits to compare? */
 	    unsigned use_wid = use_vec4.size();
@@ -324,10 +388,7 @@ void vvp_fun_delay::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 	    initial_ = false;
 	    net_->send_vec4(cur_vec4_, 0);
       } else {
-	    struct event_*cur = new struct event_(use_simtime);
-	    cur->run_run_ptr = &vvp_fun_delay::run_run_vec4_;
-	    cur->ptr_vec4 = bit;
-	    enqueue_(cur);
+	    enqueue_(new event_vec4_(use_simtime, bit));
 	    schedule_generic(this, use_delay, false);
       }
 }
@@ -357,7 +418,7 @@ void vvp_fun_delay::recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit)
 	      // current value of the output. Detect and handle the
 	      // special case that the event list contains the current
 	      // value as a zero-delay-remaining event.
-	    const vvp_vector8_t&use_vec8 = (list_ && list_->next->sim_time == schedule_simtime())? list_->next->ptr_vec8 : cur_vec8_;
+	    const vvp_vector8_t&use_vec8 = (list_ && list_->next->sim_time == schedule_simtime() && list_->next->type == VEC8_DELAY)? static_cast<event_vec8_*>(list_->next)->val : cur_vec8_;
 
 	      /* How many bits to compare? */
 	    unsigned use_wid = use_vec8.size();
@@ -389,10 +450,7 @@ void vvp_fun_delay::recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit)
 	    initial_ = false;
 	    net_->send_vec8(cur_vec8_);
       } else {
-	    struct event_*cur = new struct event_(use_simtime);
-	    cur->ptr_vec8 = bit;
-	    cur->run_run_ptr = &vvp_fun_delay::run_run_vec8_;
-	    enqueue_(cur);
+	    enqueue_(new event_vec8_(use_simtime, bit));
 	    schedule_generic(this, use_delay, false);
       }
 }
@@ -451,10 +509,7 @@ void vvp_fun_delay::recv_real(vvp_net_ptr_t port, double bit,
 	    initial_ = false;
 	    net_->send_real(cur_real_, 0);
       } else {
-	    struct event_*cur = new struct event_(use_simtime);
-	    cur->run_run_ptr = &vvp_fun_delay::run_run_real_;
-	    cur->ptr_real = bit;
-	    enqueue_(cur);
+	    enqueue_(new event_real_(use_simtime, bit));
 
 	    schedule_generic(this, use_delay, false);
       }
@@ -470,27 +525,27 @@ void vvp_fun_delay::run_run()
       if (cur == 0)
 	    return;
 
-      (this->*(cur->run_run_ptr))(cur);
+      switch (cur->type) {
+	  case VEC4_DELAY:
+	    cur_vec4_ = static_cast<event_vec4_*>(cur)->val;
+	    delete_event_(cur);
+	    net_->send_vec4(cur_vec4_, 0);
+	    break;
+	  case VEC8_DELAY:
+	    cur_vec8_ = static_cast<event_vec8_*>(cur)->val;
+	    delete_event_(cur);
+	    net_->send_vec8(cur_vec8_);
+	    break;
+	  case REAL_DELAY:
+	    cur_real_ = static_cast<event_real_*>(cur)->val;
+	    delete_event_(cur);
+	    net_->send_real(cur_real_, 0);
+	    break;
+	  default:
+	    assert(0);
+	    break;
+      }
       initial_ = false;
-      delete cur;
-}
-
-void vvp_fun_delay::run_run_vec4_(struct event_*cur)
-{
-      cur_vec4_ = cur->ptr_vec4;
-      net_->send_vec4(cur_vec4_, 0);
-}
-
-void vvp_fun_delay::run_run_vec8_(struct vvp_fun_delay::event_*cur)
-{
-      cur_vec8_ = cur->ptr_vec8;
-      net_->send_vec8(cur_vec8_);
-}
-
-void vvp_fun_delay::run_run_real_(struct vvp_fun_delay::event_*cur)
-{
-      cur_real_ = cur->ptr_real;
-      net_->send_real(cur_real_, 0);
 }
 
 vvp_fun_modpath::vvp_fun_modpath(vvp_net_t*net, unsigned width)
@@ -554,7 +609,10 @@ void vvp_fun_modpath::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 	/* Select a time delay source that applies. Notice that there
 	   may be multiple delay sources that apply, so collect all
 	   the candidates into a list first. */
-      list<vvp_fun_modpath_src*>candidate_list;
+	/* The list is kept from call to call so that its storage is
+	   reused instead of allocated for each output change. */
+      static vector<vvp_fun_modpath_src*>candidate_list;
+      candidate_list.clear();
       vvp_time64_t candidate_wake_time = 0;
       for (vvp_fun_modpath_src*cur = src_list_ ;  cur ;  cur=cur->next_) {
 	      /* Skip paths that are disabled by conditions. */
@@ -609,7 +667,7 @@ void vvp_fun_modpath::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
       vvp_time64_t out_at[12];
       vvp_time64_t now = schedule_simtime();
 
-      typedef list<vvp_fun_modpath_src*>::const_iterator iter_t;
+      typedef vector<vvp_fun_modpath_src*>::const_iterator iter_t;
 
       iter_t cur = candidate_list.begin();
       vvp_fun_modpath_src*src = *cur;
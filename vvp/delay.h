@@ -74,18 +74,41 @@ class vvp_delay_t {
  */
 class vvp_fun_delay  : public vvp_net_fun_t, private vvp_gen_event_s {
 
+    public: // Public so that delay.cc can size the slabs.
       enum delay_type_t {UNKNOWN_DELAY, VEC4_DELAY, VEC8_DELAY, REAL_DELAY};
+
+	// The pending output values. Each event holds just the kind of
+	// value it carries, and the events of each kind are allocated
+	// from their own slab. The initial value may arrive as another
+	// kind than the events still pending (type_ follows the latest
+	// input) so each event records its own kind.
       struct event_ {
-	    event_(vvp_time64_t s) : sim_time(s) {
-		  ptr_real = 0.0;
-		  next = NULL;
-	    }
-	    void (vvp_fun_delay::*run_run_ptr)(struct vvp_fun_delay::event_*cur);
+	    event_(vvp_time64_t s, delay_type_t t)
+	    : sim_time(s), next(0), type(t) { }
 	    const vvp_time64_t sim_time;
-	    vvp_vector4_t ptr_vec4;
-	    vvp_vector8_t ptr_vec8;
-	    double ptr_real;
 	    struct event_*next;
+	    const delay_type_t type;
+      };
+      struct event_vec4_ : public event_ {
+	    event_vec4_(vvp_time64_t s, const vvp_vector4_t&v)
+	    : event_(s, VEC4_DELAY), val(v) { }
+	    vvp_vector4_t val;
+	    static void* operator new(size_t);
+	    static void operator delete(void*);
+      };
+      struct event_vec8_ : public event_ {
+	    event_vec8_(vvp_time64_t s, const vvp_vector8_t&v)
+	    : event_(s, VEC8_DELAY), val(v) { }
+	    vvp_vector8_t val;
+	    static void* operator new(size_t);
+	    static void operator delete(void*);
+      };
+      struct event_real_ : public event_ {
+	    event_real_(vvp_time64_t s, double v)
+	    : event_(s, REAL_DELAY), val(v) { }
+	    double val;
+	    static void* operator new(size_t);
+	    static void operator delete(void*);
       };
 
     public:
@@ -103,9 +126,7 @@ class vvp_fun_delay  : public vvp_net_fun_t, private vvp_gen_event_s {
       virtual void run_run();
 
 
-      void run_run_vec4_(struct vvp_fun_delay::event_*cur);
-      void run_run_vec8_(struct vvp_fun_delay::event_*cur);
-      void run_run_real_(struct vvp_fun_delay::event_*cur);
+      void delete_event_(struct event_*cur);
 
     private:
       vvp_net_t*net_;
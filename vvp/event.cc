@@ -22,6 +22,7 @@
 # include  "vthread.h"
 # include  "schedule.h"
 # include  "vpi_priv.h"
+# include  "slab.h"
 # include  "config.h"
 # include  <cstring>
 # include  <cassert>
@@ -58,6 +59,32 @@ evctl::evctl(unsigned long ecount)
       next = 0;
 }
 
+/*
+ * A %evctl and the assignment that goes with it create an event
+ * control each time they run, and the edge deletes it. The slab is
+ * sized to hold the largest of the derived classes.
+ */
+union evctl_size_u {
+      char real_[sizeof(evctl_real)];
+      char vector_[sizeof(evctl_vector)];
+      char array_[sizeof(evctl_array)];
+      char array_r_[sizeof(evctl_array_r)];
+};
+
+static const size_t EVCTL_CHUNK_COUNT = 8192 / sizeof(evctl_size_u);
+static slab_t<sizeof(evctl_size_u),EVCTL_CHUNK_COUNT> evctl_heap;
+
+void* evctl::operator new(size_t size)
+{
+      assert(size <= sizeof(evctl_size_u));
+      return evctl_heap.alloc_slab();
+}
+
+void evctl::operator delete(void*dptr)
+{
+      evctl_heap.free_slab(dptr);
+}
+
 bool evctl::dec_and_run()
 {
       assert(ecount_ != 0);
@@ -33,6 +33,10 @@ class evctl {
       virtual ~evctl() {}
       evctl*next;
 
+	// All the event controls are allocated from one slab.
+      static void* operator new(size_t);
+      static void operator delete(void*);
+
     private:
       unsigned long ecount_;
 };
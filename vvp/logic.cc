@@ -28,6 +28,9 @@
 # include  <cstring>
 # include  <cassert>
 # include  <cstdlib>
+# include  <vector>
+
+bool logic_levelize_flag = false;
 
 vvp_fun_boolean_::vvp_fun_boolean_(unsigned wid)
 {
@@ -50,7 +53,7 @@ void vvp_fun_boolean_::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
       input_[port] = bit;
       if (net_ == 0) {
 	    net_ = ptr.ptr();
-	    schedule_functor(this);
+	    schedule_();
       }
 }
 
@@ -70,10 +73,194 @@ void vvp_fun_boolean_::recv_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 
       if (net_ == 0) {
 	    net_ = ptr.ptr();
-	    schedule_functor(this);
+	    schedule_();
+      }
+}
+
+void vvp_fun_boolean_::run_run()
+{
+      vvp_net_t*ptr = net_;
+      net_ = 0;
+
+      vvp_vector4_t result;
+      compute_(result);
+
+      ptr->send_vec4(result, 0);
+}
+
+bool vvp_fun_boolean_::inputs_same_size_() const
+{
+      unsigned wid = input_[0].size();
+      return input_[1].size() == wid
+	    && input_[2].size() == wid
+	    && input_[3].size() == wid;
+}
+
+/*
+ * The gates with a level wait in these lists until the sweep event
+ * runs. level_low is the lowest level that may have a waiting gate.
+ */
+static std::vector<vvp_gate_level_*> level_lists;
+static size_t level_low = 0;
+
+struct vvp_gate_level_sweep_s : public vvp_gen_event_s {
+      vvp_gate_level_sweep_s() : scheduled(false) { }
+      void run_run() { vvp_gate_level_::run_levels_(); }
+      bool scheduled;
+};
+
+static vvp_gate_level_sweep_s level_sweep;
+
+void vvp_fun_boolean_::schedule_()
+{
+      schedule_functor(this);
+}
+
+vvp_gate_level_::vvp_gate_level_()
+{
+      level_ = 0;
+      level_next_ = 0;
+}
+
+vvp_gate_level_::~vvp_gate_level_()
+{
+}
+
+bool vvp_gate_level_::schedule_level_(void)
+{
+      if (level_ == 0)
+	    return false;
+
+      level_next_ = level_lists[level_];
+      level_lists[level_] = this;
+      if (level_ < level_low)
+	    level_low = level_;
+
+      if (! level_sweep.scheduled) {
+	    level_sweep.scheduled = true;
+	    schedule_functor(&level_sweep);
+      }
+      return true;
+}
+
+/*
+ * Run the waiting gates from the lowest level up. A gate that runs
+ * can only add gates of a higher level, but if a gate of a lower
+ * level is added anyway, for example through a node that is not a
+ * gate, level_low moves back and it is run in this same sweep.
+ */
+void vvp_gate_level_::run_levels_(void)
+{
+      while (level_low < level_lists.size()) {
+	    vvp_gate_level_*cur = level_lists[level_low];
+	    if (cur == 0) {
+		  level_low += 1;
+		  continue;
+	    }
+
+	    level_lists[level_low] = cur->level_next_;
+	    cur->level_next_ = 0;
+	    cur->run_level_();
+      }
+
+      level_sweep.scheduled = false;
+}
+
+static std::vector<vvp_net_t*> levelize_nets;
+
+void vvp_gate_level_::levelize_net(vvp_net_t*net)
+{
+      levelize_nets.push_back(net);
+}
+
+/*
+ * Find the gates that receive the output of the net and add their
+ * index to the out list. The output may go through bufz and drive
+ * nodes on its way, since those pass it on right away, so follow
+ * through them. The level_ of a gate holds its index+1 while the
+ * levels are being worked out.
+ */
+void vvp_gate_level_::levelize_fanout_(vvp_net_t*net,
+				       std::vector<unsigned>&out,
+				       unsigned depth)
+{
+      for (unsigned idx = 0 ; idx < net->fanout_size() ; idx += 1) {
+	    vvp_net_t*dst = net->fanout(idx).ptr();
+
+	    if (vvp_gate_level_*gate = dynamic_cast<vvp_gate_level_*>(dst->fun)) {
+		  if (gate->level_)
+			out.push_back(gate->level_-1);
+		  continue;
+	    }
+
+	    if (depth == 0)
+		  continue;
+	    if (dynamic_cast<vvp_fun_bufz*>(dst->fun)
+		|| dynamic_cast<vvp_fun_drive*>(dst->fun))
+		  levelize_fanout_(dst, out, depth-1);
       }
 }
 
+/*
+ * Give every gate a level one more than the highest level of the
+ * gates that drive it. This is a topological sort, so the gates that
+ * are in a loop, or are driven by one, are never reached and keep
+ * the level 0.
+ */
+void vvp_gate_level_::levelize(void)
+{
+      size_t count = levelize_nets.size();
+      std::vector<vvp_gate_level_*> gates (count);
+      for (size_t idx = 0 ; idx < count ; idx += 1) {
+	    gates[idx] = dynamic_cast<vvp_gate_level_*>(levelize_nets[idx]->fun);
+	    gates[idx]->level_ = idx + 1;
+      }
+
+      std::vector< std::vector<unsigned> > fanout (count);
+      std::vector<unsigned> fanin (count, 0);
+      for (size_t idx = 0 ; idx < count ; idx += 1) {
+	    levelize_fanout_(levelize_nets[idx], fanout[idx], 4);
+	    for (size_t edge = 0 ; edge < fanout[idx].size() ; edge += 1)
+		  fanin[fanout[idx][edge]] += 1;
+      }
+
+      std::vector<unsigned> level (count, 0);
+      std::vector<unsigned> ready;
+      for (size_t idx = 0 ; idx < count ; idx += 1) {
+	    if (fanin[idx] == 0) {
+		  level[idx] = 1;
+		  ready.push_back(idx);
+	    }
+      }
+
+      unsigned max_level = 0;
+      while (! ready.empty()) {
+	    unsigned idx = ready.back();
+	    ready.pop_back();
+	    if (level[idx] > max_level)
+		  max_level = level[idx];
+
+	    for (size_t edge = 0 ; edge < fanout[idx].size() ; edge += 1) {
+		  unsigned dst = fanout[idx][edge];
+		  if (level[dst] < level[idx]+1)
+			level[dst] = level[idx]+1;
+		  fanin[dst] -= 1;
+		  if (fanin[dst] == 0)
+			ready.push_back(dst);
+	    }
+      }
+
+      for (size_t idx = 0 ; idx < count ; idx += 1) {
+	    gates[idx]->level_ = fanin[idx]? 0 : level[idx];
+	    if (gates[idx]->level_)
+		  count_functors_levelized += 1;
+      }
+
+      level_lists.assign(max_level+1, 0);
+      level_low = level_lists.size();
+      levelize_nets.clear();
+}
+
 vvp_fun_and::vvp_fun_and(unsigned wid, bool invert)
 : vvp_fun_boolean_(wid), invert_(invert)
 {
@@ -84,12 +271,18 @@ vvp_fun_and::~vvp_fun_and()
 {
 }
 
-void vvp_fun_and::run_run()
+void vvp_fun_and::compute_(vvp_vector4_t&result) const
 {
-      vvp_net_t*ptr = net_;
-      net_ = 0;
+      result = input_[0];
 
-      vvp_vector4_t result (input_[0]);
+      if (inputs_same_size_()) {
+	    result &= input_[1];
+	    result &= input_[2];
+	    result &= input_[3];
+	    if (invert_)
+		  result.invert();
+	    return;
+      }
 
       for (unsigned idx = 0 ;  idx < result.size() ;  idx += 1) {
 	    vvp_bit4_t bitbit = result.value(idx);
@@ -106,8 +299,6 @@ void vvp_fun_and::run_run()
 		  bitbit = ~bitbit;
 	    result.set_bit(idx, bitbit);
       }
-
-      ptr->send_vec4(result, 0);
 }
 
 vvp_fun_buf::vvp_fun_buf(unsigned wid)
@@ -508,12 +699,18 @@ vvp_fun_or::~vvp_fun_or()
 {
 }
 
-void vvp_fun_or::run_run()
+void vvp_fun_or::compute_(vvp_vector4_t&result) const
 {
-      vvp_net_t*ptr = net_;
-      net_ = 0;
+      result = input_[0];
 
-      vvp_vector4_t result (input_[0]);
+      if (inputs_same_size_()) {
+	    result |= input_[1];
+	    result |= input_[2];
+	    result |= input_[3];
+	    if (invert_)
+		  result.invert();
+	    return;
+      }
 
       for (unsigned idx = 0 ;  idx < result.size() ;  idx += 1) {
 	    vvp_bit4_t bitbit = result.value(idx);
@@ -530,8 +727,6 @@ void vvp_fun_or::run_run()
 		  bitbit = ~bitbit;
 	    result.set_bit(idx, bitbit);
       }
-
-      ptr->send_vec4(result, 0);
 }
 
 vvp_fun_xor::vvp_fun_xor(unsigned wid, bool invert)
@@ -544,12 +739,18 @@ vvp_fun_xor::~vvp_fun_xor()
 {
 }
 
-void vvp_fun_xor::run_run()
+void vvp_fun_xor::compute_(vvp_vector4_t&result) const
 {
-      vvp_net_t*ptr = net_;
-      net_ = 0;
+      result = input_[0];
 
-      vvp_vector4_t result (input_[0]);
+      if (inputs_same_size_()) {
+	    result ^= input_[1];
+	    result ^= input_[2];
+	    result ^= input_[3];
+	    if (invert_)
+		  result.invert();
+	    return;
+      }
 
       for (unsigned idx = 0 ;  idx < result.size() ;  idx += 1) {
 	    vvp_bit4_t bitbit = result.value(idx);
@@ -566,8 +767,17 @@ void vvp_fun_xor::run_run()
 		  bitbit = ~bitbit;
 	    result.set_bit(idx, bitbit);
       }
+}
 
-      ptr->send_vec4(result, 0);
+/*
+ * Make an AND, OR or XOR family gate, with a level if levelized
+ * evaluation is enabled.
+ */
+template <class GATE> static vvp_net_fun_t* new_gate_(unsigned wid, bool invert)
+{
+      if (logic_levelize_flag)
+	    return new vvp_fun_levelized<GATE>(wid, invert);
+      return new GATE(wid, invert);
 }
 
 /*
@@ -584,10 +794,10 @@ void compile_functor(char*label, char*type, unsigned width,
       bool strength_aware = false;
 
       if (strcmp(type, "OR") == 0) {
-	    obj = new vvp_fun_or(width, false);
+	    obj = new_gate_<vvp_fun_or>(width, false);
 
       } else if (strcmp(type, "AND") == 0) {
-	    obj = new vvp_fun_and(width, false);
+	    obj = new_gate_<vvp_fun_and>(width, false);
 
       } else if (strcmp(type, "BUF") == 0) {
 	    obj = new vvp_fun_buf(width);
@@ -601,10 +811,10 @@ void compile_functor(char*label, char*type, unsigned width,
 	    strength_aware = true;
 
       } else if (strcmp(type, "NAND") == 0) {
-	    obj = new vvp_fun_and(width, true);
+	    obj = new_gate_<vvp_fun_and>(width, true);
 
       } else if (strcmp(type, "NOR") == 0) {
-	    obj = new vvp_fun_or(width, true);
+	    obj = new_gate_<vvp_fun_or>(width, true);
 
       } else if (strcmp(type, "NOTIF0") == 0) {
 	    obj = new vvp_fun_bufif(true,true, ostr0, ostr1);
@@ -648,10 +858,10 @@ void compile_functor(char*label, char*type, unsigned width,
 	    obj = new vvp_fun_not(width);
 
       } else if (strcmp(type, "XNOR") == 0) {
-	    obj = new vvp_fun_xor(width, true);
+	    obj = new_gate_<vvp_fun_xor>(width, true);
 
       } else if (strcmp(type, "XOR") == 0) {
-	    obj = new vvp_fun_xor(width, false);
+	    obj = new_gate_<vvp_fun_xor>(width, false);
 
       } else {
 	    yyerror("invalid functor type.");
@@ -667,6 +877,9 @@ void compile_functor(char*label, char*type, unsigned width,
       vvp_net_t*net = new vvp_net_t;
       net->fun = obj;
 
+      if (logic_levelize_flag && dynamic_cast<vvp_gate_level_*>(obj))
+	    vvp_gate_level_::levelize_net(net);
+
       inputs_connect(net, argc, argv);
       free(argv);
 
@@ -22,9 +22,12 @@
 # include  "vvp_net.h"
 # include  "schedule.h"
 # include  <cstddef>
+# include  <vector>
 
 /*
- * vvp_fun_boolean_ is just a common hook for holding operands.
+ * vvp_fun_boolean_ is just a common hook for holding operands. The
+ * derived classes calculate the output from the operands, and this
+ * class takes care of scheduling and propagating it.
  */
 class vvp_fun_boolean_ : public vvp_net_fun_t, protected vvp_gen_event_s {
 
@@ -38,11 +41,87 @@ class vvp_fun_boolean_ : public vvp_net_fun_t, protected vvp_gen_event_s {
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
 
+    protected:
+      virtual void compute_(vvp_vector4_t&result) const =0;
+	// True if all the inputs have the width of the first one, so
+	// the result can be computed a word at a time.
+      bool inputs_same_size_() const;
+
+	// Compute the output and propagate it.
+      void run_run();
+	// Arrange for run_run to be called. By default this schedules
+	// the functor event.
+      virtual void schedule_();
+
     protected:
       vvp_vector4_t input_[4];
       vvp_net_t*net_;
 };
 
+/*
+ * When levelized evaluation is enabled, gates that are not part of a
+ * combinational loop are given a level that is larger than the level
+ * of all the gates that drive them. A gate with a level does not
+ * schedule its own event when an input changes. Instead it is put in
+ * the list for its level, and a single sweep event evaluates the
+ * lists in level order. Each gate then runs once per sweep even if
+ * several of its inputs change. Gates in a loop keep the level 0 and
+ * are scheduled as usual.
+ *
+ * The level is kept in this vvp_gate_level_ part, which only the
+ * gates made by vvp_fun_levelized carry. The compiler only makes
+ * those when levelized evaluation is enabled, so the plain gates do
+ * not pay for it.
+ */
+class vvp_gate_level_ {
+
+    public:
+	// Give levels to the gates that the compiler passed to
+	// levelize_net. This is called once, after the compile.
+      static void levelize(void);
+      static void levelize_net(vvp_net_t*net);
+
+    protected:
+      vvp_gate_level_();
+      virtual ~vvp_gate_level_();
+
+	// Put the gate in the list for its level. Return false if
+	// the gate has no level, and must be scheduled by itself.
+      bool schedule_level_(void);
+	// Run the gate, from the sweep event.
+      virtual void run_level_(void) =0;
+
+    private:
+      static void run_levels_(void);
+      static void levelize_fanout_(vvp_net_t*net, std::vector<unsigned>&out,
+				   unsigned depth);
+      friend struct vvp_gate_level_sweep_s;
+
+	// The level of the gate, or 0 if it is scheduled by itself.
+      unsigned level_;
+	// The next gate waiting in the list of the same level.
+      vvp_gate_level_*level_next_;
+};
+
+template <class GATE> class vvp_fun_levelized
+: public GATE, public vvp_gate_level_ {
+
+    public:
+      vvp_fun_levelized(unsigned wid, bool invert) : GATE(wid, invert) { }
+
+    private:
+      void schedule_()
+      { if (! schedule_level_()) GATE::schedule_(); }
+      void run_level_(void)
+      { GATE::run_run(); }
+};
+
+/*
+ * Enable levelized evaluation of the logic gates. This must be set
+ * before the compile, so that the gates are passed to levelize_net.
+ */
+extern bool logic_levelize_flag;
+
 class vvp_fun_and  : public vvp_fun_boolean_ {
 
     public:
@@ -50,7 +129,7 @@ class vvp_fun_and  : public vvp_fun_boolean_ {
       ~vvp_fun_and();
 
     private:
-      void run_run();
+      void compute_(vvp_vector4_t&result) const;
       bool invert_;
 };
 
@@ -197,7 +276,7 @@ class vvp_fun_or  : public vvp_fun_boolean_ {
       ~vvp_fun_or();
 
     private:
-      void run_run();
+      void compute_(vvp_vector4_t&result) const;
       bool invert_;
 };
 
@@ -208,7 +287,7 @@ class vvp_fun_xor  : public vvp_fun_boolean_ {
       ~vvp_fun_xor();
 
     private:
-      void run_run();
+      void compute_(vvp_vector4_t&result) const;
       bool invert_;
 };
 
@@ -22,9 +22,13 @@
 # include  "config.h"
 # include  "parse_misc.h"
 # include  "compile.h"
+# include  "codes.h"
+# include  "logic.h"
 # include  "schedule.h"
 # include  "vpi_priv.h"
 # include  "statistics.h"
+# include  "profile.h"
+# include  "checkpoint.h"
 # include  "vvp_cleanup.h"
 # include  "vvp_object.h"
 # include  <cstdio>
@@ -259,6 +263,8 @@ int main(int argc, char*argv[])
       struct rusage cycles[3];
       const char *logfile_name = 0x0;
       FILE *logfile = 0x0;
+      bool fuse_flag = true;
+      const char*profile_path = 0;
       extern void vpi_set_vlog_info(int, char**);
       extern bool stop_is_finish;
       extern int  stop_is_finish_exit_code;
@@ -316,22 +322,44 @@ int main(int argc, char*argv[])
         /* For non-interactive runs we do not want to run the interactive
          * debugger, so make $stop just execute a $finish. */
       stop_is_finish = false;
-      while ((opt = getopt(argc, argv, "+hl:M:m:nNsvV")) != EOF) switch (opt) {
+      while ((opt = getopt(argc, argv, "+c:FhiLl:M:m:nNp:q:svV")) != EOF) switch (opt) {
          case 'h':
            fprintf(stderr,
                    "Usage: vvp [options] input-file [+plusargs...]\n"
                    "Options:\n"
+		   " -c time:file   Fork the tests in file at time.\n"
+		   " -F             Do not fuse instruction pairs.\n"
                    " -h             Print this help message.\n"
+		   " -i             Save/use a token image of the input file.\n"
+                   " -L             Evaluate logic gates in level order.\n"
                    " -l file        Logfile, '-' for <stderr>\n"
                    " -M path        VPI module directory\n"
 		   " -M -           Clear VPI module path\n"
                    " -m module      Load vpi module.\n"
 		   " -n             Non-interactive ($stop = $finish).\n"
                    " -N             Same as -n, but exit code is 1 instead of 0\n"
+		   " -p file        Write a profile of the simulation to file.\n"
+		   " -q queue       Event queue type (wheel or list).\n"
 		   " -s             $stop right away.\n"
                    " -v             Verbose progress messages.\n"
                    " -V             Print the version information.\n" );
            exit(0);
+	  case 'c':
+	    if (! vvp_checkpoint_set(optarg)) {
+		  fprintf(stderr, "%s: Invalid checkpoint \"%s\".\n",
+		          argv[0], optarg);
+		  flag_errors += 1;
+	    }
+	    break;
+	  case 'F':
+	    fuse_flag = false;
+	    break;
+	  case 'i':
+	    token_image_flag = true;
+	    break;
+	  case 'L':
+	    logic_levelize_flag = true;
+	    break;
 	  case 'l':
 	    logfile_name = optarg;
 	    break;
@@ -353,6 +381,17 @@ int main(int argc, char*argv[])
             stop_is_finish = true;
             stop_is_finish_exit_code = 1;
             break;
+	  case 'p':
+	    profile_path = optarg;
+	    vvp_profile_flag = true;
+	    break;
+	  case 'q':
+	    if (! schedule_set_queue(optarg)) {
+		  fprintf(stderr, "%s: Unknown event queue type \"%s\".\n",
+		          argv[0], optarg);
+		  flag_errors += 1;
+	    }
+	    break;
 	  case 's':
 	    schedule_stop(0);
 	    break;
@@ -463,6 +502,15 @@ int main(int argc, char*argv[])
 	    return compile_errors;
       }
 
+	/* The profiler counts opcodes, so do not fuse them. */
+      if (fuse_flag && !vvp_profile_flag)
+	    codespace_fuse();
+
+      vvp_net_t::compact_fanout();
+
+      if (logic_levelize_flag)
+	    vvp_gate_level_::levelize();
+
       if (verbose_flag) {
 #ifdef __MINGW32__  /* MinGW does not know about z. */
 	    vpi_mcd_printf(1, " ... %8lu functors (net_fun pool=%u bytes)\n",
@@ -471,6 +519,9 @@ int main(int argc, char*argv[])
 #endif
 			   count_functors, vvp_net_fun_t::heap_total());
 	    vpi_mcd_printf(1, "           %8lu logic\n",  count_functors_logic);
+	    if (logic_levelize_flag)
+		  vpi_mcd_printf(1, "           %8lu levelized\n",
+				 count_functors_levelized);
 	    vpi_mcd_printf(1, "           %8lu bufif\n",  count_functors_bufif);
 	    vpi_mcd_printf(1, "           %8lu resolv\n",count_functors_resolv);
 	    vpi_mcd_printf(1, "           %8lu signals\n", count_functors_sig);
@@ -486,6 +537,8 @@ int main(int argc, char*argv[])
 	    vpi_mcd_printf(1, " ... %8lu opcodes (%zu bytes)\n",
 #endif
 	                   count_opcodes, size_opcodes);
+	    vpi_mcd_printf(1, "           %8lu fused pairs\n",
+			   count_opcodes_fused);
 	    vpi_mcd_printf(1, " ... %8lu nets\n",     count_vpi_nets);
 #ifdef __MINGW32__  /* MinGW does not know about z. */
 	    vpi_mcd_printf(1, " ... %8lu vvp_nets (%u bytes)\n",
@@ -493,6 +546,12 @@ int main(int argc, char*argv[])
 	    vpi_mcd_printf(1, " ... %8lu vvp_nets (%zu bytes)\n",
 #endif
 			   count_vvp_nets, size_vvp_nets);
+#ifdef __MINGW32__  /* MinGW does not know about z. */
+	    vpi_mcd_printf(1, "           %8lu fan-out arrays (%u bytes)\n",
+#else
+	    vpi_mcd_printf(1, "           %8lu fan-out arrays (%zu bytes)\n",
+#endif
+			   count_vvp_fanouts, size_vvp_fanouts);
 	    vpi_mcd_printf(1, " ... %8lu arrays (%lu words)\n",
 			   count_net_arrays, count_net_array_words);
 	    vpi_mcd_printf(1, " ... %8lu memories\n",
@@ -511,21 +570,34 @@ int main(int argc, char*argv[])
       }
 
 
+      if (vvp_profile_flag)
+	    vvp_profile_start();
+
       schedule_simulate();
 
+      if (vvp_checkpoint_flag)
+	    fprintf(stderr, "vvp warning: The simulation ended before "
+		    "the checkpoint time.\n");
+
+      if (vvp_profile_flag)
+	    vvp_profile_finish(profile_path);
+
       if (verbose_flag) {
 	    my_getrusage(cycles+2);
 	    print_rusage(cycles+2, cycles+1);
 
 	    vpi_mcd_printf(1, "Event counts:\n");
-	    vpi_mcd_printf(1, "    %8lu time steps (pool=%lu)\n",
-			   count_time_events, count_time_pool());
+	    vpi_mcd_printf(1, "    %8lu time steps (pool=%lu, %s queue)\n",
+			   count_time_events, count_time_pool(),
+			   schedule_queue_name());
 	    vpi_mcd_printf(1, "    %8lu thread schedule events\n",
 		    count_thread_events);
 	    vpi_mcd_printf(1, "    %8lu assign events\n",
 		    count_assign_events);
 	    vpi_mcd_printf(1, "             ...assign(vec4) pool=%lu\n",
 			   count_assign4_pool());
+	    vpi_mcd_printf(1, "             ...assign(vec4) merged=%lu\n",
+			   count_assign4_merged);
 	    vpi_mcd_printf(1, "             ...assign(vec8) pool=%lu\n",
 			   count_assign8_pool());
 	    vpi_mcd_printf(1, "             ...assign(real) pool=%lu\n",
@@ -28,6 +28,10 @@
 # include  <cassert>
 # include  "ivl_alloc.h"
 
+  /* The parser reads tokens through the token image, which in turn
+     calls the lexor if there is no image to replay. */
+# define yylex token_image_lex
+
 /*
  * These are bits in the lexor.
  */
@@ -1180,13 +1184,25 @@ int compile_design(const char*path)
 {
       yypath = path;
       yyline = 1;
+
+	/* If there is a current token image for this file, then the
+	   parser gets its tokens from the image and the file itself
+	   is not read. */
+      if (token_image_open(path)) {
+	    int rc = yyparse();
+	    token_image_close(false);
+	    return rc;
+      }
+
       yyin = fopen(path, "r");
       if (yyin == 0) {
 	    fprintf(stderr, "%s: Unable to open input file.\n", path);
+	    token_image_close(false);
 	    return -1;
       }
 
       int rc = yyparse();
       fclose(yyin);
+      token_image_close(rc == 0 && compile_errors == 0);
       return rc;
 }
@@ -46,6 +46,20 @@ extern void yyerror(const char*msg);
 
 extern void destroy_lexor();
 
+/*
+ * The token image is a binary copy of the tokens of a design file
+ * that is saved next to the file and replayed on later runs if the
+ * file has not changed. The token_image_flag enables it. The
+ * token_image_open function returns true if there is a current image
+ * for the path, in which case token_image_lex replays it. Otherwise
+ * token_image_lex calls yylex and records the tokens, and
+ * token_image_close saves them if the save_flag is true.
+ */
+extern bool token_image_flag;
+extern bool token_image_open(const char*path);
+extern int  token_image_lex(void);
+extern void token_image_close(bool save_flag);
+
 /*
  * This is the path of the current source file.
  */
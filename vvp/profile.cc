@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2026 The Icarus Verilog contributors
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+# include  "profile.h"
+# include  "codes.h"
+# include  "vpi_priv.h"
+# include  <cstdio>
+# include  <string>
+# include  <vector>
+# include  <map>
+# include  <algorithm>
+#if !defined(__MINGW32__)
+# include  <csignal>
+# include  <sys/time.h>
+#endif
+
+bool vvp_profile_flag = false;
+
+/* Take a sample this often, in microseconds. */
+static const long PROFILE_INTERVAL = 1000;
+
+struct profile_count_s {
+      profile_count_s() : samples(0), opcodes(0), runs(0), scheduled(0) { }
+	// Written by the signal handler.
+      volatile unsigned long samples;
+      unsigned long opcodes;
+      unsigned long runs;
+      unsigned long scheduled;
+};
+
+struct profile_scope_s : public profile_count_s {
+      profile_scope_s() : scope(0) { }
+      struct __vpiScope*scope;
+};
+
+struct profile_line_s : public profile_count_s {
+      profile_line_s() : handle(0), owner(0) { }
+      vpiHandle handle;
+      profile_scope_s*owner;
+};
+
+/*
+ * The records are kept in maps so that their addresses do not
+ * change. The nil scope is the kernel itself, for events that do not
+ * belong to a known net.
+ */
+static std::map<struct __vpiScope*,profile_scope_s> scope_tab;
+static std::map<vpiHandle,profile_line_s> line_tab;
+
+  /* The nets and functors, by the address of the complete object. */
+static std::vector< std::pair<vvp_net_t*,struct __vpiScope*> > net_list;
+static std::map<const void*,struct __vpiScope*> object_tab;
+
+struct profile_frame_s {
+      profile_scope_s*scope;
+      profile_line_s*line;
+};
+static std::vector<profile_frame_s> frame_stack;
+
+  /* The signal handler samples these. */
+static profile_scope_s*volatile cur_scope = 0;
+static profile_line_s*volatile cur_line = 0;
+static volatile unsigned long total_samples = 0;
+
+void vvp_profile_net(vvp_net_t*net)
+{
+      net_list.push_back(std::make_pair(net, vpip_peek_current_scope()));
+}
+
+#if !defined(__MINGW32__) && defined(ITIMER_PROF)
+extern "C" void profile_sample(int)
+{
+      total_samples += 1;
+      if (profile_scope_s*rec = cur_scope)
+	    rec->samples += 1;
+      if (profile_line_s*line = cur_line)
+	    line->samples += 1;
+}
+
+static void profile_timer(long usec)
+{
+      struct itimerval val;
+      val.it_interval.tv_sec = 0;
+      val.it_interval.tv_usec = usec;
+      val.it_value = val.it_interval;
+      setitimer(ITIMER_PROF, &val, 0);
+}
+#endif
+
+void vvp_profile_start(void)
+{
+	/* Now that the functors are all attached, find the scopes of
+	   the functors from the nets that hold them. */
+      for (size_t idx = 0 ; idx < net_list.size() ; idx += 1) {
+	    vvp_net_t*net = net_list[idx].first;
+	    struct __vpiScope*scope = net_list[idx].second;
+	    object_tab[net] = scope;
+	    if (net->fun)
+		  object_tab.insert(std::make_pair(dynamic_cast<const void*>(net->fun),
+						   scope));
+      }
+      net_list.clear();
+
+      cur_scope = &scope_tab[0];
+
+#if !defined(__MINGW32__) && defined(ITIMER_PROF)
+      signal(SIGPROF, &profile_sample);
+      profile_timer(PROFILE_INTERVAL);
+#endif
+}
+
+void vvp_profile_enter_scope(struct __vpiScope*scope)
+{
+      profile_frame_s frame;
+      frame.scope = cur_scope;
+      frame.line = cur_line;
+      frame_stack.push_back(frame);
+
+      profile_scope_s*rec = &scope_tab[scope];
+      rec->scope = scope;
+      rec->runs += 1;
+      cur_line = 0;
+      cur_scope = rec;
+}
+
+void vvp_profile_enter_object(const void*obj)
+{
+      struct __vpiScope*scope = 0;
+      if (obj) {
+	    std::map<const void*,struct __vpiScope*>::const_iterator cur;
+	    cur = object_tab.find(obj);
+	    if (cur != object_tab.end())
+		  scope = cur->second;
+      }
+
+      vvp_profile_enter_scope(scope);
+}
+
+void vvp_profile_leave(void)
+{
+      if (frame_stack.empty())
+	    return;
+
+      profile_frame_s frame = frame_stack.back();
+      frame_stack.pop_back();
+      cur_scope = frame.scope;
+      cur_line = frame.line;
+}
+
+void vvp_profile_opcode(const struct vvp_code_s*cp)
+{
+      if (cp->opcode == &of_FILE_LINE) {
+	    profile_line_s*line = &line_tab[cp->handle];
+	    if (line->handle == 0) {
+		  line->handle = cp->handle;
+		  line->owner = cur_scope? cur_scope : &scope_tab[0];
+	    }
+	    line->runs += 1;
+	    cur_line = line;
+      }
+
+      if (profile_scope_s*rec = cur_scope)
+	    rec->opcodes += 1;
+      if (profile_line_s*line = cur_line)
+	    line->opcodes += 1;
+}
+
+void vvp_profile_scheduled(void)
+{
+      if (profile_scope_s*rec = cur_scope)
+	    rec->scheduled += 1;
+      if (profile_line_s*line = cur_line)
+	    line->scheduled += 1;
+}
+
+static std::string scope_full_name(struct __vpiScope*scope)
+{
+      if (scope == 0)
+	    return "(kernel)";
+      return vpi_get_str(vpiFullName, scope);
+}
+
+  /* The scope names from the root down, separated by ';'. */
+static std::string scope_stack_name(struct __vpiScope*scope)
+{
+      if (scope == 0)
+	    return "(kernel)";
+
+      std::string res = scope->name;
+      for (scope = scope->scope ; scope ; scope = scope->scope)
+	    res = std::string(scope->name) + ";" + res;
+      return res;
+}
+
+static std::string line_name(vpiHandle handle)
+{
+      char buf[32];
+      snprintf(buf, sizeof buf, ":%d", (int)vpi_get(vpiLineNo, handle));
+      return std::string(vpi_get_str(vpiFile, handle)) + buf;
+}
+
+template <class T> static bool profile_more(const T*a, const T*b)
+{
+      if (a->samples != b->samples)
+	    return a->samples > b->samples;
+      return a->opcodes > b->opcodes;
+}
+
+void vvp_profile_finish(const char*path)
+{
+#if !defined(__MINGW32__) && defined(ITIMER_PROF)
+      profile_timer(0);
+      signal(SIGPROF, SIG_DFL);
+#endif
+
+      FILE*fd = fopen(path, "w");
+      if (fd == 0) {
+	    perror(path);
+	    return;
+      }
+
+      std::vector<profile_scope_s*> scopes;
+      for (std::map<struct __vpiScope*,profile_scope_s>::iterator cur
+		 = scope_tab.begin() ; cur != scope_tab.end() ; ++ cur)
+	    scopes.push_back(&cur->second);
+      std::sort(scopes.begin(), scopes.end(), &profile_more<profile_scope_s>);
+
+      std::vector<profile_line_s*> lines;
+      for (std::map<vpiHandle,profile_line_s>::iterator cur
+		 = line_tab.begin() ; cur != line_tab.end() ; ++ cur)
+	    lines.push_back(&cur->second);
+      std::sort(lines.begin(), lines.end(), &profile_more<profile_line_s>);
+
+      unsigned long total = total_samples;
+      fprintf(fd, "# vvp profile: %lu samples, one every %ld us\n",
+	      total, PROFILE_INTERVAL);
+      fprintf(fd, "# %10s %6s %12s %10s %10s  %s\n", "samples", "%",
+	      "opcodes", "runs", "scheduled", "scope");
+      for (size_t idx = 0 ; idx < scopes.size() ; idx += 1) {
+	    profile_scope_s*rec = scopes[idx];
+	    double pct = total? 100.0 * rec->samples / total : 0.0;
+	    fprintf(fd, "  %10lu %6.2f %12lu %10lu %10lu  %s\n",
+		    (unsigned long)rec->samples, pct, rec->opcodes,
+		    rec->runs, rec->scheduled,
+		    scope_full_name(rec->scope).c_str());
+      }
+
+      if (! lines.empty()) {
+	    fprintf(fd, "\n# %10s %6s %12s %10s %10s  %s\n", "samples", "%",
+		    "opcodes", "runs", "scheduled", "line");
+	    for (size_t idx = 0 ; idx < lines.size() ; idx += 1) {
+		  profile_line_s*rec = lines[idx];
+		  double pct = total? 100.0 * rec->samples / total : 0.0;
+		  fprintf(fd, "  %10lu %6.2f %12lu %10lu %10lu  %s (%s)\n",
+			  (unsigned long)rec->samples, pct, rec->opcodes,
+			  rec->runs, rec->scheduled,
+			  line_name(rec->handle).c_str(),
+			  scope_full_name(rec->owner->scope).c_str());
+	    }
+      }
+      fclose(fd);
+
+	/* The folded stacks are one line per stack, with the frames
+	   separated by ';' and the weight at the end. The weight is
+	   the samples, or the opcodes if there are no samples. Lines
+	   are frames below their scope, so take their weight out of
+	   the weight of the scope itself. */
+      std::string folded_path = std::string(path) + ".folded";
+      fd = fopen(folded_path.c_str(), "w");
+      if (fd == 0) {
+	    perror(folded_path.c_str());
+	    return;
+      }
+
+      std::map<profile_scope_s*,unsigned long> line_weight;
+      for (size_t idx = 0 ; idx < lines.size() ; idx += 1) {
+	    profile_line_s*rec = lines[idx];
+	    unsigned long weight = total? rec->samples : rec->opcodes;
+	    if (weight == 0)
+		  continue;
+	    line_weight[rec->owner] += weight;
+	    fprintf(fd, "%s;%s %lu\n",
+		    scope_stack_name(rec->owner->scope).c_str(),
+		    line_name(rec->handle).c_str(), weight);
+      }
+
+      for (size_t idx = 0 ; idx < scopes.size() ; idx += 1) {
+	    profile_scope_s*rec = scopes[idx];
+	    unsigned long weight = total? rec->samples : rec->opcodes;
+	    unsigned long lines_weight = line_weight[rec];
+	    if (weight <= lines_weight)
+		  continue;
+	    fprintf(fd, "%s %lu\n", scope_stack_name(rec->scope).c_str(),
+		    weight - lines_weight);
+      }
+      fclose(fd);
+}
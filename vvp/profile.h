@@ -0,0 +1,63 @@
+#ifndef __profile_H
+#define __profile_H
+/*
+ * Copyright (c) 2026 The Icarus Verilog contributors
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+class vvp_net_t;
+struct __vpiScope;
+
+/*
+ * The profiler attributes the simulation work to the scopes of the
+ * design. The scheduler and the thread loop enter the scope of the
+ * thread or net that they are about to run, and leave it when it is
+ * done. A profiling timer samples the scope that was entered last,
+ * and the scope also counts the opcodes, thread runs and events that
+ * happen while it is entered. If the code was compiled with file and
+ * line information, the samples and opcodes are also counted for the
+ * last %file_line that the thread ran.
+ *
+ * All of this is only done when vvp_profile_flag is set, which must
+ * be done before the compile so that nets can be given a scope.
+ */
+extern bool vvp_profile_flag;
+
+  /* Remember the current compile scope as the scope of the net. */
+extern void vvp_profile_net(vvp_net_t*net);
+
+  /* Start the sampling timer. Call just before the simulation. */
+extern void vvp_profile_start(void);
+
+  /* Stop the timer and write the report to path, and the folded
+     stacks for flame graphs to path.folded. */
+extern void vvp_profile_finish(const char*path);
+
+  /* Enter the scope of a thread, or of the net or functor obj, which
+     is found from the nets passed to vvp_profile_net. */
+extern void vvp_profile_enter_scope(struct __vpiScope*scope);
+extern void vvp_profile_enter_object(const void*obj);
+extern void vvp_profile_leave(void);
+
+  /* Count an opcode that is about to run in the scope entered last.
+     A %file_line opcode also sets the line the next ones count for. */
+extern void vvp_profile_opcode(const struct vvp_code_s*cp);
+
+  /* Count an event scheduled while in the scope entered last. */
+extern void vvp_profile_scheduled(void);
+
+#endif // __profile_H
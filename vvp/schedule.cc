@@ -22,11 +22,16 @@
 # include  "vpi_priv.h"
 # include  "slab.h"
 # include  "compile.h"
+# include  "profile.h"
+# include  "checkpoint.h"
 # include  <new>
 # include  <typeinfo>
 # include  <csignal>
 # include  <cstdlib>
 # include  <cassert>
+# include  <cstring>
+# include  <algorithm>
+# include  <vector>
 
 # include  <iostream>
 
@@ -56,6 +61,10 @@ struct event_s {
 	// Write something about the event to stderr
       virtual void single_step_display(void);
 
+	// The net or functor that the profiler charges the event to,
+	// or nil for the kernel.
+      virtual const void*profile_object(void) const { return 0; }
+
 	// Fallback new/delete
       static void*operator new (size_t size) { return ::new char[size]; }
       static void operator delete(void*ptr)  { ::delete[]( (char*)ptr ); }
@@ -77,6 +86,9 @@ struct event_time_s {
 	    del_thr = 0;
 	    next = NULL;
       }
+	/* When the list queue is used, this is the delay from the
+	   previous event_time_s in the list. When the timing wheel is
+	   used, this is the absolute time of the time step. */
       vvp_time64_t delay;
 
       struct event_s*start;
@@ -182,13 +194,27 @@ struct assign_vector4_event_s  : public event_s {
       unsigned vwid;
       void run_run(void);
       void single_step_display(void);
+      const void*profile_object(void) const { return ptr.ptr(); }
 
       static void* operator new(size_t);
       static void operator delete(void*);
 };
 
+/*
+ * The most recent non-blocking vec4 assign event, while it is still
+ * waiting in an nbassign queue, or nil. The merge in
+ * schedule_assign_vector() only uses it if it is also at the end of
+ * the nbassign queue of the time step. It is cleared when the queue
+ * moves to the active events and when the event runs, so that it
+ * never points at an event that is deleted or being run.
+ */
+static struct assign_vector4_event_s*assign4_last = 0;
+
 void assign_vector4_event_s::run_run(void)
 {
+      if (assign4_last == this)
+	    assign4_last = 0;
+
       count_assign_events += 1;
       if (vwid > 0)
 	    vvp_send_vec4_pv(ptr, val, base, val.size(), vwid, 0);
@@ -223,6 +249,7 @@ struct assign_vector8_event_s  : public event_s {
       vvp_vector8_t val;
       void run_run(void);
       void single_step_display(void);
+      const void*profile_object(void) const { return ptr.ptr(); }
 
       static void* operator new(size_t);
       static void operator delete(void*);
@@ -260,6 +287,7 @@ struct assign_real_event_s  : public event_s {
       double val;
       void run_run(void);
       void single_step_display(void);
+      const void*profile_object(void) const { return ptr.ptr(); }
 
       static void* operator new(size_t);
       static void operator delete(void*);
@@ -419,6 +447,8 @@ struct generic_event_s : public event_s {
       bool delete_obj_when_done;
       void run_run(void);
       void single_step_display(void);
+      const void*profile_object(void) const
+      { return obj? dynamic_cast<const void*>(obj) : 0; }
 
       static void* operator new(size_t);
       static void operator delete(void*);
@@ -478,13 +508,6 @@ inline void event_time_s::operator delete(void*ptr, size_t)
 
 unsigned long count_time_pool(void) { return event_time_heap.pool; }
 
-/*
- * This is the head of the list of pending events. This includes all
- * the events that have not been executed yet, and reaches into the
- * future.
- */
-static struct event_time_s* sched_list = 0;
-
 /*
  * This is a list of initialization events. The setup puts
  * initializations in this list so that they happen before the
@@ -579,19 +602,244 @@ static void schedule_final_event(struct event_s*cur)
 }
 
 /*
- * This function does all the hard work of putting an event into the
- * event queue. The event delay is taken from the event structure
- * itself, and the structure is placed in the right place in the
- * queue.
+ * The pending event_time_s objects are kept in one of two
+ * structures, selected by schedule_set_queue() before any events are
+ * scheduled.
+ *
+ * The "list" queue is a singly linked list of event_time_s objects
+ * in time order, where each delay is relative to the previous cell
+ * in the list. Finding the cell for a future time walks the list, so
+ * it costs O(number of pending time steps).
+ *
+ * The "wheel" queue is a timing wheel of SCHED_WHEEL_SIZE slots that
+ * covers the times [sched_wheel_base, sched_wheel_base+SIZE). Each
+ * slot holds the event_time_s for the one time that maps to it, and
+ * a two level bitmap marks the occupied slots so that the next
+ * pending time can be found with a couple of bit scans. Times past
+ * the end of the wheel go into an overflow heap, and are moved into
+ * the wheel as the base time advances. The heap is ordered by time
+ * and then by insertion order, so that event_time_s objects for the
+ * same far time are merged back together in the order their events
+ * were scheduled.
  */
-typedef enum event_queue_e { SEQ_START, SEQ_ACTIVE, SEQ_NBASSIGN,
-			     SEQ_RWSYNC, SEQ_ROSYNC, DEL_THREAD } event_queue_t;
+static bool sched_use_wheel = true;
 
-static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
-			    event_queue_t select_queue)
+  // The current simulation time.
+static vvp_time64_t schedule_time = 0;
+
+bool schedule_set_queue(const char*name)
 {
-      cur->next = cur;
+      if (strcmp(name, "list") == 0) {
+	    sched_use_wheel = false;
+	    return true;
+      }
+      if (strcmp(name, "wheel") == 0) {
+	    sched_use_wheel = true;
+	    return true;
+      }
+      return false;
+}
+
+const char* schedule_queue_name(void)
+{
+      return sched_use_wheel? "wheel" : "list";
+}
+
+/*
+ * This is the head of the list of pending events for the list
+ * queue. This includes all the events that have not been executed
+ * yet, and reaches into the future.
+ */
+static struct event_time_s* sched_list = 0;
+
+static const unsigned SCHED_WHEEL_BITS = 12;
+static const unsigned SCHED_WHEEL_SIZE = 1U << SCHED_WHEEL_BITS;
+static const unsigned SCHED_WHEEL_MASK = SCHED_WHEEL_SIZE - 1;
+static const unsigned SCHED_WHEEL_WORDS = SCHED_WHEEL_SIZE / 64;
+
+static struct event_time_s* sched_wheel[SCHED_WHEEL_SIZE];
+  // One bit per slot, and one summary bit per word of slot bits.
+static uint64_t sched_wheel_map[SCHED_WHEEL_WORDS];
+static uint64_t sched_wheel_summary = 0;
+static vvp_time64_t sched_wheel_base = 0;
+
+struct sched_far_s {
+      vvp_time64_t time;
+      unsigned long seq;
+      struct event_time_s*ctim;
+};
+
+  /* std::push_heap builds a max heap, so invert the compare to keep
+     the earliest (time,seq) pair at the front. */
+struct sched_far_later {
+      bool operator() (const sched_far_s&a, const sched_far_s&b) const
+      {
+	    if (a.time != b.time) return a.time > b.time;
+	    return a.seq > b.seq;
+      }
+};
+
+static std::vector<sched_far_s> sched_far_heap;
+static unsigned long sched_far_seq = 0;
+  // The most recently created overflow cell. Consecutive events for
+  // the same far time share this cell instead of making new ones.
+static struct event_time_s* sched_far_last = 0;
+
+static inline unsigned sched_ctz_(uint64_t val)
+{
+#if defined(__GNUC__)
+      return __builtin_ctzll(val);
+#else
+      unsigned res = 0;
+      while ((val & 1) == 0) {
+	    val >>= 1;
+	    res += 1;
+      }
+      return res;
+#endif
+}
+
+static inline void sched_wheel_mark_(unsigned idx)
+{
+      sched_wheel_map[idx/64] |= (uint64_t)1 << (idx%64);
+      sched_wheel_summary |= (uint64_t)1 << (idx/64);
+}
+
+static inline void sched_wheel_clear_(unsigned idx)
+{
+      sched_wheel_map[idx/64] &= ~((uint64_t)1 << (idx%64));
+      if (sched_wheel_map[idx/64] == 0)
+	    sched_wheel_summary &= ~((uint64_t)1 << (idx/64));
+}
+
+/*
+ * Return the first occupied slot at or after the slot for the base
+ * time, wrapping around the end of the wheel. All the occupied slots
+ * are within SCHED_WHEEL_SIZE of the base time, so this is also the
+ * slot with the earliest time. The wheel must not be empty.
+ */
+static unsigned sched_wheel_next_(void)
+{
+      assert(sched_wheel_summary != 0);
+      unsigned from = sched_wheel_base & SCHED_WHEEL_MASK;
+      unsigned word = from / 64;
+
+      uint64_t bits = sched_wheel_map[word] & (~(uint64_t)0 << (from%64));
+      if (bits)
+	    return word*64 + sched_ctz_(bits);
+
+      uint64_t words = 0;
+      if (word+1 < SCHED_WHEEL_WORDS)
+	    words = sched_wheel_summary & (~(uint64_t)0 << (word+1));
+      if (words == 0)
+	    words = sched_wheel_summary;
+
+      word = sched_ctz_(words);
+      return word*64 + sched_ctz_(sched_wheel_map[word]);
+}
+
+/*
+ * Append the events of the src list to the dst list. Both are
+ * circular lists that point at their tail.
+ */
+static inline void sched_splice_(struct event_s*&dst, struct event_s*src)
+{
+      if (src == 0)
+	    return;
+      if (dst != 0) {
+	    struct event_s*head = dst->next;
+	    dst->next = src->next;
+	    src->next = head;
+      }
+      dst = src;
+}
+
+/*
+ * Put an event_time_s into its wheel slot. If the slot is already
+ * taken by an earlier cell for the same time, move the events of the
+ * new cell onto the end of the existing queues and delete the new cell.
+ */
+static void sched_wheel_insert_(struct event_time_s*ctim)
+{
+      unsigned idx = ctim->delay & SCHED_WHEEL_MASK;
+      struct event_time_s*cur = sched_wheel[idx];
+
+      if (cur == 0) {
+	    sched_wheel[idx] = ctim;
+	    sched_wheel_mark_(idx);
+	    return;
+      }
+
+      assert(cur->delay == ctim->delay);
+      sched_splice_(cur->start,    ctim->start);
+      sched_splice_(cur->active,   ctim->active);
+      sched_splice_(cur->nbassign, ctim->nbassign);
+      sched_splice_(cur->rwsync,   ctim->rwsync);
+      sched_splice_(cur->rosync,   ctim->rosync);
+      sched_splice_(cur->del_thr,  ctim->del_thr);
+      delete ctim;
+}
+
+/*
+ * Move the overflow cells that are now within reach of the wheel into
+ * their wheel slots.
+ */
+static void sched_wheel_migrate_(void)
+{
+      while (! sched_far_heap.empty()) {
+	    const sched_far_s&top = sched_far_heap.front();
+	    if (top.time - sched_wheel_base >= SCHED_WHEEL_SIZE)
+		  break;
+
+	    struct event_time_s*ctim = top.ctim;
+	    std::pop_heap(sched_far_heap.begin(), sched_far_heap.end(),
+			  sched_far_later());
+	    sched_far_heap.pop_back();
+
+	    if (ctim == sched_far_last)
+		  sched_far_last = 0;
+	    sched_wheel_insert_(ctim);
+      }
+}
+
+static struct event_time_s* sched_wheel_find_(vvp_time64_t delay)
+{
+      vvp_time64_t abs_time = schedule_time + delay;
+      assert(abs_time >= sched_wheel_base);
+
+      if (abs_time - sched_wheel_base < SCHED_WHEEL_SIZE) {
+	    unsigned idx = abs_time & SCHED_WHEEL_MASK;
+	    struct event_time_s*ctim = sched_wheel[idx];
+	    if (ctim == 0) {
+		  ctim = new struct event_time_s;
+		  ctim->delay = abs_time;
+		  sched_wheel[idx] = ctim;
+		  sched_wheel_mark_(idx);
+	    }
+	    assert(ctim->delay == abs_time);
+	    return ctim;
+      }
+
+      if (sched_far_last && sched_far_last->delay == abs_time)
+	    return sched_far_last;
+
+      struct event_time_s*ctim = new struct event_time_s;
+      ctim->delay = abs_time;
 
+      sched_far_s item;
+      item.time = abs_time;
+      item.seq  = sched_far_seq++;
+      item.ctim = ctim;
+      sched_far_heap.push_back(item);
+      std::push_heap(sched_far_heap.begin(), sched_far_heap.end(),
+		     sched_far_later());
+
+      sched_far_last = ctim;
+      return ctim;
+}
+
+static struct event_time_s* sched_list_find_(vvp_time64_t delay)
+{
       struct event_time_s*ctim = sched_list;
 
       if (sched_list == 0) {
@@ -644,9 +892,103 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
 	    }
       }
 
-	/* By this point, ctim is the event_time structure that is to
-	   receive the event at hand. Put the event in to the
-	   appropriate list for the kind of assign we have at hand. */
+      return ctim;
+}
+
+/*
+ * Return the event_time_s for the time step delay ticks after the
+ * current time, creating it if needed.
+ */
+static inline struct event_time_s* sched_find_time_(vvp_time64_t delay)
+{
+      if (sched_use_wheel)
+	    return sched_wheel_find_(delay);
+      else
+	    return sched_list_find_(delay);
+}
+
+/*
+ * Return the earliest pending time step, or nil if there are no
+ * pending events at all. If the wheel is empty, this is the earliest
+ * overflow cell, which is moved into the wheel when the scheduler
+ * advances to its time.
+ */
+static struct event_time_s* sched_first_(void)
+{
+      if (! sched_use_wheel)
+	    return sched_list;
+
+      if (sched_wheel_summary == 0) {
+	    if (sched_far_heap.empty())
+		  return 0;
+	    return sched_far_heap.front().ctim;
+      }
+
+      return sched_wheel[sched_wheel_next_()];
+}
+
+/*
+ * Return the number of ticks from the current time to the ctim time
+ * step, which must be the first pending time step.
+ */
+static inline vvp_time64_t sched_first_delay_(const struct event_time_s*ctim)
+{
+      if (sched_use_wheel)
+	    return ctim->delay - schedule_time;
+      else
+	    return ctim->delay;
+}
+
+/*
+ * The scheduler has advanced the current time to the time of the
+ * first time step. Update the queue to match.
+ */
+static void sched_first_advance_(struct event_time_s*ctim)
+{
+      if (sched_use_wheel) {
+	    assert(ctim->delay == schedule_time);
+	    sched_wheel_base = schedule_time;
+	    sched_wheel_migrate_();
+      } else {
+	    ctim->delay = 0;
+      }
+}
+
+/*
+ * Remove the first (and now empty) time step from the queue.
+ */
+static void sched_first_remove_(struct event_time_s*ctim)
+{
+      if (sched_use_wheel) {
+	    unsigned idx = ctim->delay & SCHED_WHEEL_MASK;
+	    assert(sched_wheel[idx] == ctim);
+	    sched_wheel[idx] = 0;
+	    sched_wheel_clear_(idx);
+      } else {
+	    assert(sched_list == ctim);
+	    sched_list = ctim->next;
+      }
+      delete ctim;
+}
+
+/*
+ * This function does all the hard work of putting an event into the
+ * event queue. The event delay is taken from the event structure
+ * itself, and the structure is placed in the right place in the
+ * queue.
+ */
+typedef enum event_queue_e { SEQ_START, SEQ_ACTIVE, SEQ_NBASSIGN,
+			     SEQ_RWSYNC, SEQ_ROSYNC, DEL_THREAD } event_queue_t;
+
+static void schedule_event_at_(struct event_s*cur, struct event_time_s*ctim,
+			       event_queue_t select_queue)
+{
+      cur->next = cur;
+      if (vvp_profile_flag) vvp_profile_scheduled();
+
+	/* ctim is the event_time structure that is to receive the
+	   event at hand. Put the event in to the appropriate list for
+	   the kind of assign we have at hand. */
 
       switch (select_queue) {
 
@@ -654,9 +996,9 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
 	    if (ctim->start == 0) {
 		  ctim->start = cur;
 	    } else {
-		  cur->next = ctim->active->next;
-		  ctim->active->next = cur;
-		  ctim->active = cur;
+		  cur->next = ctim->start->next;
+		  ctim->start->next = cur;
+		  ctim->start = cur;
 	    }
 	    break;
 
@@ -722,14 +1064,16 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
       }
 }
 
-static void schedule_event_push_(struct event_s*cur)
+static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
+			    event_queue_t select_queue)
 {
-      if ((sched_list == 0) || (sched_list->delay > 0)) {
-	    schedule_event_(cur, 0, SEQ_ACTIVE);
-	    return;
-      }
+      schedule_event_at_(cur, sched_find_time_(delay), select_queue);
+}
 
-      struct event_time_s*ctim = sched_list;
+static void schedule_event_push_(struct event_s*cur)
+{
+      struct event_time_s*ctim = sched_find_time_(0);
+      if (vvp_profile_flag) vvp_profile_scheduled();
 
       if (ctim->active == 0) {
 	    cur->next = cur;
@@ -760,6 +1104,14 @@ void schedule_vthread(vthread_t thr, vvp_time64_t delay, bool push_flag)
       }
 }
 
+void schedule_vthread_list(vthread_t thr)
+{
+      struct vthread_event_s*cur = new vthread_event_s;
+
+      cur->thr = thr;
+      schedule_event_(cur, 0, SEQ_ACTIVE);
+}
+
 void schedule_final_vthread(vthread_t thr)
 {
       struct vthread_event_s*cur = new vthread_event_s;
@@ -770,16 +1122,79 @@ void schedule_final_vthread(vthread_t thr)
       schedule_final_event(cur);
 }
 
+/*
+ * Non-blocking assignments to consecutive parts of a vector, for
+ * example from a loop that assigns one bit at a time, are merged into
+ * a single event so that the destination receives and propagates the
+ * whole part once. The new assignment is only merged into the event
+ * at the end of the nbassign queue of the same time step, so the
+ * order relative to all the other events does not change. Parts that
+ * overlap are not merged, because edge detectors must still see the
+ * intermediate value. An assignment that repeats the value of the
+ * assignment just before it does nothing and is dropped.
+ *
+ * This is a deliberate change from running the assignments one at a
+ * time. The vector goes straight to the merged value, so the values
+ * in between are never propagated. A value change callback on the
+ * vector is called once instead of once per part, and a functor that
+ * propagates at once, such as a reduction, does not see the zero
+ * delay glitch the separate updates could cause. The vvp man page
+ * documents this.
+ */
+unsigned long count_assign4_merged = 0;
+
+static bool assign4_merge_(struct event_time_s*ctim, vvp_net_ptr_t ptr,
+			   unsigned base, unsigned vwid,
+			   const vvp_vector4_t&val)
+{
+      if (ctim->nbassign == 0 || ctim->nbassign != assign4_last)
+	    return false;
+
+      struct assign_vector4_event_s*cur = assign4_last;
+      if (! (cur->ptr == ptr) || cur->vwid != vwid)
+	    return false;
+
+      unsigned cur_wid = cur->val.size();
+      if (cur->base == base && cur->val.eeq(val)) {
+	    // Same value as before, so nothing to do.
+
+      } else if (vwid == 0) {
+	    return false;
+
+      } else if (base == cur->base + cur_wid) {
+	    cur->val.resize(cur_wid + val.size());
+	    cur->val.set_vec(cur_wid, val);
+
+      } else if (base + val.size() == cur->base) {
+	    vvp_vector4_t tmp (val.size() + cur_wid);
+	    tmp.set_vec(0, val);
+	    tmp.set_vec(val.size(), cur->val);
+	    cur->val = tmp;
+	    cur->base = base;
+
+      } else {
+	    return false;
+      }
+
+      count_assign4_merged += 1;
+      return true;
+}
+
 void schedule_assign_vector(vvp_net_ptr_t ptr,
 			    unsigned base, unsigned vwid,
 			    const vvp_vector4_t&bit,
 			    vvp_time64_t delay)
 {
+      struct event_time_s*ctim = sched_find_time_(delay);
+      if (assign4_merge_(ctim, ptr, base, vwid, bit))
+	    return;
+
       struct assign_vector4_event_s*cur = new struct assign_vector4_event_s(bit);
       cur->ptr = ptr;
       cur->base = base;
       cur->vwid = vwid;
-      schedule_event_(cur, delay, SEQ_NBASSIGN);
+      schedule_event_at_(cur, ctim, SEQ_NBASSIGN);
+      assign4_last = cur;
 }
 
 void schedule_assign_plucked_vector(vvp_net_ptr_t ptr,
@@ -792,7 +1207,15 @@ void schedule_assign_plucked_vector(vvp_net_ptr_t ptr,
       cur->ptr = ptr;
       cur->vwid = 0;
       cur->base = 0;
-      schedule_event_(cur, delay, SEQ_NBASSIGN);
+
+      struct event_time_s*ctim = sched_find_time_(delay);
+      if (assign4_merge_(ctim, ptr, 0, 0, cur->val)) {
+	    delete cur;
+	    return;
+      }
+
+      schedule_event_at_(cur, ctim, SEQ_NBASSIGN);
+      assign4_last = cur;
 }
 
 void schedule_propagate_plucked_vector(vvp_net_t*net,
@@ -944,7 +1367,6 @@ void schedule_at_start_of_simtime(vvp_gen_event_t obj, vvp_time64_t delay)
       schedule_event_(cur, delay, SEQ_START);
 }
 
-static vvp_time64_t schedule_time;
 vvp_time64_t schedule_simtime(void)
 { return schedule_time; }
 
@@ -998,6 +1420,7 @@ static void run_rosync(struct event_time_s*ctim)
 void schedule_simulate(void)
 {
       bool run_finals;
+      bool run_postsim = true;
       sim_started = false;
 
       schedule_time = 0;
@@ -1044,7 +1467,7 @@ void schedule_simulate(void)
       // process events and when done run the final blocks.
       run_finals = schedule_runnable;
 
-      if (schedule_runnable) while (sched_list) {
+      if (schedule_runnable) while (struct event_time_s*ctim = sched_first_()) {
 
 	    if (schedule_stopped_flag) {
 		  schedule_stopped_flag = false;
@@ -1054,22 +1477,36 @@ void schedule_simulate(void)
 		  continue;
 	    }
 
-	      /* ctim is the current time step. */
-	    struct event_time_s* ctim = sched_list;
-
-	      /* If the time is advancing, then first run the
-		 postponed sync events. Run them all. */
-	    if (ctim->delay > 0) {
+	      /* ctim is the current time step. If the time is
+		 advancing, then first run the postponed sync
+		 events. Run them all. */
+	    vvp_time64_t ctim_delay = sched_first_delay_(ctim);
+	    if (ctim_delay > 0) {
 
 		  if (!schedule_runnable) break;
-		  schedule_time += ctim->delay;
+
+		    /* Take the checkpoint before the first time step
+		       at or past its time. The original process stops
+		       here once its forks are done. Its state is that
+		       of the checkpoint, so it skips the final blocks
+		       and the end of simulation callbacks. */
+		  if (vvp_checkpoint_flag
+		      && schedule_time + ctim_delay >= vvp_checkpoint_time) {
+			if (! vvp_checkpoint_fork()) {
+			      run_finals = false;
+			      run_postsim = false;
+			      break;
+			}
+		  }
+
+		  schedule_time += ctim_delay;
 		    /* When the design is being traced (we are emitting
 		     * file/line information) also print any time changes. */
 		  if (show_file_line) {
 			cerr << "Advancing to simulation time: "
 			     << schedule_time << endl;
 		  }
-		  ctim->delay = 0;
+		  sched_first_advance_(ctim);
 
 		  vpiNextSimTime();
 		    // Process the cbAtStartOfSimTime callbacks.
@@ -1092,6 +1529,7 @@ void schedule_simulate(void)
 	    if (ctim->active == 0) {
 		  ctim->active = ctim->nbassign;
 		  ctim->nbassign = 0;
+		  assign4_last = 0;
 
 		  if (ctim->active == 0) {
 			ctim->active = ctim->rwsync;
@@ -1102,8 +1540,7 @@ void schedule_simulate(void)
 			     deletes threads as needed. */
 			if (ctim->active == 0) {
 			      run_rosync(ctim);
-			      sched_list = ctim->next;
-			      delete ctim;
+			      sched_first_remove_(ctim);
 			      continue;
 			}
 		  }
@@ -1125,7 +1562,13 @@ void schedule_simulate(void)
 		  schedule_single_step_flag = false;
 	    }
 
-	    cur->run_run();
+	    if (vvp_profile_flag) {
+		  vvp_profile_enter_object(cur->profile_object());
+		  cur->run_run();
+		  vvp_profile_leave();
+	    } else {
+		  cur->run_run();
+	    }
 
 	    delete (cur);
       }
@@ -1145,6 +1588,9 @@ void schedule_simulate(void)
 
       signals_revert();
 
+      if (! run_postsim)
+	    return;
+
       if (verbose_flag) {
 	    vpi_mcd_printf(1, " ...execute Postsim callbacks\n");
       }
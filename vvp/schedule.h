@@ -37,6 +37,14 @@ extern void schedule_vthread(vthread_t thr, vvp_time64_t delay,
 
 extern void schedule_final_vthread(vthread_t thr);
 
+/*
+ * This schedules, with no delay, a list of threads linked through
+ * wait_next that the caller has already marked as scheduled. The
+ * whole list is woken by the one event, which runs the threads in
+ * list order.
+ */
+extern void schedule_vthread_list(vthread_t thr);
+
 /*
  * Create an assignment event. The val passed here will be assigned to
  * the specified input when the delay times out. This is scheduled
@@ -146,6 +154,15 @@ struct vvp_gen_event_s
       virtual void single_step_display(void);
 };
 
+/*
+ * Select the structure used to hold the pending time steps. The name
+ * is "wheel" for the timing wheel (the default) or "list" for the
+ * original sorted list. This must be called before any events are
+ * scheduled. Return false if the name is not recognized.
+ */
+extern bool schedule_set_queue(const char*name);
+extern const char* schedule_queue_name(void);
+
 /*
  * This runs the simulator. It runs until all the functors run out or
  * the simulation is otherwise finished.
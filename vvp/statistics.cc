@@ -24,8 +24,14 @@
  */
 unsigned long count_opcodes = 0;
 
+/*
+ * This is a count of the instruction pairs that were fused.
+ */
+unsigned long count_opcodes_fused = 0;
+
 unsigned long count_functors = 0;
 unsigned long count_functors_logic = 0;
+unsigned long count_functors_levelized = 0;
 unsigned long count_functors_bufif = 0;
 unsigned long count_functors_resolv= 0;
 unsigned long count_functors_sig   = 0;
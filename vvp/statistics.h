@@ -27,13 +27,16 @@
 #endif
 
 extern unsigned long count_opcodes;
+extern unsigned long count_opcodes_fused;
 extern unsigned long count_functors;
 extern unsigned long count_functors_logic;
+extern unsigned long count_functors_levelized;
 extern unsigned long count_functors_bufif;
 extern unsigned long count_functors_resolv;
 extern unsigned long count_functors_sig;
 extern unsigned long count_filters;
 extern unsigned long count_vvp_nets;
+extern unsigned long count_vvp_fanouts;
 extern unsigned long count_vpi_nets;
 extern unsigned long count_vpi_scopes;
 
@@ -50,6 +53,7 @@ extern unsigned long count_time_pool(void);
 
 extern unsigned long count_assign_events;
 extern unsigned long count_assign4_pool(void);
+extern unsigned long count_assign4_merged;
 extern unsigned long count_assign8_pool(void);
 extern unsigned long count_assign_real_pool(void);
 extern unsigned long count_assign_aword_pool(void);
@@ -60,6 +64,7 @@ extern unsigned long count_gen_pool(void);
 
 extern size_t size_opcodes;
 extern size_t size_vvp_nets;
+extern size_t size_vvp_fanouts;
 extern size_t size_vvp_net_funs;
 
 #endif
@@ -70,13 +70,15 @@ class symbol_table_s {
 
     private:
       symbol_table_s(const symbol_table_s&) { assert(0); };
-      struct tree_node_*root;
+	// Open addressed hash table of the keys, with linear probing.
+      struct table_entry_*table_;
+      unsigned long table_size_;
+      unsigned long table_used_;
       struct key_strings*str_chunk;
       unsigned str_used;
 
-      symbol_value_t find_value_(struct tree_node_*cur,
-				 const char*key, symbol_value_t val,
-				 bool force_flag);
+      struct table_entry_*find_entry_(const char*key);
+      void grow_table_();
       char*key_strdup_(const char*str);
 };
 
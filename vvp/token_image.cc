@@ -0,0 +1,431 @@
+/*
+ * Copyright (c) 2026 The Icarus Verilog contributors
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "version_base.h"
+# include  "config.h"
+# include  "parse_misc.h"
+# include  "compile.h"
+# include  "parse.h"
+# include  <cstdio>
+# include  <cstdlib>
+# include  <cstring>
+# include  <string>
+# include  <vector>
+# include  <sys/types.h>
+# include  <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+# include  <sys/mman.h>
+# include  <fcntl.h>
+# include  <unistd.h>
+#endif
+# include  "ivl_alloc.h"
+
+/*
+ * The token image is a binary copy of the token stream that the lexor
+ * produces for a design file. It is written next to the design file
+ * the first time the design is compiled with the -i flag, and later
+ * runs that use the -i flag replay the tokens from the image instead
+ * of lexing the text again. The image records the size and a hash
+ * of the contents of the design file and the version of vvp that
+ * wrote it, and is ignored (and rewritten) if any of these changed.
+ * The contents are hashed, and not the modification time, so that
+ * an image stays valid when the design file is copied or touched,
+ * and is not reused when the file is rewritten within the same
+ * second. Hashing the file costs much less than lexing it.
+ *
+ * The image only replaces the lexor. The parser still runs and the
+ * design is linked as usual, because the netlist is made of objects
+ * that cannot be saved and mapped back in.
+ *
+ * After the header, the image is a sequence of records. Each record
+ * starts with a 16bit token code. Tokens that carry a value are
+ * followed by the value: a 32bit length and the characters for text,
+ * a 64bit number for T_NUMBER, and the 32bit width followed by the
+ * text for T_VECTOR. The special code TOKEN_LINE is followed by a
+ * 32bit line number that is assigned to yyline.
+ */
+
+bool token_image_flag = false;
+
+static const char token_image_magic[8] = "VVPTOK2";
+static const uint16_t TOKEN_LINE = 0xffff;
+
+struct token_image_header_s {
+      char magic[8];
+      char version[32];
+	// These are used to detect images written by a different
+	// machine or a different build of the parser.
+      uint32_t byte_order;
+      uint32_t token_check;
+	// These identify the design file that the image was made from.
+      uint64_t src_size;
+      uint64_t src_hash;
+};
+
+enum token_value_e { TV_NONE, TV_TEXT, TV_STRING, TV_NUMB, TV_VECT };
+
+static token_value_e token_value_kind(int tok)
+{
+      switch (tok) {
+	  case T_LABEL:
+	  case T_SYMBOL:
+	  case T_INSTR:
+	    return TV_TEXT;
+	  case T_STRING:
+	    return TV_STRING;
+	  case T_NUMBER:
+	    return TV_NUMB;
+	  case T_VECTOR:
+	    return TV_VECT;
+	  default:
+	    return TV_NONE;
+      }
+}
+
+static uint32_t token_check_value(void)
+{
+      return (uint32_t)T_VECTOR << 24 ^ (uint32_t)K_vpi_call << 12
+	    ^ (uint32_t)T_LABEL << 4 ^ (uint32_t)K_UDP_S;
+}
+
+static std::string image_path;
+static uint64_t src_size = 0;
+static uint64_t src_hash = 0;
+
+  /* State for replaying an image. */
+static char*replay_base = 0;
+static size_t replay_size = 0;
+static bool replay_mapped = false;
+static const char*replay_ptr = 0;
+static const char*replay_end = 0;
+
+  /* State for recording an image. */
+static bool recording = false;
+static std::vector<char> record_buf;
+static unsigned record_line = 0;
+
+static void make_header(struct token_image_header_s&hdr)
+{
+      memset(&hdr, 0, sizeof hdr);
+      memcpy(hdr.magic, token_image_magic, sizeof hdr.magic);
+      strncpy(hdr.version, VERSION, sizeof hdr.version - 1);
+      hdr.byte_order = 0x01020304;
+      hdr.token_check = token_check_value();
+      hdr.src_size = src_size;
+      hdr.src_hash = src_hash;
+}
+
+/*
+ * Calculate the size and the 64bit FNV-1a hash of the contents of
+ * the design file. Return false if the file cannot be read.
+ */
+static bool hash_source(const char*path)
+{
+      FILE*fd = fopen(path, "rb");
+      if (fd == 0)
+	    return false;
+
+      uint64_t hash = 0xcbf29ce484222325ULL;
+      uint64_t size = 0;
+      unsigned char buf[64*1024];
+      size_t cnt;
+      while ((cnt = fread(buf, 1, sizeof buf, fd)) > 0) {
+	    for (size_t idx = 0 ; idx < cnt ; idx += 1) {
+		  hash ^= buf[idx];
+		  hash *= 0x100000001b3ULL;
+	    }
+	    size += cnt;
+      }
+
+      bool ok = ferror(fd) == 0;
+      fclose(fd);
+
+      src_size = size;
+      src_hash = hash;
+      return ok;
+}
+
+static void release_image(void)
+{
+      if (replay_base == 0)
+	    return;
+
+#ifdef HAVE_SYS_MMAN_H
+      if (replay_mapped)
+	    munmap(replay_base, replay_size);
+      else
+	    free(replay_base);
+#else
+      free(replay_base);
+#endif
+      replay_base = 0;
+      replay_size = 0;
+      replay_mapped = false;
+      replay_ptr = 0;
+      replay_end = 0;
+}
+
+/*
+ * Get the contents of the image file into memory, using mmap if it
+ * is available. Return false if the file cannot be read.
+ */
+static bool load_image(void)
+{
+      struct stat img_stat;
+      if (stat(image_path.c_str(), &img_stat) != 0)
+	    return false;
+      if ((size_t)img_stat.st_size < sizeof(struct token_image_header_s))
+	    return false;
+
+      replay_size = img_stat.st_size;
+
+#ifdef HAVE_SYS_MMAN_H
+      int fd = open(image_path.c_str(), O_RDONLY);
+      if (fd < 0)
+	    return false;
+      void*map = mmap(0, replay_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (map != MAP_FAILED) {
+	    replay_base = (char*)map;
+	    replay_mapped = true;
+	    return true;
+      }
+#endif
+
+      FILE*fd_img = fopen(image_path.c_str(), "rb");
+      if (fd_img == 0)
+	    return false;
+      replay_base = (char*)malloc(replay_size);
+      size_t cnt = fread(replay_base, 1, replay_size, fd_img);
+      fclose(fd_img);
+      if (cnt != replay_size) {
+	    release_image();
+	    return false;
+      }
+      return true;
+}
+
+bool token_image_open(const char*path)
+{
+      if (! token_image_flag)
+	    return false;
+
+      if (! hash_source(path))
+	    return false;
+
+      image_path = path;
+      image_path += ".vvpi";
+
+      if (load_image()) {
+	    struct token_image_header_s hdr, cur;
+	    make_header(hdr);
+	    memcpy(&cur, replay_base, sizeof cur);
+	    if (memcmp(&hdr, &cur, sizeof hdr) == 0) {
+		  replay_ptr = replay_base + sizeof cur;
+		  replay_end = replay_base + replay_size;
+		  if (verbose_flag)
+			vpi_mcd_printf(1, " ... Using token image %s\n",
+				       image_path.c_str());
+		  return true;
+	    }
+	    release_image();
+      }
+
+	/* There is no usable image, so the design file will be lexed
+	   and the tokens recorded for the next time. */
+      recording = true;
+      record_buf.clear();
+      record_line = 0;
+      return false;
+}
+
+template <class T> static inline void record_value(T val)
+{
+      const char*ptr = reinterpret_cast<const char*>(&val);
+      record_buf.insert(record_buf.end(), ptr, ptr+sizeof val);
+}
+
+static inline void record_text(const char*text)
+{
+      uint32_t len = strlen(text);
+      record_value(len);
+      record_buf.insert(record_buf.end(), text, text+len);
+}
+
+template <class T> static inline bool replay_value(T&val)
+{
+      if ((size_t)(replay_end - replay_ptr) < sizeof val)
+	    return false;
+      memcpy(&val, replay_ptr, sizeof val);
+      replay_ptr += sizeof val;
+      return true;
+}
+
+/*
+ * Get a string out of the image. The string is allocated the same
+ * way the lexor allocates it, because the parser takes ownership.
+ */
+static char* replay_text(bool new_flag)
+{
+      uint32_t len;
+      if (! replay_value(len))
+	    return 0;
+      if ((size_t)(replay_end - replay_ptr) < len)
+	    return 0;
+
+      char*text = new_flag? new char[len+1] : (char*)malloc(len+1);
+      memcpy(text, replay_ptr, len);
+      text[len] = 0;
+      replay_ptr += len;
+      return text;
+}
+
+static int replay_token(void)
+{
+      uint16_t tok;
+      for (;;) {
+	    if (replay_ptr == replay_end)
+		  return 0;
+	    if (! replay_value(tok))
+		  break;
+	    if (tok != TOKEN_LINE)
+		  break;
+
+	    uint32_t line;
+	    if (! replay_value(line))
+		  break;
+	    yyline = line;
+      }
+
+      switch (token_value_kind(tok)) {
+	  case TV_NONE:
+	    return tok;
+	  case TV_TEXT:
+	    yylval.text = replay_text(false);
+	    if (yylval.text) return tok;
+	    break;
+	  case TV_STRING:
+	    yylval.text = replay_text(true);
+	    if (yylval.text) return tok;
+	    break;
+	  case TV_NUMB:
+	    if (replay_value(yylval.numb)) return tok;
+	    break;
+	  case TV_VECT: {
+		uint32_t idx;
+		if (! replay_value(idx))
+		      break;
+		yylval.vect.idx = idx;
+		yylval.vect.text = replay_text(false);
+		if (yylval.vect.text) return tok;
+		break;
+	  }
+      }
+
+      yyerror("corrupt token image");
+      replay_ptr = replay_end;
+      return 0;
+}
+
+int token_image_lex(void)
+{
+      if (replay_ptr)
+	    return replay_token();
+
+      int tok = yylex();
+      if (! recording)
+	    return tok;
+
+      if (yyline != record_line) {
+	    record_value(TOKEN_LINE);
+	    record_value((uint32_t)yyline);
+	    record_line = yyline;
+      }
+
+      if (tok == 0)
+	    return tok;
+
+	/* A stray character outside the token range cannot be
+	   recorded, but the parse will fail on it anyway. */
+      if (tok < 0 || tok >= TOKEN_LINE) {
+	    recording = false;
+	    return tok;
+      }
+
+      record_value((uint16_t)tok);
+      switch (token_value_kind(tok)) {
+	  case TV_NONE:
+	    break;
+	  case TV_TEXT:
+	  case TV_STRING:
+	    record_text(yylval.text);
+	    break;
+	  case TV_NUMB:
+	    record_value(yylval.numb);
+	    break;
+	  case TV_VECT:
+	    record_value((uint32_t)yylval.vect.idx);
+	    record_text(yylval.vect.text);
+	    break;
+      }
+
+      return tok;
+}
+
+/*
+ * Finish with the token image. If the design file was lexed and the
+ * parse worked, then save the recorded tokens. The image is written
+ * to a temporary file first so that a partly written image is never
+ * used.
+ */
+void token_image_close(bool save_flag)
+{
+      release_image();
+
+      if (! recording)
+	    return;
+      recording = false;
+
+      if (save_flag) {
+	    std::string tmp_path = image_path + ".tmp";
+	    FILE*fd = fopen(tmp_path.c_str(), "wb");
+	    bool ok = fd != 0;
+	    if (ok) {
+		  struct token_image_header_s hdr;
+		  make_header(hdr);
+		  ok = fwrite(&hdr, sizeof hdr, 1, fd) == 1;
+		  if (ok && ! record_buf.empty())
+			ok = fwrite(&record_buf[0], record_buf.size(), 1, fd) == 1;
+		  ok = (fclose(fd) == 0) && ok;
+	    }
+
+	    if (ok && rename(tmp_path.c_str(), image_path.c_str()) == 0) {
+		  if (verbose_flag)
+			vpi_mcd_printf(1, " ... Wrote token image %s\n",
+				       image_path.c_str());
+	    } else {
+		  remove(tmp_path.c_str());
+		  fprintf(stderr, "%s: Unable to write token image.\n",
+			  image_path.c_str());
+	    }
+      }
+
+      record_buf.clear();
+      std::vector<char>().swap(record_buf);
+}
@@ -82,6 +82,88 @@ ostream& operator <<(ostream&o, const struct udp_levels_table&table)
       return o;
 }
 
+/*
+ * A UDP with few enough inputs also gets a dense table with the
+ * output for every possible state of its inputs, so that evaluating
+ * it is a single load instead of a scan of the rows. The index of a
+ * state is a ternary number with a digit for each bit position of
+ * the levels table: 0, 1 or 2 for x. The udp_ternary[m] entry is the
+ * number that has a 1 digit where m has a 1 bit, so the index of a
+ * levels table is udp_ternary[mask1] + 2*udp_ternary[maskx].
+ *
+ * A dense table is made only if it has no more than UDP_DENSE_MAX
+ * entries. That is up to 10 inputs for a combinational UDP and up to
+ * 7 for a sequential UDP, which has more states. Larger UDPs keep
+ * scanning the rows.
+ */
+static const unsigned UDP_DENSE_BITS = 11;
+static const unsigned long UDP_DENSE_MAX = 1UL << 17;
+static unsigned udp_ternary[1 << UDP_DENSE_BITS];
+
+static void udp_ternary_init()
+{
+      if (udp_ternary[1] != 0)
+	    return;
+
+      for (unsigned idx = 1 ;  idx < (1U << UDP_DENSE_BITS) ;  idx += 1)
+	    udp_ternary[idx] = 3*udp_ternary[idx >> 1] + (idx & 1);
+}
+
+static inline unsigned long udp_dense_index(const udp_levels_table&cur)
+{
+      return udp_ternary[cur.mask1] + 2*udp_ternary[cur.maskx];
+}
+
+  /* Return the number of dense table entries for the states of npos
+     bit positions, or 0 if that is too many. */
+static unsigned long udp_dense_states(unsigned npos)
+{
+      if (npos > UDP_DENSE_BITS)
+	    return 0;
+
+      unsigned long res = 1;
+      for (unsigned pp = 0 ;  pp < npos ;  pp += 1)
+	    res *= 3;
+
+      return res <= UDP_DENSE_MAX? res : 0;
+}
+
+  /* Make the levels table for the state with the given index. */
+static udp_levels_table udp_dense_levels(unsigned long idx, unsigned npos)
+{
+      udp_levels_table res;
+      res.mask0 = 0;
+      res.mask1 = 0;
+      res.maskx = 0;
+      for (unsigned pp = 0 ;  pp < npos ;  pp += 1) {
+	    unsigned long mask_bit = 1UL << pp;
+	    switch (idx % 3) {
+		case 0:
+		  res.mask0 |= mask_bit;
+		  break;
+		case 1:
+		  res.mask1 |= mask_bit;
+		  break;
+		default:
+		  res.maskx |= mask_bit;
+		  break;
+	    }
+	    idx /= 3;
+      }
+      return res;
+}
+
+  /* Return the ternary digit of a bit position of a levels table. */
+static inline unsigned udp_dense_digit(const udp_levels_table&cur,
+				       unsigned long mask_bit)
+{
+      if (cur.mask1 & mask_bit)
+	    return 1;
+      if (cur.maskx & mask_bit)
+	    return 2;
+      return 0;
+}
+
 vvp_udp_s::vvp_udp_s(char*label, char*name__, unsigned ports,
                      vvp_bit4_t init, bool type)
 : name_(name__), ports_(ports), init_(init), seq_(type)
@@ -125,12 +207,14 @@ vvp_udp_comb_s::vvp_udp_comb_s(char*label, char*name__, unsigned ports)
       levels1_ = 0;
       nlevels0_ = 0;
       nlevels1_ = 0;
+      dense_ = 0;
 }
 
 vvp_udp_comb_s::~vvp_udp_comb_s()
 {
       delete[] levels0_;
       delete[] levels1_;
+      delete[] dense_;
 }
 
 /*
@@ -188,9 +272,24 @@ vvp_bit4_t vvp_udp_comb_s::calculate_output(const udp_levels_table&cur,
 					    const udp_levels_table&,
 					    vvp_bit4_t)
 {
+      if (dense_)
+	    return (vvp_bit4_t) dense_[udp_dense_index(cur)];
+
       return test_levels(cur);
 }
 
+void vvp_udp_comb_s::compile_dense_()
+{
+      unsigned long nstates = udp_dense_states(port_count());
+      if (nstates == 0)
+	    return;
+
+      udp_ternary_init();
+      dense_ = new unsigned char[nstates];
+      for (unsigned long idx = 0 ;  idx < nstates ;  idx += 1)
+	    dense_[idx] = test_levels(udp_dense_levels(idx, port_count()));
+}
+
 static void or_based_on_char(udp_levels_table&cur, char flag,
 			     unsigned long mask_bit)
 {
@@ -294,6 +393,8 @@ void vvp_udp_comb_s::compile_table(char**tab)
 
       assert(nrows0 == nlevels0_);
       assert(nrows1 == nlevels1_);
+
+      compile_dense_();
 }
 
 vvp_udp_seq_s::vvp_udp_seq_s(char*label, char*name__,
@@ -317,6 +418,8 @@ vvp_udp_seq_s::vvp_udp_seq_s(char*label, char*name__,
       nedges0_ = 0;
       nedges1_ = 0;
       nedgesL_ = 0;
+
+      dense_ = 0;
 }
 
 vvp_udp_seq_s::~vvp_udp_seq_s()
@@ -328,6 +431,7 @@ vvp_udp_seq_s::~vvp_udp_seq_s()
       delete[] edges0_;
       delete[] edges1_;
       delete[] edgesL_;
+      delete[] dense_;
 }
 
 void edge_based_on_char(struct udp_edges_table&cur, char chr, unsigned pos)
@@ -674,6 +778,58 @@ void vvp_udp_seq_s::compile_table(char**tab)
       assert(idx_edg1 == nedges1_);
       assert(idx_edgL == nedgesL_);
 
+      compile_dense_();
+}
+
+/*
+ * The dense table of a sequential UDP holds the next output for every
+ * state of the inputs and the current output, and for every input
+ * that may have made the edge from either of the two other values.
+ * There is a block of states for each edge: the block of input pp and
+ * a previous value one digit past the current value (0->1->x->0) is
+ * block 2*pp, and the other previous value is block 2*pp+1.
+ */
+void vvp_udp_seq_s::compile_dense_()
+{
+      unsigned long nstates = udp_dense_states(port_count()+1);
+      if (nstates == 0 || 2*port_count()*nstates > UDP_DENSE_MAX)
+	    return;
+
+      udp_ternary_init();
+      dense_ = new unsigned char[2*port_count()*nstates];
+
+      unsigned long mask_out = 1UL << port_count();
+      for (unsigned long idx = 0 ;  idx < nstates ;  idx += 1) {
+	    udp_levels_table cur = udp_dense_levels(idx, port_count()+1);
+	    vvp_bit4_t lev = test_levels_(cur);
+
+	    for (unsigned pp = 0 ;  pp < port_count() ;  pp += 1) {
+		  unsigned long mask_bit = 1UL << pp;
+		  unsigned digit = udp_dense_digit(cur, mask_bit);
+		  for (unsigned wh = 0 ;  wh < 2 ;  wh += 1) {
+			udp_levels_table prev = cur;
+			prev.mask0 &= ~(mask_bit|mask_out);
+			prev.mask1 &= ~(mask_bit|mask_out);
+			prev.maskx &= ~(mask_bit|mask_out);
+			switch ((digit + 1 + wh) % 3) {
+			    case 0:
+			      prev.mask0 |= mask_bit;
+			      break;
+			    case 1:
+			      prev.mask1 |= mask_bit;
+			      break;
+			    default:
+			      prev.maskx |= mask_bit;
+			      break;
+			}
+
+			vvp_bit4_t out = lev;
+			if (out == BIT4_Z)
+			      out = test_edges_(cur, prev);
+			dense_[(2*pp+wh)*nstates + idx] = out;
+		  }
+	    }
+      }
 }
 
 bool operator == (const udp_levels_table&a, const udp_levels_table&b)
@@ -709,6 +865,25 @@ vvp_bit4_t vvp_udp_seq_s::calculate_output(const udp_levels_table&cur,
 	    break;
       }
 
+      if (dense_) {
+	      /* Find the input that changed, and the block of the
+	         dense table for that edge. */
+	    unsigned long edge_mask = (cur.mask0 ^ prev.mask0)
+		  | (cur.mask1 ^ prev.mask1) | (cur.maskx ^ prev.maskx);
+	    unsigned pp = 0;
+	    while ((edge_mask & 1) == 0) {
+		  edge_mask >>= 1;
+		  pp += 1;
+	    }
+	    assert(edge_mask == 1);
+
+	    unsigned long mask_bit = 1UL << pp;
+	    unsigned digit = udp_dense_digit(cur, mask_bit);
+	    unsigned wh = udp_dense_digit(prev, mask_bit) == (digit+1) % 3? 0 : 1;
+	    unsigned long nstates = 3 * (unsigned long)udp_ternary[mask_out];
+	    return (vvp_bit4_t) dense_[(2*pp+wh)*nstates + udp_dense_index(cur_tmp)];
+      }
+
       vvp_bit4_t lev = test_levels_(cur_tmp);
       if (lev == BIT4_Z) {
 	    lev = test_edges_(cur_tmp, prev);
@@ -901,63 +1076,77 @@ vvp_bit4_t vvp_udp_seq_s::test_edges_(const udp_levels_table&cur,
       return BIT4_X;
 }
 
-vvp_udp_fun_core::vvp_udp_fun_core(vvp_net_t*net, vvp_udp_s*def)
-: vvp_wide_fun_core(net, def->port_count())
+vvp_udp_fun_t::vvp_udp_fun_t(vvp_net_t*net, vvp_udp_s*def)
+: net_(net), def_(def)
 {
-      def_ = def;
       cur_out_ = def_->get_init();
 	// Assume initially that all the inputs are 1'bx
-      current_.mask0 = 0;
-      current_.mask1 = 0;
-      current_.maskx = ~ ((-1UL) << port_count());
+      mask1_ = 0;
+      maskx_ = ~ ((-1UL) << def_->port_count());
 
       if (cur_out_ != BIT4_X)
 	    schedule_functor(this);
 }
 
-vvp_udp_fun_core::~vvp_udp_fun_core()
+vvp_udp_fun_t::~vvp_udp_fun_t()
 {
 }
 
 /*
- * This method is used to propagate the initial value on startup.
+ * This method is used to propagate the initial value on startup, and
+ * each new output after that.
  */
-void vvp_udp_fun_core::run_run()
+void vvp_udp_fun_t::run_run()
 {
       vvp_vector4_t tmp (1);
       tmp.set_bit(0, cur_out_);
-      propagate_vec4(tmp);
+      net_->send_vec4(tmp, 0);
 }
 
-void vvp_udp_fun_core::recv_vec4_from_inputs(unsigned port)
+void vvp_udp_fun_t::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+                              vvp_context_t)
 {
 	/* For now, assume udps are 1-bit wide. */
-      assert(value(port).size() == 1);
+      assert(bit.size() == 1);
+      recv_input(port.port(), bit.value(0));
+}
 
+void vvp_udp_fun_t::recv_input(unsigned port, vvp_bit4_t bit)
+{
       unsigned long mask = 1UL << port;
+      unsigned long mask1 = mask1_ & ~mask;
+      unsigned long maskx = maskx_ & ~mask;
 
-      udp_levels_table prev = current_;
-
-      switch (value(port).value(0)) {
-
+      switch (bit) {
 	  case BIT4_0:
-	    current_.mask0 |= mask;
-	    current_.mask1 &= ~mask;
-	    current_.maskx &= ~mask;
 	    break;
 	  case BIT4_1:
-	    current_.mask0 &= ~mask;
-	    current_.mask1 |= mask;
-	    current_.maskx &= ~mask;
+	    mask1 |= mask;
 	    break;
 	  default:
-	    current_.mask0 &= ~mask;
-	    current_.mask1 &= ~mask;
-	    current_.maskx |= mask;
+	    maskx |= mask;
 	    break;
       }
 
-      vvp_bit4_t out_bit = def_->calculate_output(current_, prev, cur_out_);
+      if (mask1 == mask1_ && maskx == maskx_)
+	    return;
+
+      unsigned long ports = ~ ((-1UL) << def_->port_count());
+
+      udp_levels_table prev;
+      prev.mask0 = ports & ~(mask1_|maskx_);
+      prev.mask1 = mask1_;
+      prev.maskx = maskx_;
+
+      mask1_ = mask1;
+      maskx_ = maskx;
+
+      udp_levels_table cur;
+      cur.mask0 = ports & ~(mask1|maskx);
+      cur.mask1 = mask1;
+      cur.maskx = maskx;
+
+      vvp_bit4_t out_bit = def_->calculate_output(cur, prev, cur_out_);
 
       if (out_bit == cur_out_)
 	    return;
@@ -966,6 +1155,22 @@ void vvp_udp_fun_core::recv_vec4_from_inputs(unsigned port)
       schedule_functor(this);
 }
 
+vvp_udp_input_t::vvp_udp_input_t(vvp_udp_fun_t*udp, unsigned base)
+: udp_(udp), port_base_(base)
+{
+}
+
+vvp_udp_input_t::~vvp_udp_input_t()
+{
+}
+
+void vvp_udp_input_t::recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+                                vvp_context_t)
+{
+      assert(bit.size() == 1);
+      udp_->recv_input(port_base_ + port.port(), bit.value(0));
+}
+
 
 /*
  * This function is called by the parser in response to a .udp
@@ -980,12 +1185,23 @@ void compile_udp_functor(char*label, char*type,
       free(type);
 
       vvp_net_t*ptr = new vvp_net_t;
-      vvp_udp_fun_core*core = new vvp_udp_fun_core(ptr, def);
-      ptr->fun = core;
+      vvp_udp_fun_t*fun = new vvp_udp_fun_t(ptr, def);
+      ptr->fun = fun;
 
       define_functor_symbol(label, ptr);
       free(label);
 
-      wide_inputs_connect(core, argc, argv);
+	/* The first 4 inputs go to the UDP net itself, and the rest
+	   to input functors that pass them on. */
+      inputs_connect(ptr, argc < 4? argc : 4, argv);
+      for (unsigned base = 4 ;  base < argc ;  base += 4) {
+	    unsigned trans = 4;
+	    if (base+trans > argc)
+		  trans = argc - base;
+
+	    vvp_net_t*inp = new vvp_net_t;
+	    inp->fun = new vvp_udp_input_t(fun, base);
+	    inputs_connect(inp, trans, argv+base);
+      }
       free(argv);
 }
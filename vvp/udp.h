@@ -127,10 +127,16 @@ class vvp_udp_comb_s : public vvp_udp_s {
 				  vvp_bit4_t cur_out);
 
     private:
+      void compile_dense_();
+
 	// Level sensitive rows of the device.
       struct udp_levels_table*levels0_;
       struct udp_levels_table*levels1_;
       unsigned nlevels0_, nlevels1_;
+
+	// The output for every input state, or nil if the device has
+	// too many inputs for that. See compile_dense_().
+      unsigned char*dense_;
 };
 
 /*
@@ -208,6 +214,11 @@ class vvp_udp_seq_s : public vvp_udp_s {
       struct udp_edges_table*edgesL_;
       unsigned nedges0_, nedges1_, nedgesL_;
 
+      void compile_dense_();
+
+	// The next output for every input state, current output and
+	// edge, or nil if the device has too many inputs for that.
+      unsigned char*dense_;
 };
 
 /*
@@ -216,26 +227,50 @@ class vvp_udp_seq_s : public vvp_udp_s {
 struct vvp_udp_s *udp_find(const char *label);
 
 /*
- * The udp_fun_core is the core of the udp instance in the
- * netlist. This core is a vvp_wide_fun_core that takes care of
- * dispatching the output. This class also receives the inputs from
- * the vvp_wide_fun_t objects and processes them to generate the
- * output to be sent.
+ * The vvp_udp_fun_t is a UDP instance in the netlist. There may be
+ * very many of these in a gate level design, so it is kept small: it
+ * is the functor of the output net and receives the first 4 inputs
+ * itself, the current input values are packed into two bit masks and
+ * the output is worked out by the definition. Only a UDP with more
+ * than 4 inputs has vvp_udp_input_t functors, one for each group of 4
+ * further inputs, that pass the values on to the instance.
  */
-class vvp_udp_fun_core  : public vvp_wide_fun_core, private vvp_gen_event_s {
+class vvp_udp_fun_t  : public vvp_net_fun_t, private vvp_gen_event_s {
 
     public:
-      vvp_udp_fun_core(vvp_net_t*net, vvp_udp_s*def);
-      ~vvp_udp_fun_core();
+      vvp_udp_fun_t(vvp_net_t*net, vvp_udp_s*def);
+      ~vvp_udp_fun_t();
 
-      void recv_vec4_from_inputs(unsigned);
+      void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+                     vvp_context_t context);
+
+	// Receive the new value of an input port.
+      void recv_input(unsigned port, vvp_bit4_t bit);
 
     private:
       void run_run();
 
+      vvp_net_t*net_;
       vvp_udp_s*def_;
+	// The current inputs: a bit is set in mask1_ for a 1 input and
+	// in maskx_ for an x or z input. Other inputs are 0.
+      unsigned long mask1_;
+      unsigned long maskx_;
       vvp_bit4_t cur_out_;
-      udp_levels_table current_;
+};
+
+class vvp_udp_input_t : public vvp_net_fun_t {
+
+    public:
+      vvp_udp_input_t(vvp_udp_fun_t*udp, unsigned base);
+      ~vvp_udp_input_t();
+
+      void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
+                     vvp_context_t context);
+
+    private:
+      vvp_udp_fun_t*udp_;
+      unsigned port_base_;
 };
 
 #endif
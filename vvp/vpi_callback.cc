@@ -37,6 +37,7 @@
 # include  <cstdio>
 # include  <cassert>
 # include  <cstdlib>
+# include  <vector>
 /*
  * Callback handles are created when the VPI function registers a
  * callback. The handle is stored by the run time, and it triggered
@@ -414,6 +415,8 @@ static simulator_callback*NextSimTime = 0;
 static simulator_callback*EndOfCompile = 0;
 static simulator_callback*StartOfSimulation = 0;
 static simulator_callback*EndOfSimulation = 0;
+static simulator_callback*StartOfSave = 0;
+static simulator_callback*EndOfRestart = 0;
 
 #ifdef CHECK_WITH_VALGRIND
 /* This is really only needed if the simulator aborts before starting the
@@ -442,6 +445,18 @@ void simulator_cb_delete(void)
 	    EndOfSimulation = dynamic_cast<simulator_callback*>(cur->next);
 	    delete cur;
       }
+
+	/* Delete all the save and restart callbacks. */
+      while (StartOfSave) {
+	    cur = StartOfSave;
+	    StartOfSave = dynamic_cast<simulator_callback*>(cur->next);
+	    delete cur;
+      }
+      while (EndOfRestart) {
+	    cur = EndOfRestart;
+	    EndOfRestart = dynamic_cast<simulator_callback*>(cur->next);
+	    delete cur;
+      }
 }
 #endif
 
@@ -507,6 +522,40 @@ void vpiPostsim(void) {
       vpi_mode_flag = VPI_MODE_NONE;
 }
 
+/*
+ * A checkpoint (see checkpoint.h) is the nearest thing vvp has to a
+ * $save and $restart. The original process invokes the cbStartOfSave
+ * callbacks before it forks, and each of the forks invokes the
+ * cbEndOfRestart callbacks before it runs on from the checkpoint.
+ */
+static void run_save_restart(simulator_callback*&list)
+{
+      simulator_callback* cur;
+
+      assert(vpi_mode_flag == VPI_MODE_NONE);
+      vpi_mode_flag = VPI_MODE_RWSYNC;
+
+      while (list) {
+	    cur = list;
+	    list = dynamic_cast<simulator_callback*>(cur->next);
+	    if (cur->cb_data.cb_rtn)
+		  (cur->cb_data.cb_rtn)(&cur->cb_data);
+	    delete cur;
+      }
+
+      vpi_mode_flag = VPI_MODE_NONE;
+}
+
+void vpiStartOfSave(void)
+{
+      run_save_restart(StartOfSave);
+}
+
+void vpiEndOfRestart(void)
+{
+      run_save_restart(EndOfRestart);
+}
+
 /*
  * The scheduler invokes this to clear out callbacks for the next
  * simulation time.
@@ -549,6 +598,14 @@ static simulator_callback* make_prepost(p_cb_data data)
 	  case cbNextSimTime:
 	    obj->next = NextSimTime;
 	    NextSimTime = obj;
+	    break;
+	  case cbStartOfSave:
+	    obj->next = StartOfSave;
+	    StartOfSave = obj;
+	    break;
+	  case cbEndOfRestart:
+	    obj->next = EndOfRestart;
+	    EndOfRestart = obj;
       }
 
       return obj;
@@ -585,6 +642,8 @@ vpiHandle vpi_register_cb(p_cb_data data)
 	  case cbStartOfSimulation:
 	  case cbEndOfSimulation:
 	  case cbNextSimTime:
+	  case cbStartOfSave:
+	  case cbEndOfRestart:
 	    obj = make_prepost(data);
 	    break;
 
@@ -647,6 +706,7 @@ vvp_vpi_callback::vvp_vpi_callback()
       vpi_callbacks_ = 0;
       array_ = 0;
       array_word_ = 0;
+      record_slot_ = 0;
 }
 
 vvp_vpi_callback::~vvp_vpi_callback()
@@ -668,6 +728,12 @@ void vvp_vpi_callback::add_vpi_callback(value_callback*cb)
       vpi_callbacks_ = cb;
 }
 
+void vvp_vpi_callback::attach_recorder(unsigned slot)
+{
+      assert(record_slot_ == 0);
+      record_slot_ = slot;
+}
+
 #ifdef CHECK_WITH_VALGRIND
 void vvp_vpi_callback::clear_all_callbacks()
 {
@@ -680,6 +746,157 @@ void vvp_vpi_callback::clear_all_callbacks()
 }
 #endif
 
+/*
+ * The value-change recorder is a cheaper way for the waveform dumpers
+ * to follow whole vector signals than a value change callback on each
+ * of them. A recorded signal keeps the index (plus 1) of its slot in
+ * record_slot_, and the first change of the signal in a time step puts
+ * the slot on the pending list. The first slot on the list schedules
+ * a single read-only synch event, which passes the final value of
+ * each pending signal to the function of the client that recorded it.
+ * The pending list is drained from the back, so the values come out
+ * in the same (last changed first) order as the value change
+ * callbacks that the dumpers used before.
+ */
+struct record_slot_s {
+      vvp_signal_value*sig;
+      vpip_record_fun fun;
+      void*user;
+      PLI_INT32 id;
+      bool pending;
+};
+
+static std::vector<record_slot_s> record_slots;
+static std::vector<unsigned> record_pending;
+
+struct record_drain_s : public vvp_gen_event_s {
+      void run_run(void);
+};
+
+static record_drain_s record_drain;
+
+void record_drain_s::run_run(void)
+{
+      const unsigned BITS_PER_LONG = 8*sizeof(unsigned long);
+      vvp_vector4_t val;
+      std::vector<unsigned long> abits, bbits;
+      std::vector<s_vpi_vecval> vec;
+
+      assert(vpi_mode_flag == VPI_MODE_NONE);
+      vpi_mode_flag = VPI_MODE_ROSYNC;
+
+      for (size_t idx = record_pending.size() ; idx > 0 ; idx -= 1) {
+	    record_slot_s&cur = record_slots[record_pending[idx-1]-1];
+	    cur.pending = false;
+
+	    cur.sig->vec4_value(val);
+	    unsigned wid = val.size();
+	    if (cur.fun == 0 || wid == 0)
+		  continue;
+
+	    abits.resize((wid + BITS_PER_LONG - 1) / BITS_PER_LONG);
+	    bbits.resize(abits.size());
+	    val.get_words(&abits[0], &bbits[0]);
+
+	    vec.resize((wid + 31) / 32);
+	    for (unsigned wdx = 0 ; wdx < vec.size() ; wdx += 1) {
+		  unsigned ldx = wdx*32 / BITS_PER_LONG;
+		  unsigned off = wdx*32 % BITS_PER_LONG;
+		  vec[wdx].aval = abits[ldx] >> off;
+		  vec[wdx].bval = bbits[ldx] >> off;
+	    }
+
+	    (cur.fun)(cur.id, schedule_simtime(), wid, &vec[0], cur.user);
+      }
+      record_pending.clear();
+
+      vpi_mode_flag = VPI_MODE_NONE;
+}
+
+static void record_change(unsigned slot)
+{
+      record_slot_s&cur = record_slots[slot-1];
+      if (cur.pending)
+	    return;
+
+      cur.pending = true;
+      if (record_pending.empty())
+	    schedule_generic(&record_drain, 0, true, true);
+      record_pending.push_back(slot);
+}
+
+/*
+ * Stopping a client only clears the function of its slots. The slots
+ * stay attached to their signals, and vpip_record_signal can give
+ * them to a later client.
+ */
+extern "C" void vpip_record_stop(vpip_record_fun fun, void*user)
+{
+      for (size_t idx = 0 ; idx < record_slots.size() ; idx += 1) {
+	    record_slot_s&cur = record_slots[idx];
+	    if (cur.fun == fun && cur.user == user) {
+		  cur.fun = 0;
+		  cur.user = 0;
+	    }
+      }
+}
+
+extern "C" PLI_INT32 vpip_record_signal(vpiHandle ref, PLI_INT32 id,
+					vpip_record_fun fun, void*user)
+{
+      if (fun == 0)
+	    return 0;
+
+      switch (ref->get_type_code()) {
+	  case vpiReg:
+	  case vpiNet:
+	  case vpiIntegerVar:
+	  case vpiBitVar:
+	  case vpiByteVar:
+	  case vpiShortIntVar:
+	  case vpiIntVar:
+	  case vpiLongIntVar:
+	    break;
+	  default:
+	    return 0;
+      }
+
+      if (vpi_get(vpiAutomatic, ref))
+	    return 0;
+
+      struct __vpiSignal*sig = dynamic_cast<__vpiSignal*>(ref);
+      if (sig == 0)
+	    return 0;
+
+      vvp_net_fil_t*fil = sig->node->fil;
+      vvp_signal_value*val = dynamic_cast<vvp_signal_value*>(fil);
+      if (fil == 0 || val == 0)
+	    return 0;
+
+	// A signal has a single slot. It can only be shared with
+	// a client that has stopped recording.
+      unsigned slot = fil->recorder_slot();
+      if (slot != 0) {
+	    record_slot_s&cur = record_slots[slot-1];
+	    if (cur.fun != 0)
+		  return 0;
+	    cur.fun = fun;
+	    cur.user = user;
+	    cur.id = id;
+	    return 1;
+      }
+
+      record_slot_s cur;
+      cur.sig = val;
+      cur.fun = fun;
+      cur.user = user;
+      cur.id = id;
+      cur.pending = false;
+      record_slots.push_back(cur);
+      fil->attach_recorder(record_slots.size());
+      return 1;
+}
+
 /*
  * A vvp_fun_signal uses this method to run its callbacks whenever it
  * has a value change. If the cb_rtn is non-nil, then call the
@@ -689,6 +906,7 @@ void vvp_vpi_callback::clear_all_callbacks()
 void vvp_vpi_callback::run_vpi_callbacks()
 {
       if (array_) array_word_change(array_, array_word_);
+      if (record_slot_) record_change(record_slot_);
 
       value_callback *next = vpi_callbacks_;
       value_callback *prev = 0;
@@ -80,6 +80,36 @@ void vpip_mcd_init(FILE *log)
       logfile = log;
 }
 
+/*
+ * The forks of a checkpoint would share the open files of the
+ * original, and their output and reads would interleave. The files
+ * that $fopen opened cannot be duplicated, so return the name of
+ * the first one that is still open, and the checkpoint is refused.
+ */
+const char* vpip_mcd_open_file(void)
+{
+      for (unsigned idx = 1 ; idx < 31 ; idx += 1) {
+	    if (mcd_table[idx].fp) return mcd_table[idx].filename;
+      }
+      for (unsigned idx = 3 ; idx < fd_table_len ; idx += 1) {
+	    if (fd_table[idx].fp) return fd_table[idx].filename;
+      }
+      return 0;
+}
+
+/*
+ * The standard output of a fork already goes to the log of its
+ * test, so stop copying it to the log file of the original. The
+ * buffer of the log file was flushed before the fork, so closing
+ * it here only closes the copy of the fork.
+ */
+void vpip_mcd_fork_child(void)
+{
+      if (logfile && logfile != stderr)
+	    fclose(logfile);
+      logfile = 0;
+}
+
 #ifdef CHECK_WITH_VALGRIND
 void vpi_mcd_delete(void)
 {
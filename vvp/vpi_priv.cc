@@ -30,6 +30,7 @@
 # include  <cstdlib>
 # include  <cmath>
 # include  <iostream>
+# include  <string>
 
 vpi_mode_t vpi_mode_flag = VPI_MODE_NONE;
 FILE*vpi_trace = 0;
@@ -576,6 +577,12 @@ void vpi_set_vlog_info(int argc, char** argv)
     }
 }
 
+void vpip_set_vlog_args(int argc, char**argv)
+{
+    vpi_vlog_info.argc = argc;
+    vpi_vlog_info.argv = argv;
+}
+
 static void vec4_get_value_string(const vvp_vector4_t&word_val, unsigned width,
 				  s_vpi_value*vp)
 {
@@ -1319,7 +1326,26 @@ vpiHandle vpi_handle_by_name(const char *name, vpiHandle scope)
 	          return 0;
 	    }
       } else {
+	    hand = 0;
+      }
+
+      /* Most names are found in the index of full names. Only the
+       * names that are not there (words of arrays, or a scope named
+       * by its own name) need the search.
+       */
+      if (hand == 0) {
+	    if (vpiHandle out = vpip_find_by_full_name(name))
+		  return out;
 	    hand = find_scope(name, NULL, 0);
+      } else {
+	    std::string full = vpi_get_str(vpiFullName, hand);
+	    size_t len = full.size();
+	    if (strncmp(name, full.c_str(), len) == 0 && name[len] == '.')
+		  full = name;
+	    else
+		  full = full + "." + name;
+	    if (vpiHandle out = vpip_find_by_full_name(full.c_str()))
+		  return out;
       }
 
       if (hand) {
@@ -24,7 +24,6 @@
 # include  "config.h"
 
 # include  <map>
-# include  <set>
 # include  <string>
 
 /*
@@ -248,8 +247,9 @@ struct __vpiScope : public __vpiHandle {
       vvp_context_t live_contexts;
         /* Keep a list of freed contexts. */
       vvp_context_t free_contexts;
-	/* Keep a list of threads in the scope. */
-      std::set<vthread_t> threads;
+	/* Keep a list of threads in the scope. The threads are linked
+	   through their scope_next/scope_prev members. */
+      vthread_t threads;
       signed int time_units :8;
       signed int time_precision :8;
 
@@ -267,6 +267,14 @@ extern vpiHandle vpip_make_root_iterator(void);
 extern void vpip_make_root_iterator(class __vpiHandle**&table,
 				    unsigned&ntable);
 
+/*
+ * Find a scope, or an item in a scope, by its full hierarchical
+ * name. This uses an index of all the full names, so does not search
+ * the scopes. Words of arrays are not in the index. Return 0 if the
+ * name is not found.
+ */
+extern vpiHandle vpip_find_by_full_name(const char*name);
+
 /*
  * Signals include the variable types (reg, integer, time) and are
  * distinguished by the vpiType code. They also have a parent scope,
@@ -675,6 +683,20 @@ vpiHandle vpip_make_vthr_APV(char*label, unsigned index, unsigned bit, unsigned
  */
 extern void vpip_load_module(const char*name);
 
+/*
+ * Replace the arguments that vpi_get_vlog_info() returns. The
+ * checkpoint forks use this to give each fork its own plusargs.
+ */
+extern void vpip_set_vlog_args(int argc, char**argv);
+
+/*
+ * The checkpoint forks refuse to start while a file opened by $fopen
+ * is open, and this returns the name of such a file or nil. Each fork
+ * calls vpip_mcd_fork_child() to let go of the -l log file.
+ */
+extern const char* vpip_mcd_open_file(void);
+extern void vpip_mcd_fork_child(void);
+
 # define VPIP_MODULE_PATH_MAX 64
 extern const char* vpip_module_path[64];
 extern unsigned vpip_module_path_cnt;
@@ -28,6 +28,7 @@
 # include  <cstring>
 # include  <cstdlib>
 # include  <cassert>
+# include  <vector>
 # include  "ivl_alloc.h"
 
 
@@ -394,6 +395,9 @@ struct vpiScopeClass  : public __vpiScope {
  */
 static struct __vpiScope*current_scope = 0;
 
+  /* Adding to any scope makes the name index stale. */
+static bool name_index_valid = false;
+
 void vpip_attach_to_scope(struct __vpiScope*scope, vpiHandle obj)
 {
       assert(scope);
@@ -407,6 +411,7 @@ void vpip_attach_to_scope(struct __vpiScope*scope, vpiHandle obj)
 		  realloc(scope->intern, sizeof(vpiHandle)*scope->nintern);
 
       scope->intern[idx] = obj;
+      name_index_valid = false;
 }
 
 /*
@@ -468,6 +473,7 @@ compile_scope_decl(char*label, char*type, char*name, char*tname,
       scope->nitem = 0;
       scope->live_contexts = 0;
       scope->free_contexts = 0;
+      scope->threads = 0;
 
       if (is_cell) scope->is_cell = true;
       else scope->is_cell = false;
@@ -501,6 +507,7 @@ compile_scope_decl(char*label, char*type, char*name, char*tname,
 		  realloc(vpip_root_table_ptr, cnt * sizeof(vpiHandle));
 	    vpip_root_table_ptr[vpip_root_table_cnt] = scope;
 	    vpip_root_table_cnt = cnt;
+	    name_index_valid = false;
 
 	      /* Root scopes inherit time_units and precision from the
 	         system precision. */
@@ -539,6 +546,116 @@ void vpip_attach_to_current_scope(vpiHandle obj)
       vpip_attach_to_scope(current_scope, obj);
 }
 
+/*
+ * The name index maps the full name of every scope, and of every item
+ * in a scope, to its handle. It is a hash table of the handles only,
+ * so a lookup checks the full name of each candidate. The hash of a
+ * full name is built up from the hash of its parent scope, so the
+ * index is built without making any names. The index is built on
+ * the first lookup, and again on the next lookup after anything is
+ * added to a scope.
+ */
+struct name_index_entry_s {
+      vpiHandle obj;
+      unsigned hash;
+      unsigned next;
+};
+
+static std::vector<name_index_entry_s> name_index;
+static std::vector<unsigned> name_index_table;
+
+static unsigned name_index_hash(unsigned hash, const char*text)
+{
+      while (*text) {
+	    hash = (hash << 4) ^ (hash >> 28) ^ *text;
+	    text += 1;
+      }
+      return hash;
+}
+
+static void name_index_add(vpiHandle obj, unsigned hash)
+{
+      name_index_entry_s ent;
+      ent.obj = obj;
+      ent.hash = hash;
+      ent.next = 0;
+      name_index.push_back(ent);
+}
+
+static void name_index_add_scope(struct __vpiScope*scope, unsigned hash)
+{
+      hash = name_index_hash(hash, ".");
+      for (unsigned idx = 0 ; idx < scope->nintern ; idx += 1) {
+	    vpiHandle item = scope->intern[idx];
+	      /* Ports do not have a full name, so cannot be found by
+	         name (and they would hide the net of the same name). */
+	    if (item->get_type_code() == vpiPort)
+		  continue;
+	    const char*name = item->vpi_get_str(vpiName);
+	    if (name == 0)
+		  continue;
+
+	    unsigned item_hash = name_index_hash(hash, name);
+	    name_index_add(item, item_hash);
+
+	    if (struct __vpiScope*sub = dynamic_cast<__vpiScope*>(item))
+		  name_index_add_scope(sub, item_hash);
+      }
+}
+
+static void name_index_build(void)
+{
+      name_index.clear();
+      for (unsigned idx = 0 ; idx < vpip_root_table_cnt ; idx += 1) {
+	    struct __vpiScope*scope = dynamic_cast<__vpiScope*>
+		  (vpip_root_table_ptr[idx]);
+	    assert(scope);
+	    unsigned hash = name_index_hash(0, scope->name);
+	    name_index_add(scope, hash);
+	    name_index_add_scope(scope, hash);
+      }
+
+	/* Chain the entries in the order they were added, so that the
+	   first of several items with the same name is found. Entry 0
+	   is never in a chain, so 0 marks the end of a chain. */
+      name_index_entry_s nil;
+      nil.obj = 0;
+      nil.hash = 0;
+      nil.next = 0;
+      name_index.insert(name_index.begin(), nil);
+
+      name_index_table.assign(name_index.size() | 1, 0);
+      for (unsigned idx = name_index.size() ; idx > 1 ; idx -= 1) {
+	    name_index_entry_s&ent = name_index[idx-1];
+	    unsigned&head = name_index_table[ent.hash % name_index_table.size()];
+	    ent.next = head;
+	    head = idx-1;
+      }
+
+      name_index_valid = true;
+}
+
+vpiHandle vpip_find_by_full_name(const char*name)
+{
+      if (vpip_root_table_cnt == 0)
+	    return 0;
+      if (! name_index_valid)
+	    name_index_build();
+
+      unsigned hash = name_index_hash(0, name);
+      unsigned idx = name_index_table[hash % name_index_table.size()];
+      for ( ; idx ; idx = name_index[idx].next) {
+	    const name_index_entry_s&ent = name_index[idx];
+	    if (ent.hash != hash)
+		  continue;
+	    const char*full = ent.obj->vpi_get_str(vpiFullName);
+	    if (full && strcmp(name, full) == 0)
+		  return ent.obj;
+      }
+
+      return 0;
+}
+
 struct __vpiScope* vpip_peek_context_scope(void)
 {
       struct __vpiScope*scope = current_scope;
@@ -569,8 +686,8 @@ unsigned vpip_add_item_to_context(automatic_hooks_s*item,
 
       scope->item[idx] = item;
 
-        /* Offset the context index by 2 to leave space for the list links. */
-      return 2 + idx;
+        /* Offset the context index to leave space for the list links. */
+      return VVP_CONTEXT_LINKS + idx;
 }
 
 
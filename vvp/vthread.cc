@@ -28,6 +28,7 @@
 # include  "vvp_cobject.h"
 # include  "vvp_darray.h"
 # include  "class_type.h"
+# include  "profile.h"
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
 #endif
@@ -59,25 +60,33 @@ using namespace std;
  * ** Notes On The Interactions of %fork/%join/%end:
  *
  * The %fork instruction creates a new thread and pushes that into a
- * set of children for the thread. This new thread, then, becomes a
+ * list of children for the thread. This new thread, then, becomes a
  * child of the current thread, and the current thread a parent of the
  * new thread. Any child can be reaped by a %join.
  *
  * Children that are detached with %join/detach need to have a different
  * parent/child relationship since the parent can still effect them if
  * it uses the %disable/fork or %wait/fork opcodes. The i_am_detached
- * flag and detached_children set are used for this relationship.
+ * flag and detached_children list are used for this relationship.
  *
  * Children placed into a task or function scope are given special
  * treatment, which is required to make task/function calls that they
- * represent work correctly. These task/function children are copied
- * into a task_func_children set to mark them for this handling. %join
+ * represent work correctly. A thread has at most one such child at a
+ * time, and it is marked by the task_func_child pointer. %join
  * operations will guarantee that task/function threads are joined first,
- * before any non-task/function threads.
+ * before any non-task/function threads. Note that a task or function
+ * call is always a complete child thread. There is no lighter call
+ * frame on the stack of the caller, because the generated code reaches
+ * the thread bits and contexts of the callee through the %fork/%join
+ * of that child.
+ *
+ * The children lists are linked through the sib_next/sib_prev members
+ * of the children themselves, so that a %fork and its %join do not
+ * allocate anything beyond the thread itself.
  *
  * It is a programming error for a thread that created threads to not
  * %join (or %join/detach) as many as it created before it %ends. The
- * children set will get messed up otherwise.
+ * children list will get messed up otherwise.
  *
  * the i_am_joining flag is a clue to children that the parent is
  * blocked in a %join and may need to be scheduled. The %end
@@ -214,15 +223,21 @@ struct vthread_s {
       unsigned is_scheduled      :1;
       unsigned delay_delete      :1;
 	/* This points to the children of the thread. */
-      set<struct vthread_s*>children;
+      struct vthread_s*children;
 	/* This points to the detached children of the thread. */
-      set<struct vthread_s*>detached_children;
+      struct vthread_s*detached_children;
 	/* No more than 1 of the children are tasks or functions. */
-      set<vthread_s*>task_func_children;
+      struct vthread_s*task_func_child;
+	/* These link me into the children or detached_children list
+	   of my parent. */
+      struct vthread_s*sib_next, *sib_prev;
 	/* This points to my parent, if I have one. */
       struct vthread_s*parent;
 	/* This points to the containing scope. */
       struct __vpiScope*parent_scope;
+	/* These link me into the threads list of the containing
+	   scope. scope_prev is 0 if I am not in the list. */
+      struct vthread_s*scope_next, **scope_prev;
 	/* This is used for keeping wait queues. */
       struct vthread_s*wait_next;
 	/* These are used to access automatically allocated items. */
@@ -233,7 +248,10 @@ struct vthread_s {
 
       inline void cleanup()
       {
-	    bits4 = vvp_vector4_t();
+	      /* Keep a modest bit space for the next user of a pooled
+		 thread object, but not a huge one. */
+	    if (bits4.size() > 1024)
+		  bits4 = vvp_vector4_t();
 	    assert(stack_real_.empty());
 	    assert(stack_str_.empty());
 	    assert(stack_obj_size_ == 0);
@@ -248,6 +266,50 @@ inline vthread_s::vthread_s()
 static bool test_joinable(vthread_t thr, vthread_t child);
 static void do_join(vthread_t thr, vthread_t child);
 
+static inline void thr_list_insert(vthread_t&head, vthread_t thr)
+{
+      thr->sib_prev = 0;
+      thr->sib_next = head;
+      if (head) head->sib_prev = thr;
+      head = thr;
+}
+
+static inline void thr_list_remove(vthread_t&head, vthread_t thr)
+{
+      if (thr->sib_prev) {
+	    thr->sib_prev->sib_next = thr->sib_next;
+      } else {
+	    assert(head == thr);
+	    head = thr->sib_next;
+      }
+      if (thr->sib_next) thr->sib_next->sib_prev = thr->sib_prev;
+      thr->sib_next = 0;
+      thr->sib_prev = 0;
+}
+
+static inline void thr_scope_insert(vthread_t thr)
+{
+      struct __vpiScope*scope = thr->parent_scope;
+      thr->scope_next = scope->threads;
+      thr->scope_prev = &scope->threads;
+      if (scope->threads) scope->threads->scope_prev = &thr->scope_next;
+      scope->threads = thr;
+}
+
+/*
+ * Remove the thread from the threads list of its scope. This may be
+ * called for a thread that has already been removed.
+ */
+static inline void thr_scope_remove(vthread_t thr)
+{
+      if (thr->scope_prev == 0)
+	    return;
+      *thr->scope_prev = thr->scope_next;
+      if (thr->scope_next) thr->scope_next->scope_prev = thr->scope_prev;
+      thr->scope_next = 0;
+      thr->scope_prev = 0;
+}
+
 struct __vpiScope* vthread_scope(struct vthread_s*thr)
 {
       return thr->parent_scope;
@@ -337,33 +399,60 @@ template <class T> T coerce_to_width(const T&that, unsigned width)
 template vvp_vector4_t coerce_to_width(const vvp_vector4_t&that,
                                        unsigned width);
 
-static unsigned long* vector_to_array(struct vthread_s*thr,
-				      unsigned addr, unsigned wid)
+/*
+ * The arithmetic instructions work on the 2-value words of their
+ * operands. A vector_words_t holds those words, in the object itself
+ * for vectors of up to 4 words, so that the common widths do not
+ * allocate on every instruction.
+ */
+class vector_words_t {
+    public:
+      vector_words_t() : ptr_(buf_) { }
+      ~vector_words_t() { if (ptr_ != buf_) delete[]ptr_; }
+
+	// Get the words of the thread vector. Return false if there
+	// are x or z bits in it.
+      bool load(struct vthread_s*thr, unsigned addr, unsigned wid);
+
+      unsigned long&operator[] (unsigned idx) { return ptr_[idx]; }
+      unsigned long*words() { return ptr_; }
+
+    private:
+      enum { BUF_WORDS = 4 };
+      unsigned long buf_[BUF_WORDS];
+      unsigned long*ptr_;
+
+    private: // not implemented
+      vector_words_t(const vector_words_t&);
+      vector_words_t& operator= (const vector_words_t&);
+};
+
+bool vector_words_t::load(struct vthread_s*thr, unsigned addr, unsigned wid)
 {
+      unsigned awid = (wid + CPU_WORD_BITS - 1) / (CPU_WORD_BITS);
+      assert(ptr_ == buf_);
+      if (awid > BUF_WORDS)
+	    ptr_ = new unsigned long[awid];
+
       if (addr == 0) {
-	    unsigned awid = (wid + CPU_WORD_BITS - 1) / (CPU_WORD_BITS);
-	    unsigned long*val = new unsigned long[awid];
 	    for (unsigned idx = 0 ;  idx < awid ;  idx += 1)
-		  val[idx] = 0;
-	    return val;
+		  ptr_[idx] = 0;
+	    return true;
       }
       if (addr == 1) {
-	    unsigned awid = (wid + CPU_WORD_BITS - 1) / (CPU_WORD_BITS);
-	    unsigned long*val = new unsigned long[awid];
 	    for (unsigned idx = 0 ;  idx < awid ;  idx += 1)
-		  val[idx] = -1UL;
+		  ptr_[idx] = -1UL;
 
 	    wid -= (awid-1) * CPU_WORD_BITS;
 	    if (wid < CPU_WORD_BITS)
-		  val[awid-1] &= (-1UL) >> (CPU_WORD_BITS-wid);
-
-	    return val;
+		  ptr_[awid-1] &= (-1UL) >> (CPU_WORD_BITS-wid);
+	    return true;
       }
 
       if (addr < 4)
-	    return 0;
+	    return false;
 
-      return thr->bits4.subarray(addr, wid);
+      return thr->bits4.subarray(addr, wid, ptr_);
 }
 
 /*
@@ -485,7 +574,10 @@ static vvp_context_t vthread_alloc_context(struct __vpiScope*scope)
             }
       }
 
+      vvp_set_prev_context(context, 0);
       vvp_set_next_context(context, scope->live_contexts);
+      if (scope->live_contexts)
+            vvp_set_prev_context(scope->live_contexts, context);
       scope->live_contexts = context;
 
       return context;
@@ -501,16 +593,16 @@ static void vthread_free_context(vvp_context_t context, struct __vpiScope*scope)
       assert(scope->is_automatic);
       assert(context);
 
-      if (context == scope->live_contexts) {
-            scope->live_contexts = vvp_get_next_context(context);
+      vvp_context_t prev = vvp_get_prev_context(context);
+      vvp_context_t next = vvp_get_next_context(context);
+      if (prev) {
+            vvp_set_next_context(prev, next);
       } else {
-            vvp_context_t tmp = scope->live_contexts;
-            while (context != vvp_get_next_context(tmp)) {
-                  assert(tmp);
-                  tmp = vvp_get_next_context(tmp);
-            }
-            vvp_set_next_context(tmp, vvp_get_next_context(context));
+            assert(context == scope->live_contexts);
+            scope->live_contexts = next;
       }
+      if (next)
+            vvp_set_prev_context(next, prev);
 
       vvp_set_next_context(context, scope->free_contexts);
       scope->free_contexts = context;
@@ -533,19 +625,40 @@ void contexts_delete(struct __vpiScope*scope)
 }
 #endif
 
+/*
+ * Deleted threads are kept on this list, linked through wait_next, to
+ * be used again by vthread_new. The stacks and the bit space of a
+ * pooled thread keep their storage, so a fork for a task or function
+ * call usually allocates nothing.
+ */
+static vthread_t thread_pool = 0;
+
 /*
  * Create a new thread with the given start address.
  */
 vthread_t vthread_new(vvp_code_t pc, struct __vpiScope*scope)
 {
-      vthread_t thr = new struct vthread_s;
+      vthread_t thr = thread_pool;
+      if (thr)
+	    thread_pool = thr->wait_next;
+      else
+	    thr = new struct vthread_s;
+
       thr->pc     = pc;
-      thr->bits4  = vvp_vector4_t(32);
+      if (thr->bits4.size() < 32)
+	    thr->bits4 = vvp_vector4_t(32);
+      else
+	    thr->bits4.set_to_x();
       thr->parent = 0;
       thr->parent_scope = scope;
       thr->wait_next = 0;
       thr->wt_context = 0;
       thr->rd_context = 0;
+      thr->children = 0;
+      thr->detached_children = 0;
+      thr->task_func_child = 0;
+      thr->sib_next = 0;
+      thr->sib_prev = 0;
 
       thr->i_am_joining  = 0;
       thr->i_am_detached = 0;
@@ -562,7 +675,7 @@ vthread_t vthread_new(vvp_code_t pc, struct __vpiScope*scope)
       thr_put_bit(thr, 2, BIT4_X);
       thr_put_bit(thr, 3, BIT4_Z);
 
-      scope->threads .insert(thr);
+      thr_scope_insert(thr);
       return thr;
 }
 
@@ -596,11 +709,10 @@ static void child_delete(vthread_t base)
 
 void vthreads_delete(struct __vpiScope*scope)
 {
-      for (std::set<vthread_t>::iterator cur = scope->threads.begin()
-		 ; cur != scope->threads.end() ; ++ cur ) {
-	    delete *cur;
+      while (vthread_t thr = scope->threads) {
+	    thr_scope_remove(thr);
+	    delete thr;
       }
-      scope->threads.clear();
 }
 #endif
 
@@ -610,41 +722,38 @@ void vthreads_delete(struct __vpiScope*scope)
  */
 static void vthread_reap(vthread_t thr)
 {
-      if (! thr->children.empty()) {
-	    for (set<vthread_t>::iterator cur = thr->children.begin()
-		       ; cur != thr->children.end() ; ++cur) {
-		  vthread_t child = *cur;
-		  assert(child);
-		  assert(child->parent == thr);
-		  child->parent = thr->parent;
-	    }
+	/* Children that are still running are orphaned. They are not
+	   passed to the parent of this thread, whose %join does not
+	   expect them, so they reap themselves when they end. */
+      while (thr->children) {
+	    vthread_t child = thr->children;
+	    assert(child->parent == thr);
+	    thr_list_remove(thr->children, child);
+	    child->parent = 0;
       }
-      if (! thr->detached_children.empty()) {
-	    for (set<vthread_t>::iterator cur = thr->detached_children.begin()
-		       ; cur != thr->detached_children.end() ; ++cur) {
-		  vthread_t child = *cur;
-		  assert(child);
-		  assert(child->parent == thr);
-		  assert(child->i_am_detached);
-		  child->parent = 0;
-		  child->i_am_detached = 0;
-	    }
+      thr->task_func_child = 0;
+      while (thr->detached_children) {
+	    vthread_t child = thr->detached_children;
+	    assert(child->parent == thr);
+	    assert(child->i_am_detached);
+	    thr_list_remove(thr->detached_children, child);
+	    child->parent = 0;
+	    child->i_am_detached = 0;
       }
       if (thr->parent) {
-	      /* assert that the given element was removed. */
 	    if (thr->i_am_detached) {
-		  size_t res = thr->parent->detached_children.erase(thr);
-		  assert(res == 1);
+		  thr_list_remove(thr->parent->detached_children, thr);
 	    } else {
-		  size_t res = thr->parent->children.erase(thr);
-		  assert(res == 1);
+		  thr_list_remove(thr->parent->children, thr);
+		  if (thr->parent->task_func_child == thr)
+			thr->parent->task_func_child = 0;
 	    }
       }
 
       thr->parent = 0;
 
 	// Remove myself from the containing scope if needed.
-      thr->parent_scope->threads.erase(thr);
+      thr_scope_remove(thr);
 
       thr->pc = codespace_null();
 
@@ -652,7 +761,7 @@ static void vthread_reap(vthread_t thr)
 	   it now. Otherwise, let the schedule event (which will
 	   execute the thread at of_ZOMBIE) delete the object. */
       if ((thr->is_scheduled == 0) && (thr->waiting_for_event == 0)) {
-	    assert(thr->children.empty());
+	    assert(thr->children == 0);
 	    assert(thr->wait_next == 0);
 	    if (thr->delay_delete)
 		  schedule_del_thr(thr);
@@ -664,7 +773,12 @@ static void vthread_reap(vthread_t thr)
 void vthread_delete(vthread_t thr)
 {
       thr->cleanup();
+#ifdef CHECK_WITH_VALGRIND
       delete thr;
+#else
+      thr->wait_next = thread_pool;
+      thread_pool = thr;
+#endif
 }
 
 void vthread_mark_scheduled(vthread_t thr)
@@ -682,6 +796,25 @@ void vthread_delay_delete()
 	    running_thread->delay_delete = 1;
 }
 
+/*
+ * This is the same as the opcode loop in vthread_run, but it tells
+ * the profiler about the scope of the thread and each opcode.
+ */
+static void vthread_run_profiled_(vthread_t thr)
+{
+      vvp_profile_enter_scope(thr->parent_scope);
+      for (;;) {
+	    vvp_code_t cp = thr->pc;
+	    thr->pc += 1;
+
+	    vvp_profile_opcode(cp);
+	    bool rc = (cp->opcode)(thr, cp);
+	    if (rc == false)
+		  break;
+      }
+      vvp_profile_leave();
+}
+
 /*
  * This function runs each thread by fetching an instruction,
  * incrementing the PC, and executing the instruction. The thread may
@@ -698,6 +831,12 @@ void vthread_run(vthread_t thr)
 
             running_thread = thr;
 
+	    if (vvp_profile_flag) {
+		  vthread_run_profiled_(thr);
+		  thr = tmp;
+		  continue;
+	    }
+
 	    for (;;) {
 		  vvp_code_t cp = thr->pc;
 		  thr->pc += 1;
@@ -726,19 +865,83 @@ bool of_CHUNK_LINK(vthread_t thr, vvp_code_t code)
       return true;
 }
 
+/*
+ * A fused opcode runs a pair of instructions that the code generator
+ * often emits back to back, without going back through the dispatch
+ * in vthread_run between them. The fused opcode replaces the opcode
+ * of the first instruction only. The second instruction is left as
+ * it is, so a jump to it still works and the operands of both are
+ * read from their own vvp_code_s as usual.
+ *
+ * The FIRST opcode of a pair must always return true and must not
+ * change the pc. It must also not replace itself on first use like
+ * %and or %mov do. The SECOND opcode may be anything, including a
+ * branch, and its return value is the result of the pair.
+ */
+template <vvp_code_fun FIRST, vvp_code_fun SECOND>
+static bool of_FUSED(vthread_t thr, vvp_code_t cp)
+{
+      FIRST(thr, cp);
+      thr->pc = cp + 2;
+      return SECOND(thr, cp + 1);
+}
+
+# define FUSE(a,b) { &of_##a, &of_##b, &of_FUSED<&of_##a,&of_##b> }
+
+static const struct fuse_entry_s {
+      vvp_code_fun first;
+      vvp_code_fun second;
+      vvp_code_fun fused;
+} fuse_table[] = {
+      FUSE(CMPU,     JMP0XZ),
+      FUSE(CMPU,     JMP0),
+      FUSE(CMPU,     JMP1),
+      FUSE(CMPS,     JMP0XZ),
+      FUSE(CMPIU,    JMP0XZ),
+      FUSE(CMPX,     JMP0XZ),
+      FUSE(CMPZ,     JMP0XZ),
+      FUSE(IX_LOAD,  ASSIGN_V0),
+      FUSE(IX_LOAD,  IX_LOAD),
+      FUSE(IX_LOAD,  LOAD_AV),
+      FUSE(IX_LOAD,  SET_X0),
+      FUSE(LOAD_VEC, CMPU),
+      FUSE(LOAD_VEC, LOAD_VEC),
+      FUSE(LOAD_VEC, SET_VEC),
+      FUSE(MOVI,     SET_VEC),
+      FUSE(ADD,      SET_VEC),
+      FUSE(SET_VEC,  JMP),
+      { 0, 0, 0 }
+};
+
+# undef FUSE
+
+vvp_code_fun vthread_fused_opcode(vvp_code_fun first, vvp_code_fun second)
+{
+      for (const fuse_entry_s*cur = fuse_table ; cur->first ; cur += 1) {
+	    if (cur->first == first && cur->second == second)
+		  return cur->fused;
+      }
+      return 0;
+}
+
 /*
  * This is called by an event functor to wake up all the threads on
  * its list. I in fact created that list in the %wait instruction, and
- * I also am certain that the waiting_for_event flag is set.
+ * I also am certain that the waiting_for_event flag is set. The list
+ * is marked in the same pass, and then scheduled as a whole by one
+ * event, so a clock edge that releases many threads walks the list
+ * only once before running it.
  */
 void vthread_schedule_list(vthread_t thr)
 {
       for (vthread_t cur = thr ;  cur ;  cur = cur->wait_next) {
 	    assert(cur->waiting_for_event);
+	    assert(cur->is_scheduled == 0);
 	    cur->waiting_for_event = 0;
+	    cur->is_scheduled = 1;
       }
 
-      schedule_vthread(thr, 0);
+      schedule_vthread_list(thr);
 }
 
 vvp_context_t vthread_get_wt_context()
@@ -857,33 +1060,22 @@ bool of_ADD(vthread_t thr, vvp_code_t cp)
 {
       assert(cp->bit_idx[0] >= 4);
 
-      unsigned long*lva = vector_to_array(thr, cp->bit_idx[0], cp->number);
-      unsigned long*lvb = vector_to_array(thr, cp->bit_idx[1], cp->number);
-      if (lva == 0 || lvb == 0)
-	    goto x_out;
+      vector_words_t lva, lvb;
+      if (! lva.load(thr, cp->bit_idx[0], cp->number)
+	  || ! lvb.load(thr, cp->bit_idx[1], cp->number)) {
+	    vvp_vector4_t tmp(cp->number, BIT4_X);
+	    thr->bits4.set_vec(cp->bit_idx[0], tmp);
+	    return true;
+      }
 
-      unsigned long carry;
-      carry = 0;
+      unsigned long carry = 0;
       for (unsigned idx = 0 ;  (idx*CPU_WORD_BITS) < cp->number ;  idx += 1)
 	    lva[idx] = add_with_carry(lva[idx], lvb[idx], carry);
 
-	/* We know from the vector_to_array that the address is valid
-	   in the thr->bitr4 vector, so just do the set bit. */
-
-      thr->bits4.setarray(cp->bit_idx[0], cp->number, lva);
-
-      delete[]lva;
-      delete[]lvb;
-
-      return true;
-
- x_out:
-      delete[]lva;
-      delete[]lvb;
-
-      vvp_vector4_t tmp(cp->number, BIT4_X);
-      thr->bits4.set_vec(cp->bit_idx[0], tmp);
+	/* We know from the load that the address is valid in the
+	   thr->bitr4 vector, so just do the set bit. */
 
+      thr->bits4.setarray(cp->bit_idx[0], cp->number, lva.words());
       return true;
 }
 
@@ -912,33 +1104,23 @@ bool of_ADDI(vthread_t thr, vvp_code_t cp)
 
       unsigned word_count = (bit_width+CPU_WORD_BITS-1)/CPU_WORD_BITS;
 
-      unsigned long*lva = vector_to_array(thr, bit_addr, bit_width);
-      if (lva == 0)
-	    goto x_out;
-
+      vector_words_t lva;
+      if (! lva.load(thr, bit_addr, bit_width)) {
+	    vvp_vector4_t tmp (bit_width, BIT4_X);
+	    thr->bits4.set_vec(bit_addr, tmp);
+	    return true;
+      }
 
-      unsigned long carry;
-      carry = 0;
+      unsigned long carry = 0;
       for (unsigned idx = 0 ;  idx < word_count ;  idx += 1) {
 	    lva[idx] = add_with_carry(lva[idx], imm_value, carry);
 	    imm_value = 0;
       }
 
-	/* We know from the vector_to_array that the address is valid
-	   in the thr->bitr4 vector, so just do the set bit. */
-
-      thr->bits4.setarray(bit_addr, bit_width, lva);
-
-      delete[]lva;
-
-      return true;
-
- x_out:
-      delete[]lva;
-
-      vvp_vector4_t tmp (bit_width, BIT4_X);
-      thr->bits4.set_vec(bit_addr, tmp);
+	/* We know from the load that the address is valid in the
+	   thr->bitr4 vector, so just do the set bit. */
 
+      thr->bits4.setarray(bit_addr, bit_width, lva.words());
       return true;
 }
 
@@ -1430,6 +1612,200 @@ bool of_BREAKPOINT(vthread_t, vvp_code_t)
       return true;
 }
 
+/*
+ * The %case/u table maps the immediate values of the %cmpi/u/%jmp/1
+ * pairs that follow it to the targets of the jumps. If the values
+ * are dense enough, they index the targets directly. Otherwise the
+ * table is an open addressed hash of (value, target) slots. A nil
+ * target is a miss either way.
+ */
+struct vvp_case_table_s {
+      unsigned wid;
+      unsigned count;
+	/* The value of the last pair decides the lt bit of a miss. */
+      unsigned long last;
+      bool dense;
+      unsigned long mask;
+      unsigned long*keys;
+      vvp_code_t*targets;
+	/* This is the instruction after the last pair. */
+      vvp_code_t miss;
+};
+
+/*
+ * The pairs after a %case/u may cross into the next chunk of code
+ * space, so step over the link at the end of a chunk.
+ */
+static inline vvp_code_t case_next_code(vvp_code_t cp)
+{
+      cp += 1;
+      if (cp->opcode == &of_CHUNK_LINK)
+	    cp = cp->cptr;
+      return cp;
+}
+
+static inline unsigned long case_table_hash(const vvp_case_table_s*tab,
+					    unsigned long val)
+{
+      return ((val ^ (val >> 16)) * 2654435761UL) & tab->mask;
+}
+
+static vvp_code_t case_table_find(const vvp_case_table_s*tab,
+				  unsigned long val)
+{
+      if (tab->dense)
+	    return val <= tab->mask? tab->targets[val] : 0;
+
+      for (unsigned long idx = case_table_hash(tab, val)
+		 ; tab->targets[idx] ; idx = (idx+1) & tab->mask) {
+	    if (tab->keys[idx] == val)
+		  return tab->targets[idx];
+      }
+      return 0;
+}
+
+/*
+ * Collect the pairs that follow the %case/u into a table. Return nil
+ * if the instructions are not the pairs that %case/u expects, and
+ * leave the pairs to do the work.
+ */
+static vvp_case_table_s* case_table_build(vvp_code_t cp)
+{
+      unsigned base = cp->bit_idx[0];
+      unsigned count = cp->bit_idx[1];
+      unsigned wid = cp->number;
+
+      vector<unsigned long> vals (count);
+      vector<vvp_code_t> targets (count);
+      unsigned long max_val = 0;
+      vvp_code_t cur = cp;
+      for (unsigned idx = 0 ; idx < count ; idx += 1) {
+	    vvp_code_t cmp = case_next_code(cur);
+	    vvp_code_t jmp = case_next_code(cmp);
+	    if (cmp->opcode != &of_CMPIU || cmp->bit_idx[0] != base
+		|| cmp->number != wid)
+		  return 0;
+	    if (jmp->opcode != &of_JMP1 || jmp->bit_idx[0] != 6)
+		  return 0;
+
+	    vals[idx] = cmp->bit_idx[1];
+	    targets[idx] = jmp->cptr;
+	    if (vals[idx] > max_val)
+		  max_val = vals[idx];
+	    cur = jmp;
+      }
+
+      vvp_case_table_s*tab = new vvp_case_table_s;
+      tab->wid = wid;
+      tab->count = count;
+      tab->last = 0;
+      tab->keys = 0;
+      tab->miss = case_next_code(cur);
+
+	/* A direct table may be up to 4 times larger than the number
+	   of pairs. Otherwise hash into a table that is at most half
+	   full. */
+      tab->dense = max_val < 4UL*tab->count;
+      unsigned long size;
+      if (tab->dense) {
+	    size = max_val + 1;
+	    tab->mask = max_val;
+      } else {
+	    size = 1;
+	    while (size < 2UL*tab->count)
+		  size <<= 1;
+	    tab->mask = size - 1;
+	    tab->keys = new unsigned long[size];
+      }
+      tab->targets = new vvp_code_t[size];
+      for (unsigned long idx = 0 ; idx < size ; idx += 1)
+	    tab->targets[idx] = 0;
+
+	/* The first pair with a value wins, as in the chain. */
+      for (unsigned idx = 0 ; idx < tab->count ; idx += 1) {
+	    unsigned long val = vals[idx];
+	    vvp_code_t target = targets[idx];
+	    tab->last = val;
+	    if (case_table_find(tab, val))
+		  continue;
+
+	    if (tab->dense) {
+		  tab->targets[val] = target;
+		  continue;
+	    }
+
+	    unsigned long slot = case_table_hash(tab, val);
+	    while (tab->targets[slot])
+		  slot = (slot+1) & tab->mask;
+	    tab->keys[slot] = val;
+	    tab->targets[slot] = target;
+      }
+
+      return tab;
+}
+
+#ifdef CHECK_WITH_VALGRIND
+void case_table_delete(vvp_code_t cp)
+{
+      vvp_case_table_s*tab = cp->case_table;
+      delete[]tab->keys;
+      delete[]tab->targets;
+      delete tab;
+}
+#endif
+
+/*
+ * %case/u <bit>, <count>, <wid>
+ *
+ * The first run builds the table for the pairs that follow, then
+ * replaces the opcode with of_CASE_TABLE, which uses it. If there is
+ * no table, the %case/u becomes a %noop and the pairs do the work.
+ */
+bool of_CASE_U(vthread_t thr, vvp_code_t cp)
+{
+      vvp_case_table_s*tab = case_table_build(cp);
+      if (tab == 0) {
+	    cp->opcode = &of_NOOP;
+	    return true;
+      }
+
+      cp->case_table = tab;
+      cp->opcode = &of_CASE_TABLE;
+      return cp->opcode(thr, cp);
+}
+
+bool of_CASE_TABLE(vthread_t thr, vvp_code_t cp)
+{
+      const vvp_case_table_s*tab = cp->case_table;
+      unsigned base = cp->bit_idx[0];
+
+	/* Vectors with x or z bits, and the constant bits, are left to
+	   the compares. So are vectors that do not fit in a word. */
+      if (base < 4 || tab->wid > CPU_WORD_BITS)
+	    return true;
+
+      thr_check_addr(thr, base+tab->wid-1);
+      vvp_vector4_t tmp = thr->bits4.subvalue(base, tab->wid);
+      unsigned long abits, bbits;
+      tmp.get_words(&abits, &bbits);
+      if (bbits)
+	    return true;
+
+      vvp_code_t target = case_table_find(tab, abits);
+      if (target) {
+	    thr_put_bit(thr, 4, BIT4_1);
+	    thr_put_bit(thr, 5, BIT4_0);
+	    thr_put_bit(thr, 6, BIT4_1);
+	    thr->pc = target;
+      } else {
+	    thr_put_bit(thr, 4, BIT4_0);
+	    thr_put_bit(thr, 5, abits < tab->last? BIT4_1 : BIT4_0);
+	    thr_put_bit(thr, 6, BIT4_0);
+	    thr->pc = tab->miss;
+      }
+      return true;
+}
+
 /*
  * The %cassign/link instruction connects a source node to a
  * destination node. The destination node must be a signal, as it is
@@ -1786,13 +2162,13 @@ bool of_CMPIU(vthread_t thr, vvp_code_t cp)
       unsigned long imm  = cp->bit_idx[1];
       unsigned wid  = cp->number;
 
-      unsigned long*array = vector_to_array(thr, addr, wid);
+      vector_words_t array;
 	// If there are xz bits in the right hand expression, then we
 	// have to do the compare the hard way. That is because even
 	// though we know that eeq must be false (the immediate value
 	// cannot have x or z bits) we don't know what the EQ or LT
 	// bits will be.
-      if (array == 0)
+      if (! array.load(thr, addr, wid))
 	    return of_CMPIU_the_hard_way(thr, cp);
 
       unsigned words = (wid+CPU_WORD_BITS-1) / CPU_WORD_BITS;
@@ -1806,8 +2182,6 @@ bool of_CMPIU(vthread_t thr, vvp_code_t cp)
 	    lt = (array[idx] < imm) ? BIT4_1 : BIT4_0;
       }
 
-      delete[]array;
-
       thr_put_bit(thr, 4, eq);
       thr_put_bit(thr, 5, lt);
       thr_put_bit(thr, 6, eq);
@@ -1860,14 +2234,9 @@ bool of_CMPU(vthread_t thr, vvp_code_t cp)
       unsigned idx2 = cp->bit_idx[1];
       unsigned wid  = cp->number;
 
-      unsigned long*larray = vector_to_array(thr, idx1, wid);
-      if (larray == 0) return of_CMPU_the_hard_way(thr, cp);
-
-      unsigned long*rarray = vector_to_array(thr, idx2, wid);
-      if (rarray == 0) {
-	    delete[]larray;
+      vector_words_t larray, rarray;
+      if (! larray.load(thr, idx1, wid) || ! rarray.load(thr, idx2, wid))
 	    return of_CMPU_the_hard_way(thr, cp);
-      }
 
       unsigned words = (wid+CPU_WORD_BITS-1) / CPU_WORD_BITS;
 
@@ -1882,9 +2251,6 @@ bool of_CMPU(vthread_t thr, vvp_code_t cp)
 		  lt = BIT4_0;
       }
 
-      delete[]larray;
-      delete[]rarray;
-
       thr_put_bit(thr, 4, eq);
       thr_put_bit(thr, 5, lt);
       thr_put_bit(thr, 6, eq);
@@ -2198,7 +2564,7 @@ static bool do_disable(vthread_t thr, vthread_t match)
       bool flag = false;
 
 	/* Pull the target thread out of its scope if needed. */
-      thr->parent_scope->threads.erase(thr);
+      thr_scope_remove(thr);
 
 	/* Turn the thread off by setting is program counter to
 	   zero and setting an OFF bit. */
@@ -2208,10 +2574,9 @@ static bool do_disable(vthread_t thr, vthread_t match)
 	/* Turn off all the children of the thread. Simulate a %join
 	   for as many times as needed to clear the results of all the
 	   %forks that this thread has done. */
-      while (! thr->children.empty()) {
+      while (thr->children) {
 
-	    vthread_t tmp = *(thr->children.begin());
-	    assert(tmp);
+	    vthread_t tmp = thr->children;
 	    assert(tmp->parent == thr);
 	    thr->i_am_joining = 0;
 	    if (do_disable(tmp, match))
@@ -2258,10 +2623,8 @@ bool of_DISABLE(vthread_t thr, vvp_code_t cp)
 
       bool disabled_myself_flag = false;
 
-      while (! scope->threads.empty()) {
-	    set<vthread_t>::iterator cur = scope->threads.begin();
-
-	    if (do_disable(*cur, thr))
+      while (scope->threads) {
+	    if (do_disable(scope->threads, thr))
 		  disabled_myself_flag = true;
       }
 
@@ -2279,12 +2642,11 @@ bool of_DISABLE_FORK(vthread_t thr, vvp_code_t)
       assert(! thr->i_am_joining);
 
 	/* There should be no active children to disable. */
-      assert(thr->children.empty());
+      assert(thr->children == 0);
 
 	/* Disable any detached children. */
-      while (! thr->detached_children.empty()) {
-	    vthread_t child = *(thr->detached_children.begin());
-	    assert(child);
+      while (thr->detached_children) {
+	    vthread_t child = thr->detached_children;
 	    assert(child->parent == thr);
 	      /* Disabling the children can never match the parent thread. */
 	    bool res = do_disable(child, thr);
@@ -2431,16 +2793,8 @@ bool of_DIV(vthread_t thr, vvp_code_t cp)
 
       assert(adra >= 4);
 
-      unsigned long*ap = vector_to_array(thr, adra, wid);
-      if (ap == 0) {
-	    vvp_vector4_t tmp(wid, BIT4_X);
-	    thr->bits4.set_vec(adra, tmp);
-	    return true;
-      }
-
-      unsigned long*bp = vector_to_array(thr, adrb, wid);
-      if (bp == 0) {
-	    delete[]ap;
+      vector_words_t ap, bp;
+      if (! ap.load(thr, adra, wid) || ! bp.load(thr, adrb, wid)) {
 	    vvp_vector4_t tmp(wid, BIT4_X);
 	    thr->bits4.set_vec(adra, tmp);
 	    return true;
@@ -2453,17 +2807,13 @@ bool of_DIV(vthread_t thr, vvp_code_t cp)
 		  thr->bits4.set_vec(adra, tmp);
 	    } else {
 		  ap[0] /= bp[0];
-		  thr->bits4.setarray(adra, wid, ap);
+		  thr->bits4.setarray(adra, wid, ap.words());
 	    }
-	    delete[]ap;
-	    delete[]bp;
 	    return true;
       }
 
-      unsigned long*result = divide_bits(ap, bp, wid);
+      unsigned long*result = divide_bits(ap.words(), bp.words(), wid);
       if (result == 0) {
-	    delete[]ap;
-	    delete[]bp;
 	    vvp_vector4_t tmp(wid, BIT4_X);
 	    thr->bits4.set_vec(adra, tmp);
 	    return true;
@@ -2474,8 +2824,6 @@ bool of_DIV(vthread_t thr, vvp_code_t cp)
 	//  input-a = bp * result + ap;
 
       thr->bits4.setarray(adra, wid, result);
-      delete[]ap;
-      delete[]bp;
       delete[]result;
       return true;
 }
@@ -2500,16 +2848,8 @@ bool of_DIV_S(vthread_t thr, vvp_code_t cp)
 	// Get the values, left in right, in binary form. If there is
 	// a problem with either (caused by an X or Z bit) then we
 	// know right away that the entire result is X.
-      unsigned long*ap = vector_to_array(thr, adra, wid);
-      if (ap == 0) {
-	    vvp_vector4_t tmp(wid, BIT4_X);
-	    thr->bits4.set_vec(adra, tmp);
-	    return true;
-      }
-
-      unsigned long*bp = vector_to_array(thr, adrb, wid);
-      if (bp == 0) {
-	    delete[]ap;
+      vector_words_t ap, bp;
+      if (! ap.load(thr, adra, wid) || ! bp.load(thr, adrb, wid)) {
 	    vvp_vector4_t tmp(wid, BIT4_X);
 	    thr->bits4.set_vec(adra, tmp);
 	    return true;
@@ -2535,10 +2875,8 @@ bool of_DIV_S(vthread_t thr, vvp_code_t cp)
 		  long tmpb = (long) bp[0];
 		  long res = tmpa / tmpb;
 		  ap[0] = ((unsigned long)res) & ~sign_mask;
-		  thr->bits4.setarray(adra, wid, ap);
+		  thr->bits4.setarray(adra, wid, ap.words());
 	    }
-	    delete[]ap;
-	    delete[]bp;
 	    return true;
       }
 
@@ -2547,17 +2885,15 @@ bool of_DIV_S(vthread_t thr, vvp_code_t cp)
       bool negate_flag = false;
       if ( ((long) ap[words-1]) < 0 ) {
 	    negate_flag = true;
-	    negate_words(ap, words);
+	    negate_words(ap.words(), words);
       }
       if ( ((long) bp[words-1]) < 0 ) {
 	    negate_flag ^= true;
-	    negate_words(bp, words);
+	    negate_words(bp.words(), words);
       }
 
-      unsigned long*result = divide_bits(ap, bp, wid);
+      unsigned long*result = divide_bits(ap.words(), bp.words(), wid);
       if (result == 0) {
-	    delete[]ap;
-	    delete[]bp;
 	    vvp_vector4_t tmp(wid, BIT4_X);
 	    thr->bits4.set_vec(adra, tmp);
 	    return true;
@@ -2570,8 +2906,6 @@ bool of_DIV_S(vthread_t thr, vvp_code_t cp)
       result[words-1] &= ~sign_mask;
 
       thr->bits4.setarray(adra, wid, result);
-      delete[]ap;
-      delete[]bp;
       delete[]result;
       return true;
 }
@@ -2603,19 +2937,18 @@ bool of_END(vthread_t thr, vvp_code_t)
       thr->pc = codespace_null();
 
 	/* Fully detach any detached children. */
-      while (! thr->detached_children.empty()) {
-	    vthread_t child = *(thr->detached_children.begin());
-	    assert(child);
+      while (thr->detached_children) {
+	    vthread_t child = thr->detached_children;
 	    assert(child->parent == thr);
 	    assert(child->i_am_detached);
+	    thr_list_remove(thr->detached_children, child);
 	    child->parent = 0;
 	    child->i_am_detached = 0;
-	    thr->detached_children.erase(thr->detached_children.begin());
       }
 
 	/* It is an error to still have active children running at this
 	 * point in time. They should have all been detached or joined. */
-      assert(thr->children.empty());
+      assert(thr->children == 0);
 
 	/* If I have a parent who is waiting for me, then mark that I
 	   have ended, and schedule that parent. Also, finish the
@@ -2642,12 +2975,11 @@ bool of_END(vthread_t thr, vvp_code_t)
       if (thr->i_am_detached) {
 	    vthread_t tmp = thr->parent;
 	    assert(tmp);
-	    size_t res = tmp->detached_children.erase(thr);
-	    assert(res == 1);
+	    thr_list_remove(tmp->detached_children, thr);
 	      /* If the parent is waiting for the detached children to
 	       * finish then the last detached child needs to tell the
 	       * parent to wake up when it is finished. */
-	    if (tmp->i_am_waiting && tmp->detached_children.empty()) {
+	    if (tmp->i_am_waiting && tmp->detached_children == 0) {
 		  tmp->i_am_waiting = 0;
 		  schedule_vthread(tmp, 0, true);
 	    }
@@ -2823,19 +3155,21 @@ bool of_FORK(vthread_t thr, vvp_code_t cp)
       }
 
       child->parent = thr;
-      thr->children.insert(child);
+      thr_list_insert(thr->children, child);
 
 	/* If the child scope is not the same as the current scope,
 	   infer that this is a task or function call. */
       switch (cp->scope->get_type_code()) {
 	  case vpiFunction:
-	    thr->task_func_children.insert(child);
+	    assert(thr->task_func_child == 0);
+	    thr->task_func_child = child;
 	    child->is_scheduled = 1;
 	    vthread_run(child);
 	    running_thread = thr;
 	    break;
 	  case vpiTask:
-	    thr->task_func_children.insert(child);
+	    assert(thr->task_func_child == 0);
+	    thr->task_func_child = child;
 	    schedule_vthread(child, 0, true);
 	    break;
 	  default:
@@ -3154,19 +3488,16 @@ bool of_JMP1(vthread_t thr, vvp_code_t cp)
 
 static bool test_joinable(vthread_t thr, vthread_t child)
 {
-      set<vthread_t>::iterator cur = thr->task_func_children.find(child);
-      if (! thr->task_func_children.empty() && cur == thr->task_func_children.end())
-	    return false;
-
-      return true;
+      return thr->task_func_child == 0 || thr->task_func_child == child;
 }
 
 static void do_join(vthread_t thr, vthread_t child)
 {
       assert(child->parent == thr);
 
-	/* Remove the thread from the task/function set if needed. */
-      thr->task_func_children.erase(child);
+	/* Remove the thread from the task/function slot if needed. */
+      if (thr->task_func_child == child)
+	    thr->task_func_child = 0;
 
         /* If the immediate child thread is in an automatic scope... */
       if (child->wt_context) {
@@ -3188,19 +3519,25 @@ static void do_join(vthread_t thr, vthread_t child)
 bool of_JOIN(vthread_t thr, vvp_code_t)
 {
       assert( !thr->i_am_joining );
-      assert( !thr->children.empty());
+      assert( thr->children );
+
+	// A task or function child must be joined first, so it is the
+	// only candidate if there is one.
+      if (vthread_t curp = thr->task_func_child) {
+	    if (curp->i_have_ended) {
+		  do_join(thr, curp);
+		  return true;
+	    }
+	    thr->i_am_joining = 1;
+	    return false;
+      }
 
 	// Are there any children that have already ended? If so, then
 	// join with that one.
-      for (set<vthread_t>::iterator cur = thr->children.begin()
-		 ; cur != thr->children.end() ; ++cur) {
-	    vthread_t curp = *cur;
+      for (vthread_t curp = thr->children ; curp ; curp = curp->sib_next) {
 	    if (! curp->i_have_ended)
 		  continue;
 
-	    if (! test_joinable(thr, curp))
-		  continue;
-
 	      // found something!
 	    do_join(thr, curp);
 	    return true;
@@ -3220,12 +3557,13 @@ bool of_JOIN_DETACH(vthread_t thr, vvp_code_t cp)
 {
       unsigned long count = cp->number;
 
-      assert(thr->task_func_children.empty());
-      assert(count == thr->children.size());
+      assert(thr->task_func_child == 0);
 
-      while (! thr->children.empty()) {
-	    vthread_t child = *thr->children.begin();
+      while (thr->children) {
+	    vthread_t child = thr->children;
 	    assert(child->parent == thr);
+	    assert(count > 0);
+	    count -= 1;
 
 	      // We cannot detach automatic tasks/functions within an
 	      // automatic scope. If we try to do that, we might make
@@ -3237,12 +3575,12 @@ bool of_JOIN_DETACH(vthread_t thr, vvp_code_t cp)
 		  vthread_reap(child);
 
 	    } else {
-		  size_t res = child->parent->children.erase(child);
-		  assert(res == 1);
+		  thr_list_remove(thr->children, child);
 		  child->i_am_detached = 1;
-		  thr->detached_children.insert(child);
+		  thr_list_insert(thr->detached_children, child);
 	    }
       }
+      assert(count == 0);
 
       return true;
 }
@@ -4092,16 +4430,8 @@ bool of_MUL(vthread_t thr, vvp_code_t cp)
 
       assert(adra >= 4);
 
-      unsigned long*ap = vector_to_array(thr, adra, wid);
-      if (ap == 0) {
-	    vvp_vector4_t tmp(wid, BIT4_X);
-	    thr->bits4.set_vec(adra, tmp);
-	    return true;
-      }
-
-      unsigned long*bp = vector_to_array(thr, adrb, wid);
-      if (bp == 0) {
-	    delete[]ap;
+      vector_words_t ap, bp;
+      if (! ap.load(thr, adra, wid) || ! bp.load(thr, adrb, wid)) {
 	    vvp_vector4_t tmp(wid, BIT4_X);
 	    thr->bits4.set_vec(adra, tmp);
 	    return true;
@@ -4110,9 +4440,7 @@ bool of_MUL(vthread_t thr, vvp_code_t cp)
 	// If the value fits in a single CPU word, then do it the easy way.
       if (wid <= CPU_WORD_BITS) {
 	    ap[0] *= bp[0];
-	    thr->bits4.setarray(adra, wid, ap);
-	    delete[]ap;
-	    delete[]bp;
+	    thr->bits4.setarray(adra, wid, ap.words());
 	    return true;
       }
 
@@ -4136,8 +4464,6 @@ bool of_MUL(vthread_t thr, vvp_code_t cp)
       }
 
       thr->bits4.setarray(adra, wid, res);
-      delete[]ap;
-      delete[]bp;
       delete[]res;
       return true;
 }
@@ -4159,9 +4485,9 @@ bool of_MULI(vthread_t thr, vvp_code_t cp)
 
       assert(adr >= 4);
 
-      unsigned long*val = vector_to_array(thr, adr, wid);
+      vector_words_t val;
 	// If there are X bits in the value, then return X.
-      if (val == 0) {
+      if (! val.load(thr, adr, wid)) {
 	    vvp_vector4_t tmp(cp->number, BIT4_X);
 	    thr->bits4.set_vec(cp->bit_idx[0], tmp);
 	    return true;
@@ -4170,18 +4496,16 @@ bool of_MULI(vthread_t thr, vvp_code_t cp)
 	// If everything fits in a word, then do it the easy way.
       if (wid <= CPU_WORD_BITS) {
 	    val[0] *= imm;
-	    thr->bits4.setarray(adr, wid, val);
-	    delete[]val;
+	    thr->bits4.setarray(adr, wid, val.words());
 	    return true;
       }
 
       unsigned words = (wid+CPU_WORD_BITS-1) / CPU_WORD_BITS;
       unsigned long*res = new unsigned long[words];
 
-      multiply_array_imm(res, val, words, imm);
+      multiply_array_imm(res, val.words(), words, imm);
 
       thr->bits4.setarray(adr, wid, res);
-      delete[]val;
       delete[]res;
       return true;
 }
@@ -4813,10 +5137,10 @@ bool of_PUTC_STR_V(vthread_t thr, vvp_code_t cp)
 
 	/* Extract the character from the vector space. If that byte
 	   is null (8'h00) then the standard says it is to be skipped. */
-      unsigned long*tmp = vector_to_array(thr, base, 8);
-      assert(tmp);
+      vector_words_t tmp;
+      bool tmp_ok = tmp.load(thr, base, 8);
+      assert(tmp_ok);
       char tmp_val = tmp[0] & 0xff;
-      delete [] tmp;
       if (tmp_val == 0)
 	    return true;
 
@@ -5433,34 +5757,22 @@ bool of_SUB(vthread_t thr, vvp_code_t cp)
 {
       assert(cp->bit_idx[0] >= 4);
 
-      unsigned long*lva = vector_to_array(thr, cp->bit_idx[0], cp->number);
-      unsigned long*lvb = vector_to_array(thr, cp->bit_idx[1], cp->number);
-      if (lva == 0 || lvb == 0)
-	    goto x_out;
-
+      vector_words_t lva, lvb;
+      if (! lva.load(thr, cp->bit_idx[0], cp->number)
+	  || ! lvb.load(thr, cp->bit_idx[1], cp->number)) {
+	    vvp_vector4_t tmp(cp->number, BIT4_X);
+	    thr->bits4.set_vec(cp->bit_idx[0], tmp);
+	    return true;
+      }
 
-      unsigned long carry;
-      carry = 1;
+      unsigned long carry = 1;
       for (unsigned idx = 0 ;  (idx*CPU_WORD_BITS) < cp->number ;  idx += 1)
 	    lva[idx] = add_with_carry(lva[idx], ~lvb[idx], carry);
 
+	/* We know from the load that the address is valid in the
+	   thr->bitr4 vector, so just do the set bit. */
 
-	/* We know from the vector_to_array that the address is valid
-	   in the thr->bitr4 vector, so just do the set bit. */
-
-      thr->bits4.setarray(cp->bit_idx[0], cp->number, lva);
-      delete[]lva;
-      delete[]lvb;
-
-      return true;
-
- x_out:
-      delete[]lva;
-      delete[]lvb;
-
-      vvp_vector4_t tmp(cp->number, BIT4_X);
-      thr->bits4.set_vec(cp->bit_idx[0], tmp);
-
+      thr->bits4.setarray(cp->bit_idx[0], cp->number, lva.words());
       return true;
 }
 
@@ -5478,33 +5790,23 @@ bool of_SUBI(vthread_t thr, vvp_code_t cp)
 
       unsigned word_count = (cp->number+CPU_WORD_BITS-1)/CPU_WORD_BITS;
       unsigned long imm = cp->bit_idx[1];
-      unsigned long*lva = vector_to_array(thr, cp->bit_idx[0], cp->number);
-      if (lva == 0)
-	    goto x_out;
-
+      vector_words_t lva;
+      if (! lva.load(thr, cp->bit_idx[0], cp->number)) {
+	    vvp_vector4_t tmp(cp->number, BIT4_X);
+	    thr->bits4.set_vec(cp->bit_idx[0], tmp);
+	    return true;
+      }
 
-      unsigned long carry;
-      carry = 1;
+      unsigned long carry = 1;
       for (unsigned idx = 0 ;  idx < word_count ;  idx += 1) {
 	    lva[idx] = add_with_carry(lva[idx], ~imm, carry);
 	    imm = 0UL;
       }
 
-	/* We know from the vector_to_array that the address is valid
-	   in the thr->bitr4 vector, so just do the set bit. */
-
-      thr->bits4.setarray(cp->bit_idx[0], cp->number, lva);
-
-      delete[]lva;
-
-      return true;
-
- x_out:
-      delete[]lva;
-
-      vvp_vector4_t tmp(cp->number, BIT4_X);
-      thr->bits4.set_vec(cp->bit_idx[0], tmp);
+	/* We know from the load that the address is valid in the
+	   thr->bitr4 vector, so just do the set bit. */
 
+      thr->bits4.setarray(cp->bit_idx[0], cp->number, lva.words());
       return true;
 }
 
@@ -5640,11 +5942,11 @@ bool of_WAIT_FORK(vthread_t thr, vvp_code_t)
       assert(! thr->i_am_waiting);
 
 	/* There should be no active children when waiting. */
-      assert(thr->children.empty());
+      assert(thr->children == 0);
 
 	/* If there are no detached children then there is nothing to
 	 * wait for. */
-      if (thr->detached_children.empty()) return true;
+      if (thr->detached_children == 0) return true;
 
 	/* Flag that this process is waiting for the detached children
 	 * to finish and suspend it. */
@@ -5715,7 +6017,7 @@ bool of_XOR(vthread_t thr, vvp_code_t cp)
 bool of_ZOMBIE(vthread_t thr, vvp_code_t)
 {
       thr->pc = codespace_null();
-      if ((thr->parent == 0) && (thr->children.empty())) {
+      if ((thr->parent == 0) && (thr->children == 0)) {
 	    if (thr->delay_delete)
 		  schedule_del_thr(thr);
 	    else
@@ -5736,7 +6038,7 @@ bool of_EXEC_UFUNC(vthread_t thr, vvp_code_t cp)
       struct __vpiScope*child_scope = cp->ufunc_core_ptr->func_scope();
       assert(child_scope);
 
-      assert(thr->children.empty());
+      assert(thr->children == 0);
 
         /* We can take a number of shortcuts because we know that a
            continuous assignment can only occur in a static scope. */
@@ -5768,7 +6070,7 @@ bool of_EXEC_UFUNC(vthread_t thr, vvp_code_t cp)
       if (child->i_have_ended)
             return true;
 
-      thr->children.insert(child);
+      thr_list_insert(thr->children, child);
       thr->i_am_joining = 1;
       return false;
 }
@@ -25,6 +25,8 @@
 # include  "resolv.h"
 # include  "schedule.h"
 # include  "statistics.h"
+# include  "profile.h"
+# include  "slab.h"
 # include  <cstdio>
 # include  <cstring>
 # include  <cstdlib>
@@ -33,13 +35,16 @@
 # include  <climits>
 # include  <cmath>
 # include  <cassert>
+# include  <vector>
+#ifdef __SSE2__
+# include  <emmintrin.h>
+#endif
 #ifdef CHECK_WITH_VALGRIND
 # include  <valgrind/memcheck.h>
 # include  <map>
 # include  "sfunc.h"
-# include  "udp.h"
-# include  "ivl_alloc.h"
 #endif
+# include  "ivl_alloc.h"
 
 permaheap vvp_net_fun_t::heap_;
 permaheap vvp_net_fil_t::heap_;
@@ -52,17 +57,29 @@ static vvp_net_t **vvp_net_pool = NULL;
 static unsigned vvp_net_pool_count = 0;
 #endif
 static size_t vvp_net_alloc_remaining = 0;
+// The alloc chunks, so that compact_fanout can visit every net.
+static vector<vvp_net_t*> vvp_net_chunks;
+// The block that compact_fanout puts the fan-out arrays in.
+static char*vvp_fanout_block = 0;
+static size_t vvp_fanout_block_size = 0;
 // For statistics, count the vvp_nets allocated and the bytes of alloc
 // chunks allocated.
 unsigned long count_vvp_nets = 0;
 size_t size_vvp_nets = 0;
+// Also count the fan-out arrays and the bytes they use after they
+// are compacted.
+unsigned long count_vvp_fanouts = 0;
+size_t size_vvp_fanouts = 0;
 
 void* vvp_net_t::operator new (size_t size)
 {
       assert(size == sizeof(vvp_net_t));
+	// The FANOUT_LIST bit relies on the nets being 8-byte aligned.
+      assert(size % 8 == 0);
       if (vvp_net_alloc_remaining == 0) {
 	    vvp_net_alloc_table = ::new vvp_net_t[VVP_NET_CHUNK];
 	    vvp_net_alloc_remaining = VVP_NET_CHUNK;
+	    vvp_net_chunks.push_back(vvp_net_alloc_table);
 	    size_vvp_nets += size*VVP_NET_CHUNK;
 #ifdef CHECK_WITH_VALGRIND
 	    VALGRIND_MAKE_MEM_NOACCESS(vvp_net_alloc_table, size*VVP_NET_CHUNK);
@@ -83,13 +100,13 @@ void* vvp_net_t::operator new (size_t size)
       vvp_net_alloc_table += 1;
       vvp_net_alloc_remaining -= 1;
       count_vvp_nets += 1;
+      if (vvp_profile_flag) vvp_profile_net(return_this);
       return return_this;
 }
 
 #ifdef CHECK_WITH_VALGRIND
 static map<vvp_net_t*, bool> vvp_net_map;
 static map<sfunc_core*, bool> sfunc_map;
-static map<vvp_udp_fun_core*, bool> udp_map;
 static map<resolv_core*, bool> resolv_map;
 static vvp_net_t **local_net_pool = 0;
 static unsigned local_net_pool_count = 0;
@@ -108,9 +125,6 @@ void vvp_net_delete(vvp_net_t *item)
       if (sfunc_core*tmp = dynamic_cast<sfunc_core*> (item->fun)) {
 	    sfunc_map[tmp] = true;
       }
-      if (vvp_udp_fun_core*tmp = dynamic_cast<vvp_udp_fun_core*> (item->fun)) {
-	    udp_map[tmp] = true;
-      }
       if (resolv_core*tmp = dynamic_cast<resolv_core*> (item->fun)) {
 	    resolv_map[tmp] = true;
       }
@@ -128,6 +142,8 @@ void vvp_net_pool_delete()
 {
       unsigned long vvp_nets_del = 0;
 
+      vvp_net_t::delete_fanout();
+
       for (unsigned idx = 0; idx < local_net_pool_count; idx += 1) {
 	    vvp_net_delete(local_net_pool[idx]);
       }
@@ -148,12 +164,6 @@ void vvp_net_pool_delete()
       }
       sfunc_map.clear();
 
-      map<vvp_udp_fun_core*, bool>::iterator uiter;
-      for (uiter = udp_map.begin(); uiter != udp_map.end(); ++ uiter ) {
-	    delete uiter->first;
-      }
-      udp_map.clear();
-
       map<resolv_core*, bool>::iterator riter;
       for (riter = resolv_map.begin(); riter != resolv_map.end(); ++ riter ) {
 	    delete riter->first;
@@ -184,51 +194,183 @@ void vvp_net_t::operator delete(void*)
 
 vvp_net_t::vvp_net_t()
 {
-      out_ = vvp_net_ptr_t(0,0);
+      out_ = 0;
       fun = 0;
       fil = 0;
 }
 
+/*
+ * The size of a fanout_s with room for cnt receivers. This is kept a
+ * multiple of 8, so that the arrays packed in the compacted block are
+ * aligned for the FANOUT_LIST bit.
+ */
+size_t vvp_net_t::fanout_bytes_(unsigned cnt)
+{
+      size_t bytes = sizeof(fanout_s) + sizeof(vvp_net_ptr_t) * cnt
+	    - sizeof(vvp_net_ptr_t);
+      return (bytes + 7) & ~(size_t)7;
+}
+
+static inline bool fanout_in_block(const void*list)
+{
+      const char*ptr = static_cast<const char*>(list);
+      return ptr >= vvp_fanout_block
+	    && ptr < vvp_fanout_block + vvp_fanout_block_size;
+}
+
+/*
+ * Add the port to the end of the receivers of this net. A net with no
+ * receivers keeps the port in out_. A second receiver moves both into
+ * an array, and a full array is moved to one twice the size. An array
+ * in the compacted block is never freed, only left behind.
+ */
 void vvp_net_t::link(vvp_net_ptr_t port_to_link)
 {
-      vvp_net_t*net = port_to_link.ptr();
-      net->port[port_to_link.port()] = out_;
-      out_ = port_to_link;
+      assert(! port_to_link.nil());
+      assert((port_to_link.bits() & FANOUT_LIST) == 0);
+
+      if (out_ == 0) {
+	    out_ = port_to_link.bits();
+	    return;
+      }
+
+      fanout_s*list;
+      if (! (out_ & FANOUT_LIST)) {
+	    list = static_cast<fanout_s*> (malloc(fanout_bytes_(2)));
+	    list->count = 1;
+	    list->alloc = 2;
+	    list->list[0] = vvp_net_ptr_t(out_);
+	    out_ = reinterpret_cast<unsigned long> (list) | FANOUT_LIST;
+
+      } else {
+	    list = fanout_list_();
+	    if (list->count == list->alloc) {
+		  unsigned alloc = list->alloc < 2? 2 : list->alloc * 2;
+		  fanout_s*tmp;
+		  if (fanout_in_block(list)) {
+			tmp = static_cast<fanout_s*> (malloc(fanout_bytes_(alloc)));
+			tmp->count = list->count;
+			for (unsigned idx = 0 ; idx < list->count ; idx += 1)
+			      tmp->list[idx] = list->list[idx];
+		  } else {
+			tmp = static_cast<fanout_s*> (realloc(list, fanout_bytes_(alloc)));
+		  }
+		  list = tmp;
+		  list->alloc = alloc;
+		  out_ = reinterpret_cast<unsigned long> (list) | FANOUT_LIST;
+	    }
+      }
+
+      list->list[list->count] = port_to_link;
+      list->count += 1;
 }
 
 /*
  * Unlink a ptr object from the driver. The input is the driver in the
  * form of a vvp_net_t pointer. The .out member of that object is the
  * driver. The dst_ptr argument is the receiver pin to be located and
- * removed from the fan-out list.
+ * removed from the fan-out list. The receivers after it move down, so
+ * that the order of the rest is kept.
  */
 void vvp_net_t::unlink(vvp_net_ptr_t dst_ptr)
 {
-      vvp_net_t*net = dst_ptr.ptr();
-      unsigned net_port = dst_ptr.port();
-
-      if (out_ == dst_ptr) {
-	      /* If the drive fan-out list starts with this pointer,
-		 then the unlink is easy. Pull the list forward. */
-	    out_ = net->port[net_port];
-      } else if (! out_.nil()) {
-	      /* Scan the linked list, looking for the net_ptr_t
-		 pointer *before* the one we wish to remove. */
-	    vvp_net_ptr_t cur = out_;
-	    assert(!cur.nil());
-	    vvp_net_t*cur_net = cur.ptr();
-	    unsigned cur_port = cur.port();
-	    while (cur_net && cur_net->port[cur_port] != dst_ptr) {
-		  cur = cur_net->port[cur_port];
-		  cur_net = cur.ptr();
-		  cur_port = cur.port();
+      if (! (out_ & FANOUT_LIST)) {
+	    if (out_ == dst_ptr.bits())
+		  out_ = 0;
+	    return;
+      }
+
+      fanout_s*list = fanout_list_();
+      for (unsigned idx = 0 ; idx < list->count ; idx += 1) {
+	    if (list->list[idx] != dst_ptr)
+		  continue;
+
+	    list->count -= 1;
+	    for ( ; idx < list->count ; idx += 1)
+		  list->list[idx] = list->list[idx+1];
+	    return;
+      }
+}
+
+/*
+ * Move the fan-out arrays of all the nets into one block, in the
+ * order that the nets were allocated. Each array is made exactly the
+ * size of its receivers, and the arrays that were grown while the
+ * design was compiled are freed.
+ */
+void vvp_net_t::compact_fanout(void)
+{
+      assert(vvp_fanout_block == 0);
+
+      size_t need = 0;
+      for (size_t idx = 0 ; idx < vvp_net_chunks.size() ; idx += 1) {
+	    vvp_net_t*chunk = vvp_net_chunks[idx];
+	      // Only the last chunk has nets that are not yet allocated.
+	    size_t used = VVP_NET_CHUNK;
+	    if (idx+1 == vvp_net_chunks.size())
+		  used -= vvp_net_alloc_remaining;
+	    for (size_t net = 0 ; net < used ; net += 1) {
+		  if (chunk[net].out_ & FANOUT_LIST)
+			need += fanout_bytes_(chunk[net].fanout_list_()->count);
+	    }
+      }
+
+      if (need == 0)
+	    return;
+
+      vvp_fanout_block = static_cast<char*> (malloc(need));
+      vvp_fanout_block_size = need;
+      size_vvp_fanouts = need;
+
+      char*cur = vvp_fanout_block;
+      for (size_t idx = 0 ; idx < vvp_net_chunks.size() ; idx += 1) {
+	    vvp_net_t*chunk = vvp_net_chunks[idx];
+	    size_t used = VVP_NET_CHUNK;
+	    if (idx+1 == vvp_net_chunks.size())
+		  used -= vvp_net_alloc_remaining;
+	    for (size_t net = 0 ; net < used ; net += 1) {
+		  if (! (chunk[net].out_ & FANOUT_LIST))
+			continue;
+
+		  fanout_s*list = chunk[net].fanout_list_();
+		  size_t bytes = fanout_bytes_(list->count);
+		  memcpy(cur, list, bytes);
+		  free(list);
+
+		  list = reinterpret_cast<fanout_s*> (cur);
+		  list->alloc = list->count;
+		  chunk[net].out_ = reinterpret_cast<unsigned long> (list) | FANOUT_LIST;
+		  cur += bytes;
+		  count_vvp_fanouts += 1;
+	    }
+      }
+      assert(cur == vvp_fanout_block + need);
+}
+
+#ifdef CHECK_WITH_VALGRIND
+void vvp_net_t::delete_fanout(void)
+{
+      for (size_t idx = 0 ; idx < vvp_net_chunks.size() ; idx += 1) {
+	    vvp_net_t*chunk = vvp_net_chunks[idx];
+	    size_t used = VVP_NET_CHUNK;
+	    if (idx+1 == vvp_net_chunks.size())
+		  used -= vvp_net_alloc_remaining;
+	    for (size_t net = 0 ; net < used ; net += 1) {
+		  if (! (chunk[net].out_ & FANOUT_LIST))
+			continue;
+		  fanout_s*list = chunk[net].fanout_list_();
+		  if (! fanout_in_block(list))
+			free(list);
+		  chunk[net].out_ = 0;
 	    }
-	      /* Unlink. */
-	    if (cur_net) cur_net->port[cur_port] = net->port[net_port];
       }
+      vvp_net_chunks.clear();
 
-      net->port[net_port] = vvp_net_ptr_t(0,0);
+      free(vvp_fanout_block);
+      vvp_fanout_block = 0;
+      vvp_fanout_block_size = 0;
 }
+#endif
 
 void vvp_net_t::count_drivers(unsigned idx, unsigned counts[4])
 {
@@ -346,16 +488,10 @@ void vvp_net_fil_t::release_mask(vvp_vector2_t mask)
 
 /*
  * Force link/unlink uses a thunk vvp_net_t node with a vvp_fun_force
- * functor to translate the net values to filter commands. The ports
- * of this vvp_net_t object are use a little differently:
- *
- *     port[3]  - Point to the destination node where the forced
- *                filter resides.
- *
- *     port[2]  - Point to the input node that drives port[0] for use
- *                by the unlink method.
- *
- *     port[0]  - This is the normal input.
+ * functor to translate the net values to filter commands. The
+ * functor holds the destination node where the forced filter
+ * resides, and the input node that drives its port-0, for use by the
+ * unlink method.
  */
 void vvp_net_fil_t::force_link(vvp_net_t*dst, vvp_net_t*src)
 {
@@ -363,17 +499,14 @@ void vvp_net_fil_t::force_link(vvp_net_t*dst, vvp_net_t*src)
 
       if (force_link_ == 0) {
 	    force_link_ = new vvp_net_t;
-	      // Use port[3] to hold the force destination.
-	    force_link_->port[3] = vvp_net_ptr_t(dst, 0);
-	    force_link_->port[2] = vvp_net_ptr_t(0,0);
-	    force_link_->fun = new vvp_fun_force;
+	    force_link_->fun = new vvp_fun_force(dst);
       }
 
       force_unlink();
-      assert(force_link_->port[2] == vvp_net_ptr_t(0,0));
+      vvp_fun_force*fun = static_cast<vvp_fun_force*>(force_link_->fun);
+      assert(fun->src_ == 0);
 
-	// Use port[2] to hold the force source.
-      force_link_->port[2] = vvp_net_ptr_t(src,0);
+      fun->src_ = src;
 
       vvp_net_ptr_t dst_ptr(force_link_, 0);
       src->link(dst_ptr);
@@ -387,11 +520,12 @@ void vvp_net_fil_t::operator delete(void*)
 void vvp_net_fil_t::force_unlink(void)
 {
       if (force_link_ == 0) return;
-      vvp_net_t*src = force_link_->port[2].ptr();
+      vvp_fun_force*fun = static_cast<vvp_fun_force*>(force_link_->fun);
+      vvp_net_t*src = fun->src_;
       if (src == 0) return;
 
       src->unlink(vvp_net_ptr_t(force_link_,0));
-      force_link_->port[2] = vvp_net_ptr_t(0,0);
+      fun->src_ = 0;
 }
 
 /* *** BIT operations *** */
@@ -512,54 +646,196 @@ int edge(vvp_bit4_t from, vvp_bit4_t to)
 
 void vvp_send_vec8(vvp_net_ptr_t ptr, const vvp_vector8_t&val)
 {
-      while (vvp_net_t*cur = ptr.ptr()) {
-	    vvp_net_ptr_t next = cur->port[ptr.port()];
+      vvp_net_t*cur = ptr.ptr();
+      if (cur && cur->fun)
+	    cur->fun->recv_vec8(ptr, val);
+}
 
-	    if (cur->fun)
-		  cur->fun->recv_vec8(ptr, val);
+void vvp_send_real(vvp_net_ptr_t ptr, double val, vvp_context_t context)
+{
+      vvp_net_t*cur = ptr.ptr();
+      if (cur && cur->fun)
+	    cur->fun->recv_real(ptr, val, context);
+}
 
-	    ptr = next;
-      }
+void vvp_send_long(vvp_net_ptr_t ptr, long val)
+{
+      vvp_net_t*cur = ptr.ptr();
+      if (cur && cur->fun)
+	    cur->fun->recv_long(ptr, val);
 }
 
-void vvp_send_real(vvp_net_ptr_t ptr, double val, vvp_context_t context)
+void vvp_send_long_pv(vvp_net_ptr_t ptr, long val,
+                      unsigned base, unsigned wid)
 {
-      while (vvp_net_t*cur = ptr.ptr()) {
-	    vvp_net_ptr_t next = cur->port[ptr.port()];
+      vvp_net_t*cur = ptr.ptr();
+      if (cur && cur->fun)
+	    cur->fun->recv_long_pv(ptr, val, base, wid);
+}
 
-	    if (cur->fun)
-		  cur->fun->recv_real(ptr, val, context);
+const vvp_vector4_t vvp_vector4_t::nil;
 
-	    ptr = next;
-      }
+/*
+ * These are kernels for the vvp_vector4_t methods that process whole
+ * arrays of abits or bbits words. If SSE2 is available (it always is
+ * on x86_64) they process 128 bits at a time, and the remaining words
+ * are processed one at a time.
+ */
+#ifdef __SSE2__
+static const unsigned SSE_WORDS = sizeof(__m128i) / sizeof(unsigned long);
+
+static inline __m128i sse_load(const unsigned long*ptr)
+{
+      return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
 }
 
-void vvp_send_long(vvp_net_ptr_t ptr, long val)
+static inline void sse_store(unsigned long*ptr, __m128i val)
 {
-      while (vvp_net_t*cur = ptr.ptr()) {
-	    vvp_net_ptr_t next = cur->port[ptr.port()];
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), val);
+}
+#endif
 
-	    if (cur->fun)
-		  cur->fun->recv_long(ptr, val);
+static inline bool words_eq(const unsigned long*a, const unsigned long*b,
+			    unsigned cnt)
+{
+      unsigned idx = 0;
+#ifdef __SSE2__
+      for ( ;  idx+SSE_WORDS <= cnt ;  idx += SSE_WORDS) {
+	    __m128i tmp = _mm_cmpeq_epi8(sse_load(a+idx), sse_load(b+idx));
+	    if (_mm_movemask_epi8(tmp) != 0xffff)
+		  return false;
+      }
+#endif
+      for ( ;  idx < cnt ;  idx += 1) {
+	    if (a[idx] != b[idx])
+		  return false;
+      }
+      return true;
+}
 
-	    ptr = next;
+static inline bool words_any(const unsigned long*a, unsigned cnt)
+{
+      unsigned idx = 0;
+#ifdef __SSE2__
+      if (cnt >= SSE_WORDS) {
+	    __m128i acc = _mm_setzero_si128();
+	    for ( ;  idx+SSE_WORDS <= cnt ;  idx += SSE_WORDS)
+		  acc = _mm_or_si128(acc, sse_load(a+idx));
+	    acc = _mm_cmpeq_epi8(acc, _mm_setzero_si128());
+	    if (_mm_movemask_epi8(acc) != 0xffff)
+		  return true;
       }
+#endif
+      for ( ;  idx < cnt ;  idx += 1) {
+	    if (a[idx])
+		  return true;
+      }
+      return false;
 }
 
-void vvp_send_long_pv(vvp_net_ptr_t ptr, long val,
-                      unsigned base, unsigned wid)
+  /* Copy the src words to the dst words and return true if any of
+     them changed. */
+static inline bool words_update(unsigned long*dst, const unsigned long*src,
+				unsigned cnt)
 {
-      while (vvp_net_t*cur = ptr.ptr()) {
-	    vvp_net_ptr_t next = cur->port[ptr.port()];
+      if (words_eq(dst, src, cnt))
+	    return false;
+      for (unsigned idx = 0 ;  idx < cnt ;  idx += 1)
+	    dst[idx] = src[idx];
+      return true;
+}
 
-	    if (cur->fun)
-		  cur->fun->recv_long_pv(ptr, val, base, wid);
+  /* The 4-value AND of the (aa,ab) words with the (ba,bb) words. */
+static inline void words_and4(unsigned long*aa, unsigned long*ab,
+			      const unsigned long*ba, const unsigned long*bb,
+			      unsigned cnt)
+{
+      unsigned idx = 0;
+#ifdef __SSE2__
+      for ( ;  idx+SSE_WORDS <= cnt ;  idx += SSE_WORDS) {
+	    __m128i va = sse_load(aa+idx);
+	    __m128i vb = sse_load(ab+idx);
+	    __m128i wb = sse_load(bb+idx);
+	    __m128i tmp1 = _mm_or_si128(va, vb);
+	    __m128i tmp2 = _mm_or_si128(sse_load(ba+idx), wb);
+	    sse_store(aa+idx, _mm_and_si128(tmp1, tmp2));
+	    sse_store(ab+idx, _mm_or_si128(_mm_and_si128(tmp1, wb),
+					   _mm_and_si128(tmp2, vb)));
+      }
+#endif
+      for ( ;  idx < cnt ;  idx += 1) {
+	    unsigned long tmp1 = aa[idx] | ab[idx];
+	    unsigned long tmp2 = ba[idx] | bb[idx];
+	    aa[idx] = tmp1 & tmp2;
+	    ab[idx] = (tmp1 & bb[idx]) | (tmp2 & ab[idx]);
+      }
+}
 
-	    ptr = next;
+  /* The 4-value OR of the (aa,ab) words with the (ba,bb) words. */
+static inline void words_or4(unsigned long*aa, unsigned long*ab,
+			     const unsigned long*ba, const unsigned long*bb,
+			     unsigned cnt)
+{
+      unsigned idx = 0;
+#ifdef __SSE2__
+      for ( ;  idx+SSE_WORDS <= cnt ;  idx += SSE_WORDS) {
+	    __m128i va = sse_load(aa+idx);
+	    __m128i vb = sse_load(ab+idx);
+	    __m128i wa = sse_load(ba+idx);
+	    __m128i wb = sse_load(bb+idx);
+	    __m128i tmp = _mm_or_si128(_mm_or_si128(va, vb),
+				       _mm_or_si128(wa, wb));
+	      // (~a|b)&c is the same as ~(a&~b)&c
+	    __m128i tmp1 = _mm_andnot_si128(_mm_andnot_si128(vb, va), wb);
+	    __m128i tmp2 = _mm_andnot_si128(_mm_andnot_si128(wb, wa), vb);
+	    sse_store(ab+idx, _mm_or_si128(tmp1, tmp2));
+	    sse_store(aa+idx, tmp);
+      }
+#endif
+      for ( ;  idx < cnt ;  idx += 1) {
+	    unsigned long tmp = aa[idx] | ab[idx] | ba[idx] | bb[idx];
+	    ab[idx] = ((~aa[idx] | ab[idx]) & bb[idx]) |
+		      ((~ba[idx] | bb[idx]) & ab[idx]);
+	    aa[idx] = tmp;
       }
 }
 
-const vvp_vector4_t vvp_vector4_t::nil;
+  /* The 4-value XOR of the (aa,ab) words with the (ba,bb) words. */
+static inline void words_xor4(unsigned long*aa, unsigned long*ab,
+			      const unsigned long*ba, const unsigned long*bb,
+			      unsigned cnt)
+{
+      unsigned idx = 0;
+#ifdef __SSE2__
+      for ( ;  idx+SSE_WORDS <= cnt ;  idx += SSE_WORDS) {
+	    __m128i tmp = _mm_or_si128(sse_load(ab+idx), sse_load(bb+idx));
+	    __m128i val = _mm_xor_si128(sse_load(aa+idx), sse_load(ba+idx));
+	    sse_store(aa+idx, _mm_or_si128(val, tmp));
+	    sse_store(ab+idx, tmp);
+      }
+#endif
+      for ( ;  idx < cnt ;  idx += 1) {
+	    unsigned long tmp = ab[idx] | bb[idx];
+	    aa[idx] = (aa[idx] ^ ba[idx]) | tmp;
+	    ab[idx] = tmp;
+      }
+}
+
+  /* The 4-value NOT of the (aa,ab) words. The bbits do not change. */
+static inline void words_invert(unsigned long*aa, const unsigned long*ab,
+				unsigned cnt)
+{
+      unsigned idx = 0;
+#ifdef __SSE2__
+      const __m128i ones = _mm_set1_epi32(-1);
+      for ( ;  idx+SSE_WORDS <= cnt ;  idx += SSE_WORDS) {
+	    __m128i tmp = _mm_andnot_si128(sse_load(ab+idx), sse_load(aa+idx));
+	    sse_store(aa+idx, _mm_xor_si128(tmp, ones));
+      }
+#endif
+      for ( ;  idx < cnt ;  idx += 1)
+	    aa[idx] = ~aa[idx] | ab[idx];
+}
 
 void vvp_vector4_t::copy_bits(const vvp_vector4_t&that)
 {
@@ -567,10 +843,8 @@ void vvp_vector4_t::copy_bits(const vvp_vector4_t&that)
       if (size_ == that.size_) {
 	    if (size_ > BITS_PER_WORD) {
 		  unsigned words = (size_+BITS_PER_WORD-1) / BITS_PER_WORD;
-		  for (unsigned idx = 0 ;  idx < words ;  idx += 1)
-			abits_ptr_[idx] = that.abits_ptr_[idx];
-		  for (unsigned idx = 0 ;  idx < words ;  idx += 1)
-			bbits_ptr_[idx] = that.bbits_ptr_[idx];
+		  copy_words_(abits_ptr_, that.abits_ptr_, words);
+		  copy_words_(bbits_ptr_, that.bbits_ptr_, words);
 	    } else {
 		  abits_val_ = that.abits_val_;
 		  bbits_val_ = that.bbits_val_;
@@ -586,7 +860,8 @@ void vvp_vector4_t::copy_bits(const vvp_vector4_t&that)
 	   the bit values. */
       if (size_ <= BITS_PER_WORD && that.size_ <= BITS_PER_WORD) {
 	    unsigned bits_to_copy = (that.size_ < size_) ? that.size_ : size_;
-	    unsigned long mask = (1UL << bits_to_copy) - 1UL;
+	    unsigned long mask = (bits_to_copy < BITS_PER_WORD)
+		  ? (1UL << bits_to_copy) - 1UL : -1UL;
 	    abits_val_ &= ~mask;
 	    bbits_val_ &= ~mask;
 	    abits_val_ |= that.abits_val_&mask;
@@ -612,13 +887,12 @@ void vvp_vector4_t::copy_bits(const vvp_vector4_t&that)
 	   source is short, then mask/copy from its value. */
       if (that.size_ <= BITS_PER_WORD) {
 	    unsigned long mask;
-	    if (that.size_ < BITS_PER_WORD) {
+	    if (that.size_ < BITS_PER_WORD)
 		  mask = (1UL << that.size_) - 1UL;
-		  abits_ptr_[0] &= ~mask;
-		  bbits_ptr_[0] &= ~mask;
-	    } else {
+	    else
 		  mask = -1UL;
-	    }
+	    abits_ptr_[0] &= ~mask;
+	    bbits_ptr_[0] &= ~mask;
 	    abits_ptr_[0] |= that.abits_val_&mask;
 	    bbits_ptr_[0] |= that.bbits_val_&mask;
 	    return;
@@ -627,13 +901,10 @@ void vvp_vector4_t::copy_bits(const vvp_vector4_t&that)
 	/* Finally, we know that source and destination are long. copy
 	   words until we get to the last. */
       unsigned bits_to_copy = (that.size_ < size_) ? that.size_ : size_;
-      unsigned word = 0;
-      while (bits_to_copy >= BITS_PER_WORD) {
-	    abits_ptr_[word] = that.abits_ptr_[word];
-	    bbits_ptr_[word] = that.bbits_ptr_[word];
-	    bits_to_copy -= BITS_PER_WORD;
-	    word += 1;
-      }
+      unsigned word = bits_to_copy / BITS_PER_WORD;
+      copy_words_(abits_ptr_, that.abits_ptr_, word);
+      copy_words_(bbits_ptr_, that.bbits_ptr_, word);
+      bits_to_copy %= BITS_PER_WORD;
       if (bits_to_copy > 0) {
 	    unsigned long mask = (1UL << bits_to_copy) - 1UL;
 	    abits_ptr_[word] &= ~mask;
@@ -643,18 +914,40 @@ void vvp_vector4_t::copy_bits(const vvp_vector4_t&that)
       }
 }
 
+/*
+ * Vectors of two words are the common multi-word case, and the
+ * temporaries that carry them through the net are made and dropped
+ * all the time, so their arrays come from a slab. Wider vectors are
+ * rare enough that new[] is fine for them.
+ */
+static const unsigned VEC4_SLAB_WORDS = 2;
+static const size_t VEC4_WORDS_CHUNK_COUNT = 524288 / (2*VEC4_SLAB_WORDS*sizeof(unsigned long));
+static slab_t<2*VEC4_SLAB_WORDS*sizeof(unsigned long),VEC4_WORDS_CHUNK_COUNT> vec4_words_heap;
+
+unsigned long* vvp_vector4_t::new_words_(unsigned cnt)
+{
+      if (cnt <= VEC4_SLAB_WORDS)
+	    return static_cast<unsigned long*>(vec4_words_heap.alloc_slab());
+
+      return new unsigned long[2*cnt];
+}
+
+void vvp_vector4_t::delete_words_(unsigned long*words, unsigned cnt)
+{
+      if (cnt <= VEC4_SLAB_WORDS)
+	    vec4_words_heap.free_slab(words);
+      else
+	    delete[]words;
+}
+
 void vvp_vector4_t::copy_from_(const vvp_vector4_t&that)
 {
       size_ = that.size_;
       if (size_ > BITS_PER_WORD) {
 	    unsigned words = (size_+BITS_PER_WORD-1) / BITS_PER_WORD;
-	    abits_ptr_ = new unsigned long[2*words];
+	    abits_ptr_ = new_words_(words);
 	    bbits_ptr_ = abits_ptr_ + words;
-
-	    for (unsigned idx = 0 ;  idx < words ;  idx += 1)
-		  abits_ptr_[idx] = that.abits_ptr_[idx];
-	    for (unsigned idx = 0 ;  idx < words ;  idx += 1)
-		  bbits_ptr_[idx] = that.bbits_ptr_[idx];
+	    copy_words_(abits_ptr_, that.abits_ptr_, 2*words);
 
       } else {
 	    abits_val_ = that.abits_val_;
@@ -672,7 +965,7 @@ void vvp_vector4_t::copy_inverted_from_(const vvp_vector4_t&that)
       size_ = that.size_;
       if (size_ > BITS_PER_WORD) {
 	    unsigned words = (size_+BITS_PER_WORD-1) / BITS_PER_WORD;
-	    abits_ptr_ = new unsigned long[2*words];
+	    abits_ptr_ = new_words_(words);
 	    bbits_ptr_ = abits_ptr_ + words;
 
 	    unsigned remaining = size_;
@@ -702,7 +995,7 @@ void vvp_vector4_t::allocate_words_(unsigned long inita, unsigned long initb)
 {
       if (size_ > BITS_PER_WORD) {
 	    unsigned cnt = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
-	    abits_ptr_ = new unsigned long[2*cnt];
+	    abits_ptr_ = new_words_(cnt);
 	    bbits_ptr_ = abits_ptr_ + cnt;
 	    for (unsigned idx = 0 ;  idx < cnt ;  idx += 1)
 		  abits_ptr_[idx] = inita;
@@ -905,19 +1198,17 @@ void vvp_vector4_t::resize(unsigned newsize)
 		  return;
 	    }
 
-	    unsigned long*newbits = new unsigned long[2*newcnt];
+	    unsigned long*newbits = new_words_(newcnt);
 
 	    if (cnt > 1) {
 		  unsigned trans = cnt;
 		  if (trans > newcnt)
 			trans = newcnt;
 
-		  for (unsigned idx = 0 ;  idx < trans ;  idx += 1)
-			newbits[idx] = abits_ptr_[idx];
-		  for (unsigned idx = 0 ;  idx < trans ;  idx += 1)
-			newbits[newcnt+idx] = bbits_ptr_[idx];
+		  copy_words_(newbits, abits_ptr_, trans);
+		  copy_words_(newbits+newcnt, bbits_ptr_, trans);
 
-		  delete[]abits_ptr_;
+		  delete_words_(abits_ptr_, cnt);
 
 	    } else {
 		  newbits[0] = abits_val_;
@@ -937,7 +1228,7 @@ void vvp_vector4_t::resize(unsigned newsize)
 	    if (cnt > 1) {
 		  unsigned long newvala = abits_ptr_[0];
 		  unsigned long newvalb = bbits_ptr_[0];
-		  delete[]abits_ptr_;
+		  delete_words_();
 		  abits_val_ = newvala;
 		  bbits_val_ = newvalb;
 	    }
@@ -953,6 +1244,18 @@ unsigned long* vvp_vector4_t::subarray(unsigned adr, unsigned wid) const
       unsigned awid = (wid + BIT2_PER_WORD - 1) / (BIT2_PER_WORD);
       unsigned long*val = new unsigned long[awid];
 
+      if (subarray(adr, wid, val))
+	    return val;
+
+      delete[]val;
+      return 0;
+}
+
+bool vvp_vector4_t::subarray(unsigned adr, unsigned wid, unsigned long*val) const
+{
+      const unsigned BIT2_PER_WORD = 8*sizeof(unsigned long);
+      unsigned awid = (wid + BIT2_PER_WORD - 1) / (BIT2_PER_WORD);
+
       for (unsigned idx = 0 ;  idx < awid ;  idx += 1)
 	    val[idx] = 0;
 
@@ -968,7 +1271,7 @@ unsigned long* vvp_vector4_t::subarray(unsigned adr, unsigned wid) const
 		  atmp &= (1UL << wid) - 1;
 		  btmp &= (1UL << wid) - 1;
 	    }
-	    if (btmp) goto x_out;
+	    if (btmp) return false;
 
 	    val[0] = atmp;
 
@@ -995,7 +1298,7 @@ unsigned long* vvp_vector4_t::subarray(unsigned adr, unsigned wid) const
 			atmp &= (1UL << trans) - 1;
 			btmp &= (1UL << trans) - 1;
 		  }
-		  if (btmp) goto x_out;
+		  if (btmp) return false;
 
 		  val[val_ptr] |= atmp << val_off;
 		  adr += trans;
@@ -1008,11 +1311,20 @@ unsigned long* vvp_vector4_t::subarray(unsigned adr, unsigned wid) const
 	    }
       }
 
-      return val;
+      return true;
+}
 
- x_out:
-      delete[]val;
-      return 0;
+void vvp_vector4_t::get_words(unsigned long*abits, unsigned long*bbits) const
+{
+      if (size_ <= BITS_PER_WORD) {
+	    abits[0] = abits_val_;
+	    bbits[0] = bbits_val_;
+	    return;
+      }
+
+      unsigned cnt = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+      copy_words_(abits, abits_ptr_, cnt);
+      copy_words_(bbits, bbits_ptr_, cnt);
 }
 
 void vvp_vector4_t::setarray(unsigned adr, unsigned wid, const unsigned long*val)
@@ -1175,22 +1487,14 @@ bool vvp_vector4_t::set_vec(unsigned adr, const vvp_vector4_t&that)
 		 destination is neatly aligned. That means all but the
 		 last word can be simply copied with no masking. */
 
-	    unsigned remain = that.size_;
-	    unsigned sptr = 0;
+	    unsigned remain = that.size_ % BITS_PER_WORD;
+	    unsigned sptr = that.size_ / BITS_PER_WORD;
 	    unsigned dptr = adr / BITS_PER_WORD;
-	    while (remain >= BITS_PER_WORD) {
-		  if (abits_ptr_[dptr] != that.abits_ptr_[sptr]) {
-			diff_flag = true;
-			abits_ptr_[dptr] = that.abits_ptr_[sptr];
-		  }
-		  if (bbits_ptr_[dptr] != that.bbits_ptr_[sptr]) {
-			diff_flag = true;
-			bbits_ptr_[dptr] = that.bbits_ptr_[sptr];
-		  }
-		  dptr += 1;
-		  sptr += 1;
-		  remain -= BITS_PER_WORD;
-	    }
+	    if (words_update(abits_ptr_+dptr, that.abits_ptr_, sptr))
+		  diff_flag = true;
+	    if (words_update(bbits_ptr_+dptr, that.bbits_ptr_, sptr))
+		  diff_flag = true;
+	    dptr += sptr;
 
 	    if (remain > 0) {
 		  unsigned long mask = (1UL << remain) - 1;
@@ -1387,12 +1691,10 @@ bool vvp_vector4_t::eeq(const vvp_vector4_t&that) const
       }
 
       unsigned words = size_ / BITS_PER_WORD;
-      for (unsigned idx = 0 ;  idx < words ;  idx += 1) {
-	    if (abits_ptr_[idx] != that.abits_ptr_[idx])
-		  return false;
-	    if (bbits_ptr_[idx] != that.bbits_ptr_[idx])
-		  return false;
-      }
+      if (! words_eq(abits_ptr_, that.abits_ptr_, words))
+	    return false;
+      if (! words_eq(bbits_ptr_, that.bbits_ptr_, words))
+	    return false;
 
       unsigned long mask = size_%BITS_PER_WORD;
       if (mask > 0) {
@@ -1450,10 +1752,8 @@ bool vvp_vector4_t::has_xz() const
       }
 
       unsigned words = size_ / BITS_PER_WORD;
-      for (unsigned idx = 0 ; idx < words ; idx += 1) {
-	    if (bbits_ptr_[idx])
-		  return true;
-      }
+      if (words_any(bbits_ptr_, words))
+	    return true;
 
       unsigned long mask = size_%BITS_PER_WORD;
       if (mask > 0) {
@@ -1532,14 +1832,9 @@ void vvp_vector4_t::invert()
 	    abits_val_ = mask & ~abits_val_;
 	    abits_val_ |= bbits_val_;
       } else {
-	    unsigned remaining = size_;
-	    unsigned idx = 0;
-	    while (remaining >= BITS_PER_WORD) {
-		  abits_ptr_[idx] = ~abits_ptr_[idx];
-		  abits_ptr_[idx] |= bbits_ptr_[idx];
-		  idx += 1;
-		  remaining -= BITS_PER_WORD;
-	    }
+	    unsigned idx = size_ / BITS_PER_WORD;
+	    unsigned remaining = size_ % BITS_PER_WORD;
+	    words_invert(abits_ptr_, bbits_ptr_, idx);
 	    if (remaining > 0) {
 		  unsigned long mask = (1UL<<remaining) - 1UL;
 		  abits_ptr_[idx] = mask & ~abits_ptr_[idx];
@@ -1563,14 +1858,8 @@ vvp_vector4_t& vvp_vector4_t::operator &= (const vvp_vector4_t&that)
 	    bbits_val_ = (tmp1 & that.bbits_val_) | (tmp2 & bbits_val_);
       } else {
 	    unsigned words = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
-	    for (unsigned idx = 0; idx < words ; idx += 1) {
-		  unsigned long tmp1 = abits_ptr_[idx] | bbits_ptr_[idx];
-		  unsigned long tmp2 = that.abits_ptr_[idx] |
-		                       that.bbits_ptr_[idx];
-		  abits_ptr_[idx] = tmp1 & tmp2;
-		  bbits_ptr_[idx] = (tmp1 & that.bbits_ptr_[idx]) |
-		                    (tmp2 & bbits_ptr_[idx]);
-	    }
+	    words_and4(abits_ptr_, bbits_ptr_,
+		       that.abits_ptr_, that.bbits_ptr_, words);
       }
 
       return *this;
@@ -1593,15 +1882,26 @@ vvp_vector4_t& vvp_vector4_t::operator |= (const vvp_vector4_t&that)
 
       } else {
 	    unsigned words = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
-	    for (unsigned idx = 0; idx < words ; idx += 1) {
-		  unsigned long tmp = abits_ptr_[idx] | bbits_ptr_[idx] |
-	                        that.abits_ptr_[idx] | that.bbits_ptr_[idx];
-		  bbits_ptr_[idx] = ((~abits_ptr_[idx] | bbits_ptr_[idx]) &
-		                     that.bbits_ptr_[idx]) |
-		                    ((~that.abits_ptr_[idx] |
-		                      that.bbits_ptr_[idx]) & bbits_ptr_[idx]);
-		  abits_ptr_[idx] = tmp;
-	    }
+	    words_or4(abits_ptr_, bbits_ptr_,
+		      that.abits_ptr_, that.bbits_ptr_, words);
+      }
+
+      return *this;
+}
+
+vvp_vector4_t& vvp_vector4_t::operator ^= (const vvp_vector4_t&that)
+{
+	// The result is X where either bit is X or Z, and the
+	// exclusive or of the abits everywhere else.
+      if (size_ <= BITS_PER_WORD) {
+	    unsigned long tmp = bbits_val_ | that.bbits_val_;
+	    abits_val_ = (abits_val_ ^ that.abits_val_) | tmp;
+	    bbits_val_ = tmp;
+
+      } else {
+	    unsigned words = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	    words_xor4(abits_ptr_, bbits_ptr_,
+		       that.abits_ptr_, that.bbits_ptr_, words);
       }
 
       return *this;
@@ -1904,6 +2204,60 @@ vvp_vector4_t vvp_vector4array_sa::get_word(unsigned index) const
       return get_word_(cell);
 }
 
+void vvp_vector4array_sa::set_word_bits(unsigned index,
+					const unsigned long*abits,
+					const unsigned long*bbits)
+{
+      assert(index < words_);
+
+      v4cell*cell = &array_[index];
+
+      if (width_ <= vvp_vector4_t::BITS_PER_WORD) {
+	    cell->abits_val_ = abits[0];
+	    cell->bbits_val_ = bbits[0];
+	    return;
+      }
+
+      unsigned cnt = (width_ + vvp_vector4_t::BITS_PER_WORD-1)/vvp_vector4_t::BITS_PER_WORD;
+
+      if (cell->abits_ptr_ == 0) {
+	    cell->abits_ptr_ = new unsigned long[2*cnt];
+	    cell->bbits_ptr_ = cell->abits_ptr_ + cnt;
+      }
+
+      memcpy(cell->abits_ptr_, abits, cnt*sizeof(unsigned long));
+      memcpy(cell->bbits_ptr_, bbits, cnt*sizeof(unsigned long));
+}
+
+void vvp_vector4array_sa::get_word_bits(unsigned index,
+					unsigned long*abits,
+					unsigned long*bbits) const
+{
+      assert(index < words_);
+
+      v4cell*cell = &array_[index];
+
+      if (width_ <= vvp_vector4_t::BITS_PER_WORD) {
+	    abits[0] = cell->abits_val_;
+	    bbits[0] = cell->bbits_val_;
+	    return;
+      }
+
+      unsigned cnt = (width_ + vvp_vector4_t::BITS_PER_WORD-1)/vvp_vector4_t::BITS_PER_WORD;
+
+	// A word that was never written is still all X.
+      if (cell->abits_ptr_ == 0) {
+	    for (unsigned idx = 0 ; idx < cnt ; idx += 1) {
+		  abits[idx] = vvp_vector4_t::WORD_X_ABITS;
+		  bbits[idx] = vvp_vector4_t::WORD_X_BBITS;
+	    }
+	    return;
+      }
+
+      memcpy(abits, cell->abits_ptr_, cnt*sizeof(unsigned long));
+      memcpy(bbits, cell->bbits_ptr_, cnt*sizeof(unsigned long));
+}
+
 vvp_vector4array_aa::vvp_vector4array_aa(unsigned width__, unsigned words__)
 : vvp_vector4array_t(width__, words__)
 {
@@ -62,17 +62,20 @@ class  vvp_delay_t;
 
 /*
  * Storage for items declared in automatically allocated scopes (i.e. automatic
- * tasks and functions). The first two slots in each context are reserved for
- * linking to other contexts. The function that adds items to a context knows
- * this, and allocates context indices accordingly.
+ * tasks and functions). The first VVP_CONTEXT_LINKS slots in each context are
+ * reserved for linking to other contexts. The function that adds items to a
+ * context knows this, and allocates context indices accordingly. The prev
+ * link lets a live context be unlinked from its scope without a search.
  */
 typedef void**vvp_context_t;
 
 typedef void*vvp_context_item_t;
 
+# define VVP_CONTEXT_LINKS 3
+
 inline vvp_context_t vvp_allocate_context(unsigned nitem)
 {
-      return (vvp_context_t)malloc((2 + nitem) * sizeof(void*));
+      return (vvp_context_t)malloc((VVP_CONTEXT_LINKS + nitem) * sizeof(void*));
 }
 
 inline vvp_context_t vvp_get_next_context(vvp_context_t context)
@@ -95,6 +98,16 @@ inline void vvp_set_stacked_context(vvp_context_t context, vvp_context_t stack)
       context[1] = stack;
 }
 
+inline vvp_context_t vvp_get_prev_context(vvp_context_t context)
+{
+      return (vvp_context_t)context[2];
+}
+
+inline void vvp_set_prev_context(vvp_context_t context, vvp_context_t prev)
+{
+      context[2] = prev;
+}
+
 inline vvp_context_item_t vvp_get_context_item(vvp_context_t context,
                                                unsigned item_idx)
 {
@@ -251,7 +264,14 @@ class vvp_vector4_t {
 	// array of longs, or a nil pointer if an XZ bit was detected
 	// in the array.
       unsigned long*subarray(unsigned idx, unsigned size) const;
+	// The same, but write the words into the val array, which must
+	// be large enough, and return false if an XZ bit was detected.
+      bool subarray(unsigned idx, unsigned size, unsigned long*val) const;
       void setarray(unsigned idx, unsigned size, const unsigned long*val);
+	// Copy out the a and b bit words. The pairs 00, 10, 11 and 01
+	// are 0, 1, X and Z, as in vpiVectorVal. Each array must hold
+	// one unsigned long for each 8*sizeof(unsigned long) bits.
+      void get_words(unsigned long*abits, unsigned long*bbits) const;
 
 	// Set a 4-value bit or subvector into the vector. Return true
 	// if any bits of the vector change as a result of this operation.
@@ -285,6 +305,7 @@ class vvp_vector4_t {
       void invert();
       vvp_vector4_t& operator &= (const vvp_vector4_t&that);
       vvp_vector4_t& operator |= (const vvp_vector4_t&that);
+      vvp_vector4_t& operator ^= (const vvp_vector4_t&that);
       vvp_vector4_t& operator += (int64_t);
 
     private:
@@ -317,6 +338,15 @@ class vvp_vector4_t {
 
       void allocate_words_(unsigned long inita, unsigned long initb);
 
+	// The abits and bbits of a vector wider than a word are in
+	// one array, with the bbits in the upper half. These get and
+	// release such an array for cnt words.
+      static unsigned long*new_words_(unsigned cnt);
+      static void delete_words_(unsigned long*words, unsigned cnt);
+      void delete_words_();
+      static void copy_words_(unsigned long*dst, const unsigned long*src,
+			      unsigned cnt);
+
 	// Values in the vvp_vector4_t are stored split across two
 	// arrays. For each bit in the vector, there is an abit and a
 	// bbit. the encoding of a vvp_vector4_t is:
@@ -339,6 +369,21 @@ class vvp_vector4_t {
       };
 };
 
+inline void vvp_vector4_t::delete_words_()
+{
+	// bbits_ptr_ actually points half-way into a double-length
+	// array started at abits_ptr_, so there is only one array.
+      if (size_ > BITS_PER_WORD)
+	    delete_words_(abits_ptr_, (size_+BITS_PER_WORD-1) / BITS_PER_WORD);
+}
+
+inline void vvp_vector4_t::copy_words_(unsigned long*dst,
+				       const unsigned long*src, unsigned cnt)
+{
+      for (unsigned idx = 0 ;  idx < cnt ;  idx += 1)
+	    dst[idx] = src[idx];
+}
+
 inline vvp_vector4_t::vvp_vector4_t(const vvp_vector4_t&that)
 {
       copy_from_(that);
@@ -372,11 +417,7 @@ inline vvp_vector4_t::vvp_vector4_t(unsigned size__, vvp_bit4_t val)
 
 inline vvp_vector4_t::~vvp_vector4_t()
 {
-      if (size_ > BITS_PER_WORD) {
-	    delete[] abits_ptr_;
-	      // bbits_ptr_ actually points half-way into a
-	      // double-length array started at abits_ptr_
-      }
+      delete_words_();
 }
 
 inline vvp_vector4_t& vvp_vector4_t::operator= (const vvp_vector4_t&that)
@@ -384,9 +425,19 @@ inline vvp_vector4_t& vvp_vector4_t::operator= (const vvp_vector4_t&that)
       if (this == &that)
 	    return *this;
 
-      if (size_ > BITS_PER_WORD)
-	    delete[] abits_ptr_;
+	// If the word counts match, then the existing words can be
+	// reused and there is no need to allocate anything.
+      if (size_ > BITS_PER_WORD && that.size_ > BITS_PER_WORD) {
+	    unsigned cnt = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	    if (cnt == (that.size_ + BITS_PER_WORD - 1) / BITS_PER_WORD) {
+		  size_ = that.size_;
+		  copy_words_(abits_ptr_, that.abits_ptr_, cnt);
+		  copy_words_(bbits_ptr_, that.bbits_ptr_, cnt);
+		  return *this;
+	    }
+      }
 
+      delete_words_();
       copy_from_(that);
 
       return *this;
@@ -573,6 +624,14 @@ class vvp_vector4array_sa : public vvp_vector4array_t {
       vvp_vector4_t get_word(unsigned idx) const;
       void set_word(unsigned idx, const vvp_vector4_t&that);
 
+	// Get/set a word as raw abits/bbits words, as many as it takes
+	// to hold width() bits. This is for bulk loads and dumps
+	// that already have the bits, and skips the vvp_vector4_t.
+      void get_word_bits(unsigned idx, unsigned long*abits,
+			 unsigned long*bbits) const;
+      void set_word_bits(unsigned idx, const unsigned long*abits,
+			 const unsigned long*bbits);
+
     private:
       v4cell* array_;
 };
@@ -994,6 +1053,8 @@ template <class T> class vvp_sub_pointer_t {
     public:
       vvp_sub_pointer_t() : bits_(0) { }
 
+      explicit vvp_sub_pointer_t(unsigned long bits__) : bits_(bits__) { }
+
       vvp_sub_pointer_t(T*ptr__, unsigned port__)
       {
 	    bits_ = reinterpret_cast<unsigned long> (ptr__);
@@ -1014,6 +1075,10 @@ template <class T> class vvp_sub_pointer_t {
 
       bool nil() const { return bits_ == 0; }
 
+	// The encoded bits, for containers that pack these with
+	// other tagged values.
+      unsigned long bits() const { return bits_; }
+
       bool operator == (vvp_sub_pointer_t that) const { return bits_ == that.bits_; }
       bool operator != (vvp_sub_pointer_t that) const { return bits_ != that.bits_; }
 
@@ -1027,41 +1092,43 @@ template <class T> ostream& operator << (ostream&out, vvp_sub_pointer_t<T> val)
 
 /*
  * This is the basic unit of netlist connectivity. It is a fan-in of
- * up to 4 inputs, and output pointer, and a pointer to the node's
+ * up to 4 inputs, an output, and a pointer to the node's
  * functionality.
  *
- * A net output that is non-nil points to the input of one of its
- * destination nets. If there are multiple destinations, then the
- * referenced input port points to the next input. For example:
+ * The inputs of a vvp_net_t are not stored in the vvp_net_t. They are
+ * addressed by vvp_net_ptr_t values, which are the vvp_net_t pointer
+ * with the port number (0-3) in the low bits. The output of a net
+ * holds the vvp_net_ptr_t of every input that it drives:
+ *
+ *   +-----+---+
+ *   | fun | . |  The output of this vvp_net_t is...
+ *   +-----+-|-+
+ *           |
+ *           v
+ *   +--------+--------+--------+-----
+ *   | net[3] | net[2] | net[0] | ...  ... an array of the inputs
+ *   +--------+--------+--------+-----    that it drives.
+ *
+ * If there is only one receiver, it is kept in the output itself and
+ * there is no array. The receivers are kept in the order that they
+ * were linked, and the output is delivered in the reverse order, from
+ * the last one linked to the first.
  *
- *   +--+--+--+--+---+
- *   |  |  |  |  | . |  Output from this vvp_net_t points to...
- *   +--+--+--+--+-|-+
- *                 |
- *                /
- *               /
- *              /
- *             |
- *             v
- *   +--+--+--+--+---+
- *   |  |  |  |  | . |  ... the fourth input of this vvp_net_t, and...
- *   +--+--+--+--+-|-+
- *             |   |
- *            /    .
- *           /     .
- *          |      .
- *          v
- *   +--+--+--+--+---+
- *   |  |  |  |  | . |  ... the third input of this vvp_net_t.
- *   +--+--+--+--+-|-+
+ * While the design is being compiled, each array is allocated by
+ * itself so that it can grow. Once the design is linked,
+ * compact_fanout() moves all the arrays into one block, in the order
+ * that the nets were allocated, which is the order of the scopes in
+ * the input file. The link() and unlink() methods still work after
+ * that. A link that does not fit moves the array of that net out of
+ * the block again.
  *
  * Thus, the fan-in of a vvp_net_t node is limited to 4 inputs, but
  * the fan-out is unlimited.
  *
- * The vvp_send_*() functions take as input a vvp_net_ptr_t and follow
- * all the fan-out chain, delivering the specified value. The send_*()
- * methods of the vvp_net_t class are similar, but they follow the
- * output, possibly filtered, from the vvp_net_t.
+ * The vvp_send_*() functions take as input a vvp_net_ptr_t and
+ * deliver the specified value to that one input. The send_*() methods
+ * of the vvp_net_t class deliver the output, possibly filtered, from
+ * the vvp_net_t to all of its receivers.
  */
 class vvp_net_t {
     public:
@@ -1070,7 +1137,6 @@ class vvp_net_t {
 #ifdef CHECK_WITH_VALGRIND
       vvp_net_t *pool;
 #endif
-      vvp_net_ptr_t port[4];
       vvp_net_fun_t*fun;
       vvp_net_fil_t*fil;
 
@@ -1079,6 +1145,17 @@ class vvp_net_t {
       void link(vvp_net_ptr_t port);
 	// Disconnect the port from the output of this net.
       void unlink(vvp_net_ptr_t port);
+	// The receivers of the output from this net, in the order
+	// that they were linked.
+      unsigned fanout_size(void) const;
+      vvp_net_ptr_t fanout(unsigned idx) const;
+
+	// Move the fan-out arrays of all the nets into one block. This
+	// is called once, after the design is linked.
+      static void compact_fanout(void);
+#ifdef CHECK_WITH_VALGRIND
+      static void delete_fanout(void);
+#endif
 
     public: // Methods to propagate output from this node.
       void send_vec4(const vvp_vector4_t&val, vvp_context_t context);
@@ -1109,7 +1186,36 @@ class vvp_net_t {
       void count_drivers(unsigned idx, unsigned counts[4]);
 
     private:
-      vvp_net_ptr_t out_;
+      void send_vec4_out_(const vvp_vector4_t&val, vvp_context_t context);
+      void send_vec4_pv_out_(const vvp_vector4_t&val,
+			     unsigned base, unsigned wid, unsigned vwid,
+			     vvp_context_t context);
+      void send_vec8_out_(const vvp_vector8_t&val);
+      void send_vec8_pv_out_(const vvp_vector8_t&val,
+			     unsigned base, unsigned wid, unsigned vwid);
+
+    private:
+      struct fanout_s {
+	    unsigned count;
+	    unsigned alloc;
+	    vvp_net_ptr_t list[1];
+      };
+	// This bit of out_ is set if it points to a fanout_s. The
+	// vvp_net_t objects are 8-byte aligned, so the bit is never
+	// set in a vvp_net_ptr_t.
+      static const unsigned long FANOUT_LIST = 4;
+
+      static size_t fanout_bytes_(unsigned cnt);
+      fanout_s* fanout_list_(void) const
+      { return reinterpret_cast<fanout_s*> (out_ & ~FANOUT_LIST); }
+
+	// The output of this net. It is nil or the vvp_net_ptr_t of the
+	// only receiver, or it has the FANOUT_LIST bit set and points
+	// to the array of receivers.
+      unsigned long out_;
+#if SIZEOF_UNSIGNED_LONG < 8 && !defined(CHECK_WITH_VALGRIND)
+      unsigned long pad_;
+#endif
 
     public: // Need a better new for these objects.
       static void* operator new(std::size_t size);
@@ -1119,6 +1225,21 @@ class vvp_net_t {
       static void operator delete[](void*);
 };
 
+inline unsigned vvp_net_t::fanout_size(void) const
+{
+      if (out_ & FANOUT_LIST)
+	    return fanout_list_()->count;
+      return out_ != 0;
+}
+
+inline vvp_net_ptr_t vvp_net_t::fanout(unsigned idx) const
+{
+      if (out_ & FANOUT_LIST)
+	    return fanout_list_()->list[idx];
+      assert(idx == 0 && out_ != 0);
+      return vvp_net_ptr_t(out_);
+}
+
 /*
  * Instances of this class represent the functionality of a
  * node. vvp_net_t objects hold pointers to the vvp_net_fun_t
@@ -1367,20 +1488,25 @@ class vvp_fun_concat8  : public vvp_net_fun_t {
  * to force the associated filter. They do not actually  have an
  * output, they instead drive the force_* methods of the net filter.
  *
- * This functor is also special in that we know a priori that only
- * port-0 is used, so we can use ports 1-3 for local storage. See the
- * implementation of vvp_filter_wire_base::force_link in
- * vvp_net_sig.cc for details.
+ * The functor holds the net whose filter it forces, and the net that
+ * drives its input, if any, so that the link can be undone. See the
+ * implementation of vvp_net_fil_t::force_link in vvp_net.cc for
+ * details.
  */
 class vvp_fun_force : public vvp_net_fun_t {
 
     public:
-      vvp_fun_force();
+      explicit vvp_fun_force(vvp_net_t*dst);
       ~vvp_fun_force();
 
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 		     vvp_context_t context);
       void recv_real(vvp_net_ptr_t port, double bit, vvp_context_t);
+
+    private:
+      friend class vvp_net_fil_t;
+      vvp_net_t*dst_;
+      vvp_net_t*src_;
 };
 
 /* vvp_fun_repeat
@@ -1533,14 +1659,9 @@ class vvp_wide_fun_t : public vvp_net_fun_t {
 
 inline void vvp_send_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&val, vvp_context_t context)
 {
-      while (class vvp_net_t*cur = ptr.ptr()) {
-	    vvp_net_ptr_t next = cur->port[ptr.port()];
-
-	    if (cur->fun)
-		  cur->fun->recv_vec4(ptr, val, context);
-
-	    ptr = next;
-      }
+      vvp_net_t*cur = ptr.ptr();
+      if (cur && cur->fun)
+	    cur->fun->recv_vec4(ptr, val, context);
 }
 
 extern void vvp_send_vec8(vvp_net_ptr_t ptr, const vvp_vector8_t&val);
@@ -1552,26 +1673,16 @@ extern void vvp_send_long_pv(vvp_net_ptr_t ptr, long val,
 
 inline void vvp_send_string(vvp_net_ptr_t ptr, const std::string&val, vvp_context_t context)
 {
-      while (vvp_net_t*cur = ptr.ptr()) {
-	    vvp_net_ptr_t next = cur->port[ptr.port()];
-
-	    if (cur->fun)
-		  cur->fun->recv_string(ptr, val, context);
-
-	    ptr = next;
-      }
+      vvp_net_t*cur = ptr.ptr();
+      if (cur && cur->fun)
+	    cur->fun->recv_string(ptr, val, context);
 }
 
 inline void vvp_send_object(vvp_net_ptr_t ptr, vvp_object_t val, vvp_context_t context)
 {
-      while (vvp_net_t*cur = ptr.ptr()) {
-	    vvp_net_ptr_t next = cur->port[ptr.port()];
-
-	    if (cur->fun)
-		  cur->fun->recv_object(ptr, val, context);
-
-	    ptr = next;
-      }
+      vvp_net_t*cur = ptr.ptr();
+      if (cur && cur->fun)
+	    cur->fun->recv_object(ptr, val, context);
 }
 
 /*
@@ -1597,33 +1708,63 @@ inline void vvp_send_vec4_pv(vvp_net_ptr_t ptr, const vvp_vector4_t&val,
 			     unsigned base, unsigned wid, unsigned vwid,
 			     vvp_context_t context)
 {
-      while (class vvp_net_t*cur = ptr.ptr()) {
-	    vvp_net_ptr_t next = cur->port[ptr.port()];
+      vvp_net_t*cur = ptr.ptr();
+      if (cur && cur->fun)
+	    cur->fun->recv_vec4_pv(ptr, val, base, wid, vwid, context);
+}
 
-	    if (cur->fun)
-		  cur->fun->recv_vec4_pv(ptr, val, base, wid, vwid, context);
+inline void vvp_send_vec8_pv(vvp_net_ptr_t ptr, const vvp_vector8_t&val,
+			     unsigned base, unsigned wid, unsigned vwid)
+{
+      vvp_net_t*cur = ptr.ptr();
+      if (cur && cur->fun)
+	    cur->fun->recv_vec8_pv(ptr, val, base, wid, vwid);
+}
 
-	    ptr = next;
+/*
+ * These deliver a value to all the receivers of the output of the
+ * net, starting with the last one linked. The array is looked up
+ * again for each receiver, so that a receiver that links the net to
+ * something else does not leave the loop with a stale array.
+ */
+inline void vvp_net_t::send_vec4_out_(const vvp_vector4_t&val,
+				      vvp_context_t context)
+{
+      if (! (out_ & FANOUT_LIST)) {
+	    vvp_send_vec4(vvp_net_ptr_t(out_), val, context);
+	    return;
       }
+
+      for (unsigned idx = fanout_list_()->count ; idx > 0 ; idx -= 1)
+	    vvp_send_vec4(fanout_list_()->list[idx-1], val, context);
 }
 
-inline void vvp_send_vec8_pv(vvp_net_ptr_t ptr, const vvp_vector8_t&val,
-			     unsigned base, unsigned wid, unsigned vwid)
+inline void vvp_net_t::send_vec4_pv_out_(const vvp_vector4_t&val,
+					 unsigned base, unsigned wid,
+					 unsigned vwid, vvp_context_t context)
 {
-      while (class vvp_net_t*cur = ptr.ptr()) {
-	    vvp_net_ptr_t next = cur->port[ptr.port()];
+      for (unsigned idx = fanout_size() ; idx > 0 ; idx -= 1)
+	    vvp_send_vec4_pv(fanout(idx-1), val, base, wid, vwid, context);
+}
 
-	    if (cur->fun)
-		  cur->fun->recv_vec8_pv(ptr, val, base, wid, vwid);
+inline void vvp_net_t::send_vec8_out_(const vvp_vector8_t&val)
+{
+      for (unsigned idx = fanout_size() ; idx > 0 ; idx -= 1)
+	    vvp_send_vec8(fanout(idx-1), val);
+}
 
-	    ptr = next;
-      }
+inline void vvp_net_t::send_vec8_pv_out_(const vvp_vector8_t&val,
+					 unsigned base, unsigned wid,
+					 unsigned vwid)
+{
+      for (unsigned idx = fanout_size() ; idx > 0 ; idx -= 1)
+	    vvp_send_vec8_pv(fanout(idx-1), val, base, wid, vwid);
 }
 
 inline void vvp_net_t::send_vec4(const vvp_vector4_t&val, vvp_context_t context)
 {
       if (fil == 0) {
-	    vvp_send_vec4(out_, val, context);
+	    send_vec4_out_(val, context);
 	    return;
       }
 
@@ -1632,10 +1773,10 @@ inline void vvp_net_t::send_vec4(const vvp_vector4_t&val, vvp_context_t context)
 	  case vvp_net_fil_t::STOP:
 	    break;
 	  case vvp_net_fil_t::PROP:
-	    vvp_send_vec4(out_, val, context);
+	    send_vec4_out_(val, context);
 	    break;
 	  case vvp_net_fil_t::REPL:
-	    vvp_send_vec4(out_, rep, context);
+	    send_vec4_out_(rep, context);
 	    break;
       }
 }
@@ -1645,7 +1786,7 @@ inline void vvp_net_t::send_vec4_pv(const vvp_vector4_t&val,
 				    vvp_context_t context)
 {
       if (fil == 0) {
-	    vvp_send_vec4_pv(out_, val, base, wid, vwid, context);
+	    send_vec4_pv_out_(val, base, wid, vwid, context);
 	    return;
       }
 
@@ -1655,10 +1796,10 @@ inline void vvp_net_t::send_vec4_pv(const vvp_vector4_t&val,
 	  case vvp_net_fil_t::STOP:
 	    break;
 	  case vvp_net_fil_t::PROP:
-	    vvp_send_vec4_pv(out_, val, base, wid, vwid, context);
+	    send_vec4_pv_out_(val, base, wid, vwid, context);
 	    break;
 	  case vvp_net_fil_t::REPL:
-	    vvp_send_vec4_pv(out_, rep, base, wid, vwid, context);
+	    send_vec4_pv_out_(rep, base, wid, vwid, context);
 	    break;
       }
 }
@@ -1666,7 +1807,7 @@ inline void vvp_net_t::send_vec4_pv(const vvp_vector4_t&val,
 inline void vvp_net_t::send_vec8(const vvp_vector8_t&val)
 {
       if (fil == 0) {
-	    vvp_send_vec8(out_, val);
+	    send_vec8_out_(val);
 	    return;
       }
 
@@ -1675,10 +1816,10 @@ inline void vvp_net_t::send_vec8(const vvp_vector8_t&val)
 	  case vvp_net_fil_t::STOP:
 	    break;
 	  case vvp_net_fil_t::PROP:
-	    vvp_send_vec8(out_, val);
+	    send_vec8_out_(val);
 	    break;
 	  case vvp_net_fil_t::REPL:
-	    vvp_send_vec8(out_, rep);
+	    send_vec8_out_(rep);
 	    break;
       }
 }
@@ -1687,7 +1828,7 @@ inline void vvp_net_t::send_vec8_pv(const vvp_vector8_t&val,
 				    unsigned base, unsigned wid, unsigned vwid)
 {
       if (fil == 0) {
-	    vvp_send_vec8_pv(out_, val, base, wid, vwid);
+	    send_vec8_pv_out_(val, base, wid, vwid);
 	    return;
       }
 
@@ -1697,10 +1838,10 @@ inline void vvp_net_t::send_vec8_pv(const vvp_vector8_t&val,
 	  case vvp_net_fil_t::STOP:
 	    break;
 	  case vvp_net_fil_t::PROP:
-	    vvp_send_vec8_pv(out_, val, base, wid, vwid);
+	    send_vec8_pv_out_(val, base, wid, vwid);
 	    break;
 	  case vvp_net_fil_t::REPL:
-	    vvp_send_vec8_pv(out_, rep, base, wid, vwid);
+	    send_vec8_pv_out_(rep, base, wid, vwid);
 	    break;
       }
 }
@@ -1710,7 +1851,8 @@ inline void vvp_net_t::send_real(double val, vvp_context_t context)
       if (fil && ! fil->filter_real(val))
 	    return;
 
-      vvp_send_real(out_, val, context);
+      for (unsigned idx = fanout_size() ; idx > 0 ; idx -= 1)
+	    vvp_send_real(fanout(idx-1), val, context);
 }
 
 
@@ -1719,7 +1861,8 @@ inline void vvp_net_t::send_string(const std::string&val, vvp_context_t context)
       if (fil && !fil->filter_string(val))
 	    return;
 
-      vvp_send_string(out_, val, context);
+      for (unsigned idx = fanout_size() ; idx > 0 ; idx -= 1)
+	    vvp_send_string(fanout(idx-1), val, context);
 }
 
 
@@ -1728,7 +1871,8 @@ inline void vvp_net_t::send_object(vvp_object_t val, vvp_context_t context)
       if (fil && ! fil->filter_object(val))
 	    return;
 
-      vvp_send_object(out_, val, context);
+      for (unsigned idx = fanout_size() ; idx > 0 ; idx -= 1)
+	    vvp_send_object(fanout(idx-1), val, context);
 }
 
 
@@ -122,7 +122,7 @@ void vvp_net_t::force_vec4(const vvp_vector4_t&val, vvp_vector2_t mask)
       assert(fil);
       fil->force_fil_vec4(val, mask);
       fun->force_flag();
-      vvp_send_vec4(out_, val, 0);
+      send_vec4_out_(val, 0);
 }
 
 void vvp_net_t::force_vec8(const vvp_vector8_t&val, vvp_vector2_t mask)
@@ -130,7 +130,7 @@ void vvp_net_t::force_vec8(const vvp_vector8_t&val, vvp_vector2_t mask)
       assert(fil);
       fil->force_fil_vec8(val, mask);
       fun->force_flag();
-      vvp_send_vec8(out_, val);
+      send_vec8_out_(val);
 }
 
 void vvp_net_t::force_real(double val, vvp_vector2_t mask)
@@ -138,7 +138,8 @@ void vvp_net_t::force_real(double val, vvp_vector2_t mask)
       assert(fil);
       fil->force_fil_real(val, mask);
       fun->force_flag();
-      vvp_send_real(out_, val, 0);
+      for (unsigned idx = fanout_size() ; idx > 0 ; idx -= 1)
+	    vvp_send_real(fanout(idx-1), val, 0);
 }
 
 /* **** vvp_fun_signal methods **** */
@@ -822,7 +823,8 @@ void vvp_fun_signal_object_aa::operator delete(void*)
 
   /* **** */
 
-vvp_fun_force::vvp_fun_force()
+vvp_fun_force::vvp_fun_force(vvp_net_t*dst)
+: dst_(dst), src_(0)
 {
 }
 
@@ -834,9 +836,7 @@ void vvp_fun_force::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 			      vvp_context_t)
 {
       assert(ptr.port() == 0);
-      vvp_net_t*net = ptr.ptr();
-
-      vvp_net_t*dst = net->port[3].ptr();
+      vvp_net_t*dst = dst_;
       assert(dst->fil);
 
       dst->force_vec4(coerce_to_width(bit, dst->fil->filter_size()), vvp_vector2_t(vvp_vector2_t::FILL1, dst->fil->filter_size()));
@@ -845,8 +845,7 @@ void vvp_fun_force::recv_vec4(vvp_net_ptr_t ptr, const vvp_vector4_t&bit,
 void vvp_fun_force::recv_real(vvp_net_ptr_t ptr, double bit, vvp_context_t)
 {
       assert(ptr.port() == 0);
-      vvp_net_t*net = ptr.ptr();
-      vvp_net_t*dst = net->port[3].ptr();
+      vvp_net_t*dst = dst_;
       dst->force_real(bit, vvp_vector2_t(vvp_vector2_t::FILL1, 1));
 }
 
@@ -41,6 +41,11 @@ class vvp_vpi_callback {
       void attach_as_word(struct __vpiArray* arr, unsigned long addr);
 
       void add_vpi_callback(value_callback*);
+
+	// Attach the slot of the value-change recorder, or get the
+	// slot that is attached (or 0). (See vpip_record_signal.)
+      void attach_recorder(unsigned slot);
+      unsigned recorder_slot(void) const { return record_slot_; }
 #ifdef CHECK_WITH_VALGRIND
 	/* This has only been tested at EOS. */
       void clear_all_callbacks(void);
@@ -59,6 +64,8 @@ class vvp_vpi_callback {
       value_callback*vpi_callbacks_;
       struct __vpiArray* array_;
       unsigned long array_word_;
+	// One more than the index of the recorder slot, or 0.
+      unsigned record_slot_;
 };
 
 